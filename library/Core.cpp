@@ -1640,6 +1640,11 @@ int Core::Update()
 extern bool buildings_do_onupdate;
 void buildings_onStateChange(color_ostream &out, state_change_event event);
 void buildings_onUpdate(color_ostream &out);
+void maps_onStateChange(color_ostream &out, state_change_event event);
+void maps_onUpdate(color_ostream &out);
+void raws_onStateChange(color_ostream &out, state_change_event event);
+void translation_onStateChange(color_ostream &out, state_change_event event);
+void world_onStateChange(color_ostream &out, state_change_event event);
 
 static int buildings_timer = 0;
 
@@ -1655,6 +1660,9 @@ void Core::onUpdate(color_ostream &out)
     if (buildings_do_onupdate && (++buildings_timer & 1))
         buildings_onUpdate(out);
 
+    // detect map changes before the plugins look for them
+    maps_onUpdate(out);
+
     // notify all the plugins that a game tick is finished
     step_start_ms = p->getTickCount();
     plug_mgr->OnUpdate(out);
@@ -1882,6 +1890,14 @@ void Core::onStateChange(color_ostream &out, state_change_event event)
 
     buildings_onStateChange(out, event);
 
+    maps_onStateChange(out, event);
+
+    raws_onStateChange(out, event);
+
+    translation_onStateChange(out, event);
+
+    world_onStateChange(out, event);
+
     plug_mgr->OnStateChange(out, event);
 
     Lua::Core::onStateChange(out, event);
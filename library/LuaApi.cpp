@@ -56,6 +56,7 @@ distribution.
 #include "modules/Materials.h"
 #include "modules/Military.h"
 #include "modules/Random.h"
+#include "modules/Raws.h"
 #include "modules/Screen.h"
 #include "modules/Textures.h"
 #include "modules/Translation.h"
@@ -2428,6 +2429,25 @@ static int units_getReadablename(lua_State *L) {
     return 1;
 }
 
+static int units_getReadableNames(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    bool skip_english = lua_toboolean(L, 2); // defaults to false
+
+    vector<df::unit *> units;
+    int count = lua_rawlen(L, 1);
+    units.reserve(count);
+    for (int i = 1; i <= count; i++) {
+        lua_rawgeti(L, 1, i);
+        units.push_back(Lua::CheckDFObject<df::unit>(L, -1));
+        lua_pop(L, 1);
+    }
+
+    vector<string> names;
+    Units::getReadableNames(names, units, skip_english);
+    Lua::PushVector(L, names);
+    return 1;
+}
+
 static int units_getVisibleName(lua_State *L) {
     if (auto unit = Lua::GetDFObject<df::unit>(L, 1))
         Lua::Push(L, Units::getVisibleName(unit));
@@ -2479,6 +2499,7 @@ static const luaL_Reg dfhack_units_funcs[] = {
     { "getStressCutoffs", units_getStressCutoffs },
     { "assignTrainer", units_assignTrainer },
     { "getReadableName", units_getReadablename },
+    { "getReadableNames", units_getReadableNames },
     { "getVisibleName", units_getVisibleName },
     { "getProfessionName", units_getProfessionName },
     { "getFocusPenalty", units_getFocusPenalty },
@@ -2817,6 +2838,20 @@ static int maps_addItemSpatter(lua_State *L)
     return 1;
 }
 
+static int maps_isReachableFromEntrance(lua_State *L)
+{
+    auto pos = CheckCoordXYZ(L, 1, true);
+    lua_pushboolean(L, Maps::getEntranceWalkableGroups().canReach(pos));
+    return 1;
+}
+
+static int maps_isReachableByCitizens(lua_State *L)
+{
+    auto pos = CheckCoordXYZ(L, 1, true);
+    lua_pushboolean(L, Maps::getCitizenWalkableGroups().canReach(pos));
+    return 1;
+}
+
 static const luaL_Reg dfhack_maps_funcs[] = {
     { "isValidTilePos", maps_isValidTilePos },
     { "isTileVisible", maps_isTileVisible },
@@ -2827,6 +2862,8 @@ static const luaL_Reg dfhack_maps_funcs[] = {
     { "getRegionBiome", maps_getRegionBiome },
     { "getTileBiomeRgn", maps_getTileBiomeRgn },
     { "getPlantAtTile", maps_getPlantAtTile },
+    { "isReachableFromEntrance", maps_isReachableFromEntrance },
+    { "isReachableByCitizens", maps_isReachableByCitizens },
     { "getBiomeType", maps_getBiomeType },
     { "isTileAquifer", maps_isTileAquifer },
     { "isTileHeavyAquifer", maps_isTileHeavyAquifer },
@@ -3442,6 +3479,18 @@ static const LuaWrapper::FunctionReg dfhack_kitchen_module[] = {
     {NULL, NULL}
 };
 
+/***** Raws module *****/
+
+static const LuaWrapper::FunctionReg dfhack_raws_module[] = {
+    WRAPM(Raws, findInorganic),
+    WRAPM(Raws, findPlant),
+    WRAPM(Raws, findCreature),
+    WRAPM(Raws, findCaste),
+    WRAPM(Raws, findReaction),
+    WRAPM(Raws, findItemSubtype),
+    {NULL, NULL}
+};
+
 /***** Console module *****/
 
 namespace console {
@@ -4400,7 +4449,11 @@ static int internal_getPerfCounters(lua_State *L) {
     Lua::Push(L, counters.update_lua_per_repeat);
     Lua::Push(L, counters.overlay_per_widget);
     Lua::Push(L, counters.zscreen_per_focus);
-    return 8;
+    Lua::Push(L, counters.update_overruns_per_plugin);
+    Lua::Push(L, counters.update_per_task);
+    Lua::Push(L, counters.slices_per_task);
+    Lua::Push(L, counters.max_slice_us_per_task);
+    return 12;
 }
 
 static int internal_getClipboardTextCp437Multiline(lua_State *L) {
@@ -4480,6 +4533,7 @@ void OpenDFHackApi(lua_State *state)
     OpenModule(state, "filesystem", dfhack_filesystem_module, dfhack_filesystem_funcs);
     OpenModule(state, "designations", dfhack_designations_module, dfhack_designations_funcs);
     OpenModule(state, "kitchen", dfhack_kitchen_module);
+    OpenModule(state, "raws", dfhack_raws_module);
     OpenModule(state, "console", dfhack_console_module);
     OpenModule(state, "internal", dfhack_internal_module, dfhack_internal_funcs);
 }
@@ -2074,6 +2074,9 @@ void DFHack::Lua::Core::onUpdate(color_ostream &out)
     auto State = DFHack::Core::getInstance().getLuaState();
     using df::global::world;
 
+    // Cached refs only live for one frame
+    LuaWrapper::ClearRefCache(State);
+
     if (frame_timers.empty() && tick_timers.empty())
         return;
 
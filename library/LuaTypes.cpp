@@ -209,7 +209,7 @@ void df::path_identity::lua_write(lua_State* state, int fname_idx, void* ptr, in
 
 void df::pointer_identity::lua_read(lua_State *state, int fname_idx, void *ptr, const type_identity *target)
 {
-    push_object_internal(state, target, *(void**)ptr);
+    push_object_cached(state, target, *(void**)ptr);
 }
 
 void df::pointer_identity::lua_read(lua_State *state, int fname_idx, void *ptr) const
@@ -931,6 +931,7 @@ static void attach_container_item_tagged_union(lua_State *state, int container,
 
         auto tag_container = (container_identity*)header->tag_identity;
 
+        unshare_object_ref(state, item);
         auto ref = get_object_ref_header(state, item);
 
         // on both msvc and gcc, vectors have the same memory layout
@@ -24,10 +24,12 @@ distribution.
 
 #include "Internal.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <map>
 #include <cinttypes>
+#include <cstring>
 
 #include "MemAccess.h"
 #include "Core.h"
@@ -196,6 +198,24 @@ void *LuaWrapper::get_object_ref(lua_State *state, int val_index)
     return get_object_ref_header(state, val_index)->ptr;
 }
 
+/**
+ * Push the metatable for the object, resolving the actual class using vtable.
+ */
+static void push_object_metatable(lua_State *state, const type_identity *type, void *ptr, bool in_method)
+{
+    if (type->type() == IDTYPE_CLASS)
+    {
+        const virtual_identity *class_vid = virtual_identity::get(virtual_ptr(ptr));
+        if (class_vid)
+            type = class_vid;
+    }
+
+    lua_pushlightuserdata(state, const_cast<type_identity*>(type)); // () -> type
+
+    if (!LookupTypeInfo(state, in_method)) // type -> metatable?
+        BuildTypeMetatable(state, type); // () -> metatable
+}
+
 /**
  * Push the pointer using given identity.
  */
@@ -215,27 +235,101 @@ void LuaWrapper::push_object_internal(lua_State *state, const type_identity *typ
         return;
     }
 
-    /*
-     * Resolve actual class using vtable
-     */
+    push_object_metatable(state, type, ptr, in_method); // () -> metatable
+    push_object_ref(state, ptr); // metatable -> userdata
+}
 
-    if (type->type() == IDTYPE_CLASS)
+/**
+ * Push the pointer using given identity, reusing a cached ref if possible.
+ */
+void LuaWrapper::push_object_cached(lua_State *state, const type_identity *type, void *ptr)
+{
+    if (!ptr || !type)
     {
-        const virtual_identity *class_vid = virtual_identity::get(virtual_ptr(ptr));
-        if (class_vid)
-            type = class_vid;
+        push_object_internal(state, type, ptr);
+        return;
     }
 
-    /*
-     * Resolve metatable by identity, and push the object
-     */
+    lua_rawgetp(state, LUA_REGISTRYINDEX, &DFHACK_REF_CACHE_TOKEN);
+    if (!lua_istable(state, -1))
+    {
+        lua_pop(state, 1);
+        push_object_internal(state, type, ptr);
+        return;
+    }
 
-    lua_pushlightuserdata(state, const_cast<type_identity*>(type)); // () -> type
+    int cache = lua_gettop(state);
+    lua_rawgetp(state, cache, ptr); // cache -> cache ref?
+    push_object_metatable(state, type, ptr, true); // -> cache ref? metatable
 
-    if (!LookupTypeInfo(state, in_method)) // type -> metatable?
-        BuildTypeMetatable(state, type); // () -> metatable
+    // Reuse the ref only if it was made for the same type
+    if (lua_isuserdata(state, -2) && lua_getmetatable(state, -2))
+    {
+        bool same = lua_rawequal(state, -1, -2);
+        lua_pop(state, 1);
 
-    push_object_ref(state, ptr); // metatable -> userdata
+        if (same)
+        {
+            lua_pop(state, 1);
+            lua_remove(state, cache); // -> ref
+            return;
+        }
+    }
+
+    push_object_ref(state, ptr); // -> cache ref? userdata
+    lua_dup(state);
+    lua_rawsetp(state, cache, ptr);
+    lua_replace(state, cache);
+    lua_pop(state, 1); // -> userdata
+}
+
+void LuaWrapper::unshare_object_ref(lua_State *state, int val_index)
+{
+    val_index = lua_absindex(state, val_index);
+    if (!lua_isuserdata(state, val_index) || lua_islightuserdata(state, val_index))
+        return;
+
+    lua_rawgetp(state, LUA_REGISTRYINDEX, &DFHACK_REF_CACHE_TOKEN);
+    if (!lua_istable(state, -1))
+    {
+        lua_pop(state, 1);
+        return;
+    }
+
+    auto header = get_object_ref_header(state, val_index);
+    lua_rawgetp(state, -1, header->ptr);
+    bool shared = lua_rawequal(state, -1, val_index);
+    lua_pop(state, 2);
+
+    if (!shared || !lua_getmetatable(state, val_index))
+        return;
+
+    DFRefHeader copy = *header;
+    push_object_ref(state, copy.ptr); // metatable -> userdata
+    *get_object_ref_header(state, -1) = copy;
+    lua_replace(state, val_index);
+}
+
+static void push_ref_cache_table(lua_State *state)
+{
+    lua_newtable(state);
+    lua_newtable(state);
+    lua_pushstring(state, "v");
+    lua_setfield(state, -2, "__mode");
+    lua_setmetatable(state, -2);
+}
+
+void LuaWrapper::ClearRefCache(lua_State *state)
+{
+    lua_rawgetp(state, LUA_REGISTRYINDEX, &DFHACK_REF_CACHE_TOKEN);
+    bool enabled = lua_istable(state, -1);
+    lua_pop(state, 1);
+
+    if (enabled)
+    {
+        push_ref_cache_table(state);
+        lua_rawsetp(state, LUA_REGISTRYINDEX, &DFHACK_REF_CACHE_TOKEN);
+    }
 }
 
 static void fetch_container_details(lua_State *state, int meta, const type_identity **pitem, int *pcount)
@@ -1125,6 +1219,216 @@ static int meta_isnull(lua_State *state)
     return 1;
 }
 
+/**
+ * Method: df.set_ref_cache(enable)
+ */
+static int meta_set_ref_cache(lua_State *state)
+{
+    bool enable = lua_toboolean(state, 1);
+
+    lua_rawgetp(state, LUA_REGISTRYINDEX, &DFHACK_REF_CACHE_TOKEN);
+    bool was_enabled = lua_istable(state, -1);
+    lua_pop(state, 1);
+
+    if (enable != was_enabled)
+    {
+        if (enable)
+            push_ref_cache_table(state);
+        else
+            lua_pushnil(state);
+        lua_rawsetp(state, LUA_REGISTRYINDEX, &DFHACK_REF_CACHE_TOKEN);
+    }
+
+    lua_pushboolean(state, was_enabled);
+    return 1;
+}
+
+static const struct_field_info *find_struct_field(const struct_identity *type, const char *name)
+{
+    for (; type; type = type->getParent())
+    {
+        auto fields = type->getFields();
+        if (!fields)
+            continue;
+
+        for (auto field = fields; field->mode != struct_field_info::END; ++field)
+            if (field->name && strcmp(field->name, name) == 0)
+                return field;
+    }
+
+    return NULL;
+}
+
+/**
+ * Method: df.collect(container[,field_path])
+ *
+ * Reads one primitive field of every item into a plain array. The path is
+ * resolved once against the declared item type, so fields of subclasses
+ * are not reachable; items with a NULL pointer on the way produce nil.
+ */
+static int meta_collect(lua_State *state)
+{
+    int argc = lua_gettop(state);
+    if (argc < 1 || argc > 2 || (argc == 2 && !lua_isnil(state, 2) && !lua_isstring(state, 2)))
+        luaL_error(state, "Usage: df.collect(container[,field_path])");
+
+    auto cid = dynamic_cast<const container_identity*>(
+        get_object_identity(state, 1, "df.collect()", false, true));
+    if (!cid || cid->type() == IDTYPE_BIT_CONTAINER)
+        luaL_error(state, "Container expected in df.collect()");
+
+    const type_identity *item = NULL;
+    int count = -1;
+    fetch_container_details(state, lua_gettop(state), &item, &count);
+    lua_pop(state, 1);
+
+    if (!item)
+        luaL_error(state, "Container item type unknown in df.collect()");
+
+    void *ptr = get_object_ref(state, 1);
+    bool ptr_items = (cid->type() == IDTYPE_PTR_CONTAINER || cid->type() == IDTYPE_STL_PTR_VECTOR);
+    if (count < 0)
+        count = cid->getItemCount(ptr, container_identity::COUNT_READ);
+
+    /*
+     * Resolve the path against the item type
+     */
+
+    // offsets of the pointers to follow on the way to the field
+    std::vector<size_t> derefs;
+    if (ptr_items)
+        derefs.push_back(0);
+
+    const type_identity *type = item;
+    size_t offset = 0;
+    int bit = -1, bit_size = 0;
+
+    std::vector<std::string> path;
+    if (const char *str = lua_tostring(state, 2))
+        split_string(&path, str, ".");
+
+    for (auto &name : path)
+    {
+        if (bit >= 0)
+            luaL_error(state, "Cannot index bitfield member in df.collect(): %s", name.c_str());
+
+        if (type->type() == IDTYPE_BITFIELD)
+        {
+            auto bf = (const bitfield_identity*)type;
+            auto bits = bf->getBits();
+            for (int i = 0; i < bf->getNumBits(); i++)
+            {
+                if (bits[i].name && name == bits[i].name)
+                {
+                    bit = i;
+                    bit_size = std::max(1, bits[i].size);
+                    break;
+                }
+            }
+            if (bit < 0)
+                luaL_error(state, "Unknown bitfield member in df.collect(): %s", name.c_str());
+            continue;
+        }
+
+        switch (type->type())
+        {
+        case IDTYPE_STRUCT:
+        case IDTYPE_CLASS:
+        case IDTYPE_UNION:
+            break;
+        default:
+            luaL_error(state, "Cannot index %s in df.collect(): %s",
+                       type->getFullName().c_str(), name.c_str());
+        }
+
+        auto field = find_struct_field((const struct_identity*)type, name.c_str());
+        if (!field)
+            luaL_error(state, "Unknown field in df.collect(): %s", name.c_str());
+
+        offset += field->offset;
+        switch (field->mode)
+        {
+        case struct_field_info::PRIMITIVE:
+        case struct_field_info::SUBSTRUCT:
+            break;
+
+        case struct_field_info::POINTER:
+            derefs.push_back(offset);
+            offset = 0;
+            break;
+
+        default:
+            luaL_error(state, "Field %s is not a value, substructure or pointer in df.collect()",
+                       name.c_str());
+        }
+
+        type = field->type;
+        if (!type)
+            luaL_error(state, "Field %s has no known type in df.collect()", name.c_str());
+    }
+
+    if (bit < 0)
+    {
+        switch (type->type())
+        {
+        case IDTYPE_PRIMITIVE:
+        case IDTYPE_ENUM:
+        case IDTYPE_BITFIELD:
+            break;
+        default:
+            luaL_error(state, "Field path must end in a primitive value in df.collect()");
+        }
+    }
+
+    /*
+     * Read the values
+     */
+
+    const type_identity *step_type = ptr_items ? &df::identity_traits<void*>::identity : item;
+    size_t whole_size = std::min(sizeof(size_t), size_t(type->byte_size()));
+
+    lua_createtable(state, count, 0);
+
+    for (int i = 0; i < count; i++)
+    {
+        auto addr = (uint8_t*)cid->getItemPointer(step_type, ptr, i);
+
+        for (size_t deref : derefs)
+        {
+            addr = *(uint8_t**)(addr + deref);
+            if (!addr)
+                break;
+        }
+
+        if (!addr)
+            continue;
+
+        addr += offset;
+
+        if (bit >= 0)
+        {
+            int value = getBitfieldField(addr, bit, bit_size);
+            if (bit_size <= 1)
+                lua_pushboolean(state, value != 0);
+            else
+                lua_pushinteger(state, value);
+        }
+        else if (type->type() == IDTYPE_BITFIELD)
+        {
+            size_t intv = 0;
+            memcpy(&intv, addr, whole_size);
+            lua_pushinteger(state, intv);
+        }
+        else
+            type->lua_read(state, 2, addr);
+
+        lua_rawseti(state, -2, i+1);
+    }
+
+    lua_pushinteger(state, count);
+    return 2;
+}
+
 static int meta_nodata(lua_State *state)
 {
     return 0;
@@ -1829,6 +2133,12 @@ static int DoAttach(lua_State *state)
         lua_pushcfunction(state, meta_isnull);
         lua_setfield(state, -2, "isnull");
 
+        lua_pushcfunction(state, meta_collect);
+        lua_setfield(state, -2, "collect");
+
+        lua_pushcfunction(state, meta_set_ref_cache);
+        lua_setfield(state, -2, "set_ref_cache");
+
         freeze_table(state, true, "df");
 
         // pairstable dftable dfmeta
@@ -1873,5 +2183,6 @@ namespace DFHack { namespace LuaWrapper {
     LuaToken DFHACK_TYPEID_TABLE_TOKEN;
     LuaToken DFHACK_ENUM_TABLE_TOKEN;
     LuaToken DFHACK_PTR_IDTABLE_TOKEN;
+    LuaToken DFHACK_REF_CACHE_TOKEN;
     LuaToken DFHACK_EMPTY_TABLE_TOKEN;
 }}
@@ -1,6 +1,7 @@
 
 #include "MiscUtils.h"
 #include <gtest/gtest.h>
+#include <stdexcept>
 #include <string>
 
 TEST(MiscUtils, wordwrap) {
@@ -17,3 +18,34 @@ TEST(MiscUtils, wordwrap) {
     word_wrap(&result, "1234567", 3);
     ASSERT_EQ(result.size(), 3);
 }
+
+TEST(MiscUtils, parallel_for) {
+    std::vector<std::atomic<int>> counts(1000);
+    parallel_for(counts.size(), [&](size_t i) { ++counts[i]; }, 4);
+    for (auto &count : counts)
+        ASSERT_EQ(count, 1);
+
+    // fewer items than threads, and the single-threaded path
+    std::vector<std::atomic<int>> few(2);
+    parallel_for(few.size(), [&](size_t i) { ++few[i]; }, 8);
+    parallel_for(few.size(), [&](size_t i) { ++few[i]; }, 1);
+    ASSERT_EQ(few[0], 2);
+    ASSERT_EQ(few[1], 2);
+
+    parallel_for(0, [&](size_t i) { FAIL(); });
+}
+
+TEST(MiscUtils, parallel_for_exception) {
+    // thrown from worker threads and from the calling thread, every thread is
+    // joined and the exception reaches the caller
+    for (size_t threads : {1, 2, 4}) {
+        std::atomic<int> calls = 0;
+        EXPECT_THROW(parallel_for(100, [&](size_t i) {
+            ++calls;
+            if (i % 10 == 3)
+                throw std::runtime_error("fail");
+        }, threads), std::runtime_error);
+        EXPECT_GT(calls, 0);
+        EXPECT_LE(calls, 100);
+    }
+}
@@ -0,0 +1,71 @@
+#include "modules/Persistence.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace DFHack::Persistence::Binary;
+
+static void expect_same(const Record &a, const Record &b) {
+    EXPECT_EQ(a.key, b.key);
+    EXPECT_EQ(a.fake_df_id, b.fake_df_id);
+    EXPECT_EQ(a.str_value, b.str_value);
+    EXPECT_EQ(a.int_values, b.int_values);
+    EXPECT_EQ(a.blob_value, b.blob_value);
+}
+
+TEST(Persistence, binary_round_trip) {
+    std::vector<Record> records(4);
+    records[0].key = "plugin/config";
+    records[1].key = "plugin/ints";
+    records[1].fake_df_id = -101;
+    records[1].int_values = {0, -1, 7, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()};
+    records[2].key = "plugin/str";
+    records[2].str_value = std::string("with\0nul and \xff bytes", 20);
+    records[3].key = "plugin/blob";
+    records[3].str_value = "x";
+    records[3].int_values = {42};
+    records[3].blob_value = {0, 1, 0xfe, 0xff};
+
+    std::string contents;
+    for (auto &record : records)
+        appendRecord(contents, record);
+
+    std::vector<Record> decoded;
+    ASSERT_TRUE(readRecords(contents, decoded));
+    ASSERT_EQ(decoded.size(), records.size());
+    for (size_t i = 0; i < records.size(); i++)
+        expect_same(decoded[i], records[i]);
+
+    // re-encoding the decoded records reproduces the file contents
+    std::string reencoded;
+    for (auto &record : decoded)
+        appendRecord(reencoded, record);
+    EXPECT_EQ(reencoded, contents);
+
+    ASSERT_TRUE(readRecords("", decoded));
+    EXPECT_TRUE(decoded.empty());
+}
+
+TEST(Persistence, binary_rejects_truncated) {
+    Record record;
+    record.key = "plugin/key";
+    record.str_value = "value";
+    record.int_values = {1, 2, 3};
+    record.blob_value = {9, 8, 7};
+    std::string contents;
+    appendRecord(contents, record);
+    appendRecord(contents, record);
+
+    std::vector<Record> decoded;
+    for (size_t len = 1; len < contents.size(); len++) {
+        if (len == contents.size() / 2)
+            continue; // a whole record
+        EXPECT_FALSE(readRecords(std::string_view(contents).substr(0, len), decoded)) << len;
+    }
+    ASSERT_TRUE(readRecords(std::string_view(contents).substr(0, contents.size() / 2), decoded));
+    ASSERT_EQ(decoded.size(), 1);
+    expect_same(decoded[0], record);
+}
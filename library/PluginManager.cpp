@@ -38,12 +38,18 @@ distribution.
 #include "DataDefs.h"
 #include "MiscUtils.h"
 #include "DFHackVersion.h"
+#include "Error.h"
 
 #include "LuaWrapper.h"
 #include "LuaTools.h"
 
+#include "df/world.h"
+
 using namespace DFHack;
+using df::global::world;
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
 #include <string>
 #include <vector>
@@ -71,6 +77,75 @@ static std::filesystem::path getPluginPath (std::string name)
     return getPluginPath() / (name + plugin_suffix);
 }
 
+// Plugin tasks with a pass in progress, in the order they were started
+static std::vector<PluginTask*> running_tasks;
+
+static void cancel_plugin_tasks(Plugin *owner)
+{
+    auto tasks = running_tasks;
+    for (auto task : tasks)
+        if (!owner || task->getOwner() == owner)
+            task->cancel();
+}
+
+PluginTask::~PluginTask()
+{
+    if (owner)
+        std::erase(running_tasks, this);
+}
+
+bool PluginTask::start(color_ostream &out, Plugin *owner)
+{
+    CHECK_NULL_POINTER(owner);
+    if (this->owner)
+        return false;
+    this->owner = owner;
+    running_tasks.push_back(this);
+    begin(out);
+    return true;
+}
+
+void PluginTask::finish(color_ostream &out)
+{
+    while (owner && step(out)) {}
+    complete(out);
+}
+
+void PluginTask::cancel()
+{
+    if (!owner)
+        return;
+    owner = NULL;
+    std::erase(running_tasks, this);
+    abandon();
+}
+
+void PluginTask::complete(color_ostream &out)
+{
+    if (!owner)
+        return;
+    owner = NULL;
+    std::erase(running_tasks, this);
+    end(out);
+}
+
+/**
+ * Run steps until the pass completes or the budget is used up.
+ * Returns true if the pass is no longer running.
+ */
+bool PluginTask::run_slice(color_ostream &out)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget_us);
+    do {
+        if (!step(out))
+        {
+            complete(out);
+            return true;
+        }
+    } while (owner && std::chrono::steady_clock::now() < deadline);
+    return !owner;
+}
+
 struct Plugin::RefLock
 {
     RefLock()
@@ -188,6 +263,7 @@ Plugin::Plugin(Core * core, const std::filesystem::path& path,
     plugin_shutdown = 0;
     plugin_status = 0;
     plugin_onupdate = 0;
+    plugin_update_cadence = 0;
     plugin_onstatechange = 0;
     plugin_rpcconnect = 0;
     plugin_enable = 0;
@@ -346,6 +422,7 @@ bool Plugin::load(color_ostream &con)
     }
     plugin_status = (command_result (*)(color_ostream &, std::string &)) LookupPlugin(plug, "plugin_status");
     plugin_onupdate = (command_result (*)(color_ostream &)) LookupPlugin(plug, "plugin_onupdate");
+    plugin_update_cadence = (PluginUpdateCadence*) LookupPlugin(plug, "plugin_update_cadence");
     plugin_shutdown = (command_result (*)(color_ostream &)) LookupPlugin(plug, "plugin_shutdown");
     plugin_onstatechange = (command_result (*)(color_ostream &, state_change_event)) LookupPlugin(plug, "plugin_onstatechange");
     plugin_rpcconnect = (RPCService* (*)(color_ostream &)) LookupPlugin(plug, "plugin_rpcconnect");
@@ -378,6 +455,7 @@ bool Plugin::load(color_ostream &con)
         con.printerr("Plugin {} has failed to initialize properly.\n", name);
         plugin_is_enabled = 0;
         plugin_onupdate = 0;
+        plugin_update_cadence = 0;
         reset_lua();
         plugin_abort_load;
         return false;
@@ -409,6 +487,7 @@ bool Plugin::unload(color_ostream &con)
         // wait for all calls to finish
         access->wait();
         state = PS_UNLOADING;
+        cancel_plugin_tasks(this);
         // only attempt to unload site or world data if the core is in a valid state
         if (Core::getInstance().isValid())
         {
@@ -433,6 +512,7 @@ bool Plugin::unload(color_ostream &con)
         // cleanup...
         plugin_is_enabled = 0;
         plugin_onupdate = 0;
+        plugin_update_cadence = 0;
         plugin_save_world_data = 0;
         plugin_save_site_data = 0;
         plugin_load_world_data = 0;
@@ -554,6 +634,53 @@ command_result Plugin::on_update(color_ostream &out)
     return cr;
 }
 
+void Plugin::run_task_slice(color_ostream &out, PluginTask *task)
+{
+    if (plugin_is_enabled && !*plugin_is_enabled)
+    {
+        task->cancel();
+        return;
+    }
+    access->lock_add();
+    if (state == PS_LOADED)
+    {
+        task->run_slice(out);
+        Lua::Core::Reset(out, "plugin task");
+    }
+    access->lock_sub();
+}
+
+// Slow cycles are spread over frames; faster ones always run when due.
+static const int32_t STAGGER_MIN_TICKS = 100;
+
+/**
+ * Number of ticks the next plugin_onupdate call is overdue, or -1 if
+ * the call can be skipped in this frame.
+ */
+int32_t Plugin::update_overdue_ticks()
+{
+    // Check things that are implicitly protected by the suspend lock
+    if (!plugin_onupdate || (plugin_is_enabled && !*plugin_is_enabled))
+        return -1;
+    if (!plugin_update_cadence || !world)
+        return 0;
+
+    int32_t elapsed = world->frame_counter - *plugin_update_cadence->timestamp;
+    if (elapsed < plugin_update_cadence->ticks)
+        return -1;
+    return elapsed - plugin_update_cadence->ticks;
+}
+
+bool Plugin::has_staggered_update()
+{
+    return plugin_update_cadence && plugin_update_cadence->ticks >= STAGGER_MIN_TICKS;
+}
+
+uint32_t Plugin::update_budget_ms()
+{
+    return plugin_update_cadence ? plugin_update_cadence->budget_ms : 0;
+}
+
 command_result Plugin::set_enabled(color_ostream &out, bool enable)
 {
     command_result cr = CR_NOT_IMPLEMENTED;
@@ -1038,12 +1165,51 @@ void PluginManager::OnUpdate(color_ostream &out)
 {
     auto &core = Core::getInstance();
     auto &counters = core.perf_counters;
+
+    // Of the slow cycles that are due, run only one in this frame, taking
+    // turns in name order, so that cycles that became due together (e.g. on
+    // map load) do not all land on the same frame.
+    Plugin *staggered = NULL;
+    for (auto it = begin(); it != end(); ++it) {
+        auto & plugin = it->second;
+        if (!plugin->has_staggered_update() || plugin->update_overdue_ticks() < 0)
+            continue;
+        if (!staggered || (it->first > last_staggered_update &&
+                           staggered->getName() <= last_staggered_update))
+            staggered = plugin;
+    }
+    if (staggered)
+        last_staggered_update = staggered->getName();
+
     for (auto it = begin(); it != end(); ++it) {
         auto & plugin_name = it->first;
         auto & plugin = it->second;
+        if (plugin->has_staggered_update() ? plugin != staggered : plugin->update_overdue_ticks() < 0)
+            continue;
         uint32_t start_ms = core.p->getTickCount();
         plugin->on_update(out);
         counters.incCounter(counters.update_per_plugin[plugin_name], start_ms);
+        uint32_t budget_ms = plugin->update_budget_ms();
+        if (budget_ms && core.p->getTickCount() - start_ms > budget_ms)
+            ++counters.update_overruns_per_plugin[plugin_name];
+    }
+
+    // Advance each running plugin task by one slice
+    auto tasks = running_tasks;
+    for (auto task : tasks) {
+        // may have been completed or cancelled by an earlier slice
+        if (!task->is_running())
+            continue;
+        auto & task_name = task->getName();
+        uint32_t start_ms = core.p->getTickCount();
+        auto start = std::chrono::steady_clock::now();
+        task->owner->run_task_slice(out, task);
+        auto slice_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        counters.incCounter(counters.update_per_task[task_name], start_ms);
+        ++counters.slices_per_task[task_name];
+        auto & max_us = counters.max_slice_us_per_task[task_name];
+        max_us = std::max(max_us, uint32_t(slice_us));
     }
 }
 
@@ -1051,6 +1217,11 @@ void PluginManager::OnStateChange(color_ostream &out, state_change_event event)
 {
     auto &core = Core::getInstance();
     auto &counters = core.perf_counters;
+
+    // task cursors refer to map objects
+    if (event == SC_MAP_UNLOADED || event == SC_WORLD_UNLOADED)
+        cancel_plugin_tasks(NULL);
+
     for (auto it = begin(); it != end(); ++it) {
         auto & plugin_name = it->first;
         auto & plugin = it->second;
@@ -95,6 +95,10 @@ namespace DFHack
         std::unordered_map<int32_t, uint32_t> event_manager_event_total_ms;
         std::unordered_map<int32_t, std::unordered_map<std::string, uint32_t>> event_manager_event_per_plugin_ms;
         std::unordered_map<std::string, uint32_t> update_per_plugin;
+        std::unordered_map<std::string, uint32_t> update_overruns_per_plugin;
+        std::unordered_map<std::string, uint32_t> update_per_task;
+        std::unordered_map<std::string, uint32_t> slices_per_task;
+        std::unordered_map<std::string, uint32_t> max_slice_us_per_task;
         std::unordered_map<std::string, uint32_t> state_change_per_plugin;
         std::unordered_map<std::string, uint32_t> update_lua_per_repeat;
         std::unordered_map<std::string, uint32_t> overlay_per_widget;
@@ -151,6 +151,12 @@ namespace DFHack
 
         virtual bool lua_insert2(lua_State *state, int fname_idx, void *ptr, int idx, int val_index) const;
 
+        // Raw item access for bulk readers; pointer containers step by void*.
+        int getItemCount(void *ptr, CountMode cnt) const { return item_count(ptr, cnt); }
+        void *getItemPointer(const type_identity *item, void *ptr, int idx) const {
+            return item_pointer(item, ptr, idx);
+        }
+
     protected:
         virtual int item_count(void *ptr, CountMode cnt) const = 0;
         virtual void *item_pointer(const type_identity *item, void *ptr, int idx) const = 0;
@@ -65,6 +65,12 @@ namespace LuaWrapper {
      */
     extern LuaToken DFHACK_PTR_IDTABLE_TOKEN;
 
+    /**
+     * Registry pkey: weak table of pointer -> object ref reused by pointer reads,
+     * or nil while the ref cache is disabled.
+     */
+    extern LuaToken DFHACK_REF_CACHE_TOKEN;
+
 // Function registry names
     constexpr auto DFHACK_CHANGEERROR_NAME = "DFHack::ChangeError";
     constexpr auto DFHACK_COMPARE_NAME = "DFHack::ComparePtrs";
@@ -148,6 +154,21 @@ namespace LuaWrapper {
 
     void push_adhoc_pointer(lua_State *state, void *ptr, const type_identity *target);
 
+    /**
+     * Like push_object_internal, but reuses the ref pushed earlier for the
+     * same object and type while the ref cache is enabled.
+     */
+    void push_object_cached(lua_State *state, const type_identity *type, void *ptr);
+    /**
+     * If the ref at the index is shared through the ref cache, replace it
+     * with a private copy so that its header can be modified.
+     */
+    void unshare_object_ref(lua_State *state, int val_index);
+    /**
+     * Drop the refs held by the ref cache, if enabled. Called once per frame.
+     */
+    DFHACK_EXPORT void ClearRefCache(lua_State *state);
+
     /**
      * Verify that the object is a DF ref with UPVAL_METATABLE.
      * If everything ok, extract the address.
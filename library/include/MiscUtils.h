@@ -27,14 +27,19 @@ distribution.
 #include "Export.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <climits>
 #include <cstdio>
+#include <exception>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <stdint.h>
+#include <system_error>
+#include <thread>
 #include <vector>
 
 #if defined(_MSC_VER)
@@ -555,6 +560,55 @@ inline T clip_range(T a, T1 minv, T2 maxv) {
     return a;
 }
 
+/**
+ * Calls fn(i) for each i in [0, count), spreading the calls over up to
+ * max_threads threads (default: the number of hardware threads). Blocks
+ * until all calls have returned. fn must be safe to call concurrently and
+ * must not touch DF state that the core lock would otherwise protect unless
+ * the caller holds that lock for the duration. If fn throws, no further calls
+ * are started, and the first exception is rethrown once all threads are done.
+ */
+template<typename Fn>
+inline void parallel_for(size_t count, Fn &&fn, size_t max_threads = 0)
+{
+    if (!max_threads)
+        max_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t num_threads = std::min(count, max_threads);
+    if (num_threads <= 1) {
+        for (size_t i = 0; i < count; ++i)
+            fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&]() {
+        try {
+            for (size_t i = next++; i < count; i = next++)
+                fn(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+            next = count;
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    try {
+        for (size_t t = 1; t < num_threads; ++t)
+            threads.emplace_back(worker);
+    } catch (const std::system_error &) {
+        // make do with the threads that could be started
+    }
+    worker();
+    for (auto &thread : threads)
+        thread.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
 /**
  * Returns the amount of milliseconds elapsed since the UNIX epoch.
  * Works on both windows and linux.
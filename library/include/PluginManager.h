@@ -81,6 +81,16 @@ namespace DFHack
         const char *name;
         Lua::Notification *event;
     };
+    /// Update schedule of a plugin whose plugin_onupdate only does work every
+    /// few ticks; see DFHACK_PLUGIN_UPDATE_CADENCE.
+    struct PluginUpdateCadence {
+        // world->frame_counter at the last cycle of the plugin
+        const int32_t *timestamp;
+        // number of ticks between cycles
+        int32_t ticks;
+        // soft time limit for one plugin_onupdate call in ms, or 0 for none
+        uint32_t budget_ms;
+    };
     struct DFHACK_EXPORT PluginCommand
     {
         typedef command_result (*command_function)(color_ostream &out, std::vector <std::string> &);
@@ -135,6 +145,53 @@ namespace DFHack
         const command_hotkey_guard guard;
         std::string usage;
     };
+    class Plugin;
+
+    /// A plugin pass that the core runs in slices over several frames, each
+    /// slice limited to a time budget, instead of all at once in plugin_onupdate.
+    /// Subclasses keep their cursor in member variables and must re-check game
+    /// objects that may have gone away between frames. Running passes are
+    /// abandoned when the plugin is disabled or unloaded, or the map unloads.
+    class DFHACK_EXPORT PluginTask
+    {
+        friend class Plugin;
+        friend class PluginManager;
+    public:
+        PluginTask(const char *name, uint32_t budget_us)
+            : name(name), budget_us(budget_us) {}
+        virtual ~PluginTask();
+
+        /// Begin a new pass on behalf of the plugin (normally plugin_self).
+        /// Returns false if a pass is already running.
+        bool start(color_ostream &out, Plugin *owner);
+        /// Run the rest of the current pass, if any, right away.
+        void finish(color_ostream &out);
+        /// Abandon the current pass, if any.
+        void cancel();
+
+        bool is_running() const { return owner != NULL; }
+        Plugin *getOwner() const { return owner; }
+        const std::string &getName() const { return name; }
+
+    protected:
+        /// Set up the cursor for a new pass.
+        virtual void begin(color_ostream &out) {}
+        /// Do one small unit of work; return false once the pass is complete.
+        virtual bool step(color_ostream &out) = 0;
+        /// Wrap up after the last step.
+        virtual void end(color_ostream &out) {}
+        /// Drop the partial results of an abandoned pass.
+        virtual void abandon() {}
+
+    private:
+        bool run_slice(color_ostream &out);
+        void complete(color_ostream &out);
+
+        const std::string name;
+        const uint32_t budget_us;
+        Plugin *owner = NULL;
+    };
+
     class Plugin
     {
         struct RefLock;
@@ -146,6 +203,10 @@ namespace DFHack
             const std::string &plug_name, PluginManager * pm);
         ~Plugin();
         command_result on_update(color_ostream &out);
+        void run_task_slice(color_ostream &out, PluginTask *task);
+        int32_t update_overdue_ticks();
+        bool has_staggered_update();
+        uint32_t update_budget_ms();
         command_result on_state_change(color_ostream &out, state_change_event event);
         command_result save_world_data(color_ostream &out);
         command_result save_site_data(color_ostream &out);
@@ -231,6 +292,7 @@ namespace DFHack
         command_result (*plugin_status)(color_ostream &, std::string &);
         command_result (*plugin_shutdown)(color_ostream &);
         command_result (*plugin_onupdate)(color_ostream &);
+        PluginUpdateCadence *plugin_update_cadence;
         command_result (*plugin_onstatechange)(color_ostream &, state_change_event);
         command_result (*plugin_enable)(color_ostream &, bool);
         RPCService* (*plugin_rpcconnect)(color_ostream &);
@@ -286,6 +348,7 @@ namespace DFHack
         std::map <std::string, Plugin*> command_map;
         std::map <std::string, Plugin*> all_plugins;
         std::string plugin_path;
+        std::string last_staggered_update;
     };
 
     namespace Gui
@@ -322,6 +385,15 @@ extern "C" { \
     DFhackDataExport bool plugin_is_enabled = false; \
     bool &varname = plugin_is_enabled;
 
+/// Declare that plugin_onupdate only does work once timestamp_var (the value of
+/// world->frame_counter at the last cycle) is at least cycle_ticks old. The core
+/// then skips calling plugin_onupdate until the cycle is due, spreads slow cycles
+/// that become due together over consecutive frames, and counts calls that take
+/// longer than budget_ms (0 for no budget) in the perf counters.
+#define DFHACK_PLUGIN_UPDATE_CADENCE(timestamp_var, cycle_ticks, budget_ms) \
+    DFhackDataExport DFHack::PluginUpdateCadence plugin_update_cadence = \
+        { &timestamp_var, cycle_ticks, budget_ms };
+
 #define REQUIRE_GLOBAL_NO_USE(global_name) \
     static int VARIABLE_IS_NOT_USED CONCAT_TOKENS(required_globals_, __LINE__) = \
         (plugin_globals->push_back(#global_name), 0);
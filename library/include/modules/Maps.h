@@ -42,6 +42,9 @@ distribution.
 #include "df/tile_dig_designation.h"
 #include "df/tiletype.h"
 
+#include <unordered_set>
+#include <vector>
+
 namespace df {
     struct block_square_event;
     struct block_square_event_designation_priorityst;
@@ -405,6 +408,73 @@ DFHACK_EXPORT bool removeTileAquifer(int32_t x, int32_t y, int32_t z);
 inline bool removeTileAquifer(df::coord pos) { return removeTileAquifer(pos.x, pos.y, pos.z); }
 DFHACK_EXPORT int removeAreaAquifer(df::coord pos1, df::coord pos2,
     std::function<bool(df::coord, df::map_block *)> filter = [](df::coord pos, df::map_block *block) { return true; });
+
+/*
+ * Map change feed.
+ *
+ * While at least one subscriber is registered, the core checks map blocks
+ * for changes to their tile types, designations (which include liquids),
+ * and occupancy (ignoring units moving around) once per update. Each block
+ * that changed is stamped with a new generation number, so tools can ask
+ * which blocks changed since their last look instead of keeping private
+ * copies of the map.
+ *
+ * Each update checks a rotating window of blocks, plus every block that
+ * changed recently or was passed to markBlockChanged(). Changes in quiet
+ * parts of a large map may therefore be reported a few updates late.
+ */
+typedef uint32_t MapGeneration;
+
+// Enables change tracking on behalf of owner (usually plugin_self).
+DFHACK_EXPORT void subscribeChanges(const void *owner);
+DFHACK_EXPORT void unsubscribeChanges(const void *owner);
+// The generation of the most recent update in which changes were seen.
+DFHACK_EXPORT MapGeneration getMapGeneration();
+// The generation in which the block last changed, or 0 if it is not tracked yet.
+DFHACK_EXPORT MapGeneration getBlockGeneration(df::map_block *block);
+// Appends each block that changed after the since cursor to blocks, once,
+// and returns the cursor to use for the next call. A cursor of 0 reports
+// every block. The map being reloaded also reports every block.
+DFHACK_EXPORT MapGeneration getChangedBlocks(MapGeneration since, std::vector<df::map_block *> &blocks);
+// Queues a block to be checked on the next update. Tools that modify the map
+// can call this so that their changes are reported without delay.
+DFHACK_EXPORT void markBlockChanged(df::map_block *block);
+
+/*
+ * Walkable group reachability.
+ *
+ * Tiles that share a nonzero walkable group are connected; DF already merges
+ * tiles joined through doors, hatches, and ramps into a single group. The
+ * tiles reachable from a set of source tiles are therefore the tiles in the
+ * groups of the sources, and checking a position is a single hash probe.
+ */
+class DFHACK_EXPORT WalkableGroupSet {
+public:
+    void clear() { groups.clear(); }
+    bool empty() const { return groups.empty(); }
+    size_t size() const { return groups.size(); }
+
+    // Adds the group of the source tile. Returns false if it is not walkable.
+    bool add(df::coord pos);
+    void add(const std::vector<df::coord> &sources);
+    bool contains(uint16_t group) const { return group && groups.contains(group); }
+    bool canReach(df::coord pos) const;
+    // Sets reachable[i] for each of the positions and returns how many are reachable.
+    size_t canReach(const std::vector<df::coord> &positions, std::vector<bool> &reachable) const;
+
+    const std::unordered_set<uint16_t> &getGroups() const { return groups; }
+
+private:
+    std::unordered_set<uint16_t> groups;
+};
+
+// Groups of the walkable tiles on the map edge, where visitors and invaders
+// enter the map. Cached, and recomputed after the map change feed reports a
+// change (the first call subscribes to it) and at least every 100 ticks,
+// since forbidding a door changes groups without changing any tile.
+DFHACK_EXPORT const WalkableGroupSet &getEntranceWalkableGroups();
+// Groups that hold at least one citizen or resident. Recomputed at most once per tick.
+DFHACK_EXPORT const WalkableGroupSet &getCitizenWalkableGroups();
 }
 }
 #endif
@@ -33,8 +33,13 @@ distribution.
 #include "Error.h"
 #include "Export.h"
 
+#include <cstring>
+#include <filesystem>
+#include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace DFHack
@@ -44,6 +49,8 @@ namespace DFHack
     namespace Persistence
     {
         struct DataEntry;
+        // identifies an interned key; see Persistence::internKey()
+        typedef uint32_t KeyId;
     }
 
     class DFHACK_EXPORT PersistentDataItem {
@@ -89,9 +96,33 @@ namespace DFHack
                 val() = value;
         }
 
+        // optional binary value, stored alongside the string and int values.
+        // unlike the string value, it may contain arbitrary bytes.
+        std::vector<uint8_t> &blob();
+        const std::vector<uint8_t> &blob() const;
+
+        // typed access to the blob for trivially copyable types. get_blob returns
+        // false and leaves value untouched if the blob is not exactly sizeof(T).
+        template<typename T>
+        bool get_blob(T &value) const {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if (!isValid() || blob().size() != sizeof(T))
+                return false;
+            memcpy(&value, blob().data(), sizeof(T));
+            return true;
+        }
+        template<typename T>
+        void set_blob(const T &value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if (!isValid())
+                return;
+            auto &b = blob();
+            b.resize(sizeof(T));
+            memcpy(b.data(), &value, sizeof(T));
+        }
+
         // Data mangling functions below this point are deprecated and
-        // will be removed in some future release when we have provided
-        // an alternate way to store binary data.
+        // will be removed in some future release. Use blob() instead.
 
         // Pack binary data into string field.
         // Since DF serialization chokes on NUL bytes,
@@ -213,7 +244,50 @@ namespace DFHack
         // Fills the vector with references to each persistent item with a key that is
         // equal to the given key.
         DFHACK_EXPORT void getAllByKey(std::vector<PersistentDataItem> &vec, int entity_id, const std::string &key);
+
+        // Returns a stable id for the given key. Ids remain valid for the lifetime of
+        // the process, so plugins can intern their keys once and skip string
+        // comparisons on later lookups.
+        DFHACK_EXPORT KeyId internKey(std::string_view key);
+        // Returns the first item with the given interned key, or an invalid item.
+        DFHACK_EXPORT PersistentDataItem getByKey(int entity_id, KeyId key_id);
+
+        // The forEach functions call fn for each matching item, in key order, without
+        // copying handles into a vector. Iteration stops early if fn returns false.
+        // Items must not be added or deleted from within fn.
+        typedef std::function<bool(PersistentDataItem &)> visitor_fn;
+        DFHACK_EXPORT void forEachByKey(int entity_id, std::string_view key, const visitor_fn &fn);
+        DFHACK_EXPORT void forEachByKey(int entity_id, KeyId key_id, const visitor_fn &fn);
+        // Visits items with a key that is greater than or equal to "min" and less than "max".
+        DFHACK_EXPORT void forEachByKeyRange(int entity_id, std::string_view min, std::string_view max, const visitor_fn &fn);
+        // Visits items with a key that starts with "prefix".
+        DFHACK_EXPORT void forEachByKeyPrefix(int entity_id, std::string_view prefix, const visitor_fn &fn);
         // Returns the number of seconds since the current savegame was saved or loaded.
         DFHACK_EXPORT uint32_t getUnsavedSeconds();
+        // Writes all items associated with the entity to the given path as JSON. Data is
+        // stored on disk in a binary format; this is for inspection and transfer.
+        DFHACK_EXPORT bool exportJSON(int entity_id, const std::filesystem::path &path);
+        // Adds all items in the given JSON file (as written by exportJSON) to the entity.
+        // Existing items are not removed.
+        DFHACK_EXPORT bool importJSON(int entity_id, const std::filesystem::path &path);
+
+        // The record encoding of the binary save files, which hold the records
+        // of an entity's items back to back after a magic header.
+        namespace Binary
+        {
+            struct Record {
+                std::string key;
+                int fake_df_id = 0;
+                std::string str_value;
+                std::vector<int> int_values;
+                std::vector<uint8_t> blob_value;
+            };
+
+            // Appends the length-prefixed record to buf.
+            DFHACK_EXPORT void appendRecord(std::string &buf, const Record &record);
+            // Decodes a stream of records (without the file header). Returns false,
+            // leaving records unspecified, if any record is truncated or malformed.
+            DFHACK_EXPORT bool readRecords(std::string_view contents, std::vector<Record> &records);
+        }
     }
 }
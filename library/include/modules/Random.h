@@ -168,6 +168,14 @@ namespace Random
         void init(MersenneRNG &rng);
 
         T eval(const T coords[VSIZE]);
+
+        /*
+         * Evaluates count points that only differ in the first coordinate,
+         * which is taken from xs[i]; coords[0] is ignored. Setup for the
+         * other coordinates is only done once, which makes this cheaper
+         * than calling eval() for each point. Results are identical.
+         */
+        void eval_row(const T coords[VSIZE], const T *xs, unsigned count, T *out);
     };
 
 #ifndef DFHACK_RANDOM_CPP
@@ -201,6 +209,10 @@ namespace Random
             T tmp[3] = { x, y, z };
             return this->eval(tmp);
         }
+        void row(const T *xs, T y, T z, unsigned count, T *out) {
+            T tmp[3] = { 0, y, z };
+            this->eval_row(tmp, xs, count, out);
+        }
     };
 }
 }
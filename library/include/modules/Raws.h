@@ -0,0 +1,64 @@
+/*
+https://github.com/peterix/dfhack
+Copyright (c) 2009-2012 Petr Mrázek (peterix@gmail.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#pragma once
+#include "Export.h"
+
+#include "df/item_type.h"
+
+#include <string>
+
+/**
+ * \defgroup grp_raws Raws module: lookups of raw objects by token
+ * @ingroup grp_modules
+ */
+
+namespace DFHack
+{
+namespace Raws
+{
+    /*
+     * Each lookup returns the index of the raw object with the given token
+     * in its world->raws vector, or -1 if there is none. The first lookup of
+     * a kind builds a hash index of the tokens, which is kept until the
+     * world is unloaded, so these are cheap enough for bulk imports.
+     */
+
+    // world->raws.inorganics.all, by id
+    DFHACK_EXPORT int32_t findInorganic(const std::string &id);
+    // world->raws.plants.all, by id
+    DFHACK_EXPORT int32_t findPlant(const std::string &id);
+    // world->raws.creatures.all, by creature_id
+    DFHACK_EXPORT int32_t findCreature(const std::string &id);
+    // the caste vector of the creature at the given index, by caste_id
+    DFHACK_EXPORT int32_t findCaste(int32_t creature, const std::string &id);
+    // world->raws.reactions.reactions, by code
+    DFHACK_EXPORT int32_t findReaction(const std::string &code);
+    // the subtype of the given item type with the given itemdef id
+    DFHACK_EXPORT int32_t findItemSubtype(df::item_type type, const std::string &id);
+
+    // Drops the indexes. Happens automatically when the world is unloaded.
+    DFHACK_EXPORT void clearIndexes();
+}
+}
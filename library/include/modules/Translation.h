@@ -35,6 +35,9 @@ distribution.
 #include "Types.h"
 #include "df/language_name_type.h"
 
+#include <string>
+#include <vector>
+
 namespace df {
     struct language_name;
     struct language_translation;
@@ -56,9 +59,16 @@ DFHACK_EXPORT void setNickname(df::language_name *name, std::string nick);
 
 DFHACK_EXPORT std::string capitalize(const std::string &str, bool all_words = false);
 
-// translate a name using the loaded dictionaries
+// translate a name using the loaded dictionaries. translations are cached by
+// the content of the name, so repeated calls for the same name are cheap.
 DFHACK_EXPORT std::string translateName (const df::language_name * name, bool inEnglish = false,
                                          bool onlyLastPart = false);
+// translate a list of names at once; null names translate to empty strings
+DFHACK_EXPORT void translateNames (const std::vector<const df::language_name *> &names,
+                                   std::vector<std::string> &out, bool inEnglish = false,
+                                   bool onlyLastPart = false);
+// drop the cached translations. happens automatically when the world is unloaded.
+DFHACK_EXPORT void clearNameCache();
 
 DFHACK_EXPORT void generateName(df::language_name *name, int language_index, df::language_name_type nametype,
     df::language_word_table *major_selector, df::language_word_table *minor_selector);
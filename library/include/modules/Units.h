@@ -286,6 +286,9 @@ DFHACK_EXPORT std::string getRaceChildName(df::unit *unit, bool plural = false);
 DFHACK_EXPORT std::string getReadableName(df::historical_figure *hf, bool skip_english = false);
 // Full readable name including profession, curse name, and tame description.
 DFHACK_EXPORT std::string getReadableName(df::unit *unit, bool skip_english = false);
+// getReadableName for each of the units, for drawing whole lists of units.
+DFHACK_EXPORT void getReadableNames(std::vector<std::string> &names, const std::vector<df::unit *> &units,
+    bool skip_english = false);
 
 // Unit's age (in non-integer years). Ignore false identities if true_age.
 DFHACK_EXPORT double getAge(df::unit *unit, bool true_age = false);
@@ -118,9 +118,18 @@ namespace DFHack
         // Deletes the item; returns true if success.
         DFHACK_EXPORT bool DeletePersistentData(const PersistentDataItem &item);
 
-        // Create or delete block data associated with the given persistent data item
+        // Create or delete block data associated with the given persistent data item.
+        // Masks are indexed by item and block, so lookups don't scan the block events.
         DFHACK_EXPORT df::tile_bitmask *getPersistentTilemask(PersistentDataItem &item, df::map_block *block, bool create = false);
         DFHACK_EXPORT bool deletePersistentTilemask(PersistentDataItem &item, df::map_block *block);
+        // Lists the blocks that have a tile mask for the item, in no particular order.
+        DFHACK_EXPORT void getPersistentTilemaskBlocks(PersistentDataItem &item, std::vector<df::map_block *> *blocks);
+        // Sets or clears the item's mask for every tile in the cuboid. Masks are
+        // created as needed, and deleted once clearing leaves them empty.
+        DFHACK_EXPORT void setPersistentTilemaskArea(PersistentDataItem &item, const df::coord &pos1, const df::coord &pos2, bool enable);
+        // Counts the tiles in the cuboid that are set in the item's mask, and
+        // optionally appends their positions to tiles.
+        DFHACK_EXPORT size_t getPersistentTilemaskArea(PersistentDataItem &item, const df::coord &pos1, const df::coord &pos2, std::vector<df::coord> *tiles = NULL);
     }
 }
 #endif
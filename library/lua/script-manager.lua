@@ -290,7 +290,9 @@ end
 
 function print_timers()
     local summary, em_per_event, em_per_plugin_per_event, update_per_plugin, state_change_per_plugin,
-        update_lua_per_repeat, overlay_per_widget, zscreen_per_focus = dfhack.internal.getPerfCounters()
+        update_lua_per_repeat, overlay_per_widget, zscreen_per_focus,
+        update_overruns_per_plugin, update_per_task, slices_per_task,
+        max_slice_us_per_task = dfhack.internal.getPerfCounters()
 
     local elapsed = summary.elapsed_ms
     local total_update_time = summary.total_update_ms
@@ -360,6 +362,27 @@ function print_timers()
         print('-----------------')
         print()
         print_sorted_timers(update_per_plugin, 25, summary.update_plugin_ms, 'update', elapsed, 'elapsed')
+        if next(update_overruns_per_plugin) then
+            print()
+            print()
+            print('Update budget overruns per plugin')
+            print('---------------------------------')
+            print()
+            for name, count in pairs(update_overruns_per_plugin) do
+                print(('%25s %8d calls'):format(name, count))
+            end
+        end
+        if next(slices_per_task) then
+            print()
+            print()
+            print('Plugin tasks')
+            print('------------')
+            print()
+            for name, slices in pairs(slices_per_task) do
+                print(('%25s %8d ms in %d slices (longest %d us)'):format(
+                    name, update_per_task[name] or 0, slices, max_slice_us_per_task[name] or 0))
+            end
+        end
         print()
         print()
         print('State change per plugin')
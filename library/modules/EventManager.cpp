@@ -3,12 +3,14 @@
 #include "Debug.h"
 #include "VTableInterpose.h"
 #include "MemAccess.h"
+#include "TileTypes.h"
 
 #include "modules/Buildings.h"
 #include "modules/Constructions.h"
 #include "modules/EventManager.h"
 #include "modules/Once.h"
 #include "modules/Job.h"
+#include "modules/Maps.h"
 #include "modules/Units.h"
 #include "modules/World.h"
 
@@ -28,6 +30,7 @@
 #include "df/item_weaponst.h"
 #include "df/job.h"
 #include "df/job_list_link.h"
+#include "df/map_block.h"
 #include "df/report.h"
 #include "df/plotinfost.h"
 #include "df/unit.h"
@@ -40,11 +43,14 @@
 
 #include <algorithm>
 #include <cstring>
+#include <deque>
 #include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <array>
+#include <bitset>
 #include <utility>
 
 namespace DFHack {
@@ -151,6 +157,8 @@ static void manageUnitDeathEvent(color_ostream& out);
 static void manageItemCreationEvent(color_ostream& out);
 static void manageBuildingEvent(color_ostream& out);
 static void manageConstructionEvent(color_ostream& out);
+static void trackAllConstructions(color_ostream& out);
+static void stopConstructionFeed();
 static void manageSyndromeEvent(color_ostream& out);
 static void manageInvasionEvent(color_ostream& out);
 static void manageEquipmentEvent(color_ostream& out);
@@ -244,17 +252,23 @@ static int32_t nextItem;
 static int32_t nextBuilding;
 static unordered_set<int32_t> buildings;
 
-namespace std {
-    template <>
-    struct hash<df::construction> {
-        std::size_t operator()(const df::construction& construct) const {
-            return construct();
-        }
-    };
-}
-
 //construction
-static unordered_set<df::construction> constructions;
+// The tracked constructions are kept as a bitmask of the constructed tiles of
+// each map block that has any. A pass only looks at the blocks that the map
+// change feed reports as changed (building or removing a construction changes
+// the tile type), and at individual constructions only in blocks whose mask
+// changed. Copies of the constructions are kept with their block to hand to
+// the handlers once DF has deleted the originals.
+struct ConstructionBlock {
+    df::coord origin;
+    std::bitset<256> tracked;
+    std::bitset<256> current; // scratch for the pass in progress
+    vector<df::construction> copies;
+};
+static unordered_map<uint64_t, ConstructionBlock> constructionBlocks;
+// the feed is only followed while there are construction listeners
+static bool constructionFeedSubscribed;
+static Maps::MapGeneration constructionFeedCursor;
 static bool gameLoaded;
 
 //syndrome
@@ -266,13 +280,29 @@ static int32_t nextInvasion;
 //equipment change
 //static unordered_map<int32_t, vector<df::unit_inventory_item> > equipmentLog;
 static unordered_map<int32_t, vector<InventoryItem>> equipmentLog;
+// hash of each unit's inventory as of the last check, indexed by unit id.
+// units whose inventory still hashes the same are skipped without diffing.
+static vector<uint64_t> equipmentFingerprints;
 
 //report
 static int32_t lastReport;
 
 //unit attack
 static int32_t lastReportUnitAttack;
-static std::map<int32_t,std::vector<int32_t>> reportToRelevantUnits;
+
+// units whose report logs include a report
+struct ReportUnits {
+    static constexpr size_t MAX_UNITS = 4;
+    int32_t units[MAX_UNITS];
+    // may exceed MAX_UNITS; only the first MAX_UNITS units are kept
+    uint8_t count = 0;
+};
+// indexed by report id - reportUnitsBase. reports that the game has discarded
+// are dropped from the front as new ones are added at the back.
+static std::deque<ReportUnits> reportToRelevantUnits;
+static int32_t reportUnitsBase = 0;
+// the newest report that has been looked for in the unit report logs
+static int32_t lastIndexedReport = -1;
 static int32_t reportToRelevantUnitsTime = -1;
 
 //interaction
@@ -315,8 +345,10 @@ void DFHack::EventManager::onStateChange(color_ostream& out, state_change_event
         tickQueue.clear();
         livingUnits.clear();
         buildings.clear();
-        constructions.clear();
+        constructionBlocks.clear();
+        stopConstructionFeed();
         equipmentLog.clear();
+        equipmentFingerprints.clear();
         activeUnits.clear();
 
         Buildings::clearBuildings(out);
@@ -356,21 +388,8 @@ void DFHack::EventManager::onStateChange(color_ostream& out, state_change_event
         nextInvasion = df::global::plotinfo->invasions.next_id;
         lastJobId = -1 + *df::global::job_next_id;
 
-        constructions.clear();
-        for (auto c : df::global::world->event.constructions) {
-            if ( !c ) {
-                if ( Once::doOnce("EventManager.onLoad null constr") ) {
-                    out.print("EventManager.onLoad: null construction.\n");
-                }
-                continue;
-            }
-            if (c->pos == df::coord() ) {
-                if ( Once::doOnce("EventManager.onLoad null position of construction.\n") )
-                    out.print("EventManager.onLoad null position of construction.\n");
-                continue;
-            }
-            constructions.emplace(*c);
-        }
+        constructionBlocks.clear();
+        trackAllConstructions(out);
         for (auto b : df::global::world->buildings.all) {
             Buildings::updateBuildings(out, (void*)intptr_t(b->id));
             buildings.insert(b->id);
@@ -394,6 +413,8 @@ void DFHack::EventManager::onStateChange(color_ostream& out, state_change_event
         lastReportInteraction = -1;
         reportToRelevantUnitsTime = -1;
         reportToRelevantUnits.clear();
+        reportUnitsBase = 0;
+        lastIndexedReport = -1;
         for (int &last_tick : eventLastTick) {
             last_tick = -1;//-1000000;
         }
@@ -419,6 +440,9 @@ void DFHack::EventManager::manageEvents(color_ostream& out) {
     int32_t tick = df::global::world->frame_counter;
     TRACE(log,out).print("processing events at tick {}\n", tick);
 
+    if (handlers[EventType::CONSTRUCTION].empty())
+        stopConstructionFeed();
+
     auto &core = Core::getInstance();
     auto &counters = core.perf_counters;
     for ( size_t a = 0; a < EventType::EVENT_MAX; a++ ) {
@@ -875,35 +899,144 @@ static void manageBuildingEvent(color_ostream& out) {
     });
 }
 
-static void manageConstructionEvent(color_ostream& out) {
-    if (!df::global::world)
-        return;
-    //unordered_set<df::construction*> constructionsNow(df::global::world->event.constructions.begin(), df::global::world->event.constructions.end());
+static uint64_t getConstructionBlockKey(const df::coord &pos) {
+    return (uint64_t(uint16_t(pos.z)) << 32)
+        | (uint64_t(uint16_t(pos.x >> 4)) << 16)
+        | uint16_t(pos.y >> 4);
+}
 
-    multimap<Plugin*, EventHandler> copy(handlers[EventType::CONSTRUCTION].begin(), handlers[EventType::CONSTRUCTION].end());
+static size_t getConstructionTileIndex(const df::coord &pos) {
+    return (pos.y & 15) * 16 + (pos.x & 15);
+}
 
-    unordered_set<df::construction> next_construction_set; // will be swapped with constructions
-    next_construction_set.reserve(constructions.bucket_count());
-    vector<df::construction> new_constructions;
+static ConstructionBlock & getConstructionBlock(const df::coord &pos) {
+    auto [it, inserted] = constructionBlocks.try_emplace(getConstructionBlockKey(pos));
+    if (inserted)
+        it->second.origin = df::coord(pos.x & ~15, pos.y & ~15, pos.z);
+    return it->second;
+}
+
+// Compares the tiles marked in block.current with the tracked ones, appending
+// copies of the removed and added constructions to the given vectors, if any.
+static void diffConstructionBlock(ConstructionBlock &block, vector<df::construction> *removed, vector<df::construction> *added) {
+    auto changed = block.tracked ^ block.current;
+    if (changed.any()) {
+        auto gone = changed & block.tracked;
+        if (gone.any()) {
+            auto keep = std::remove_if(block.copies.begin(), block.copies.end(), [&](const df::construction &copy) {
+                if (!gone.test(getConstructionTileIndex(copy.pos)))
+                    return false;
+                if (removed)
+                    removed->emplace_back(copy);
+                return true;
+            });
+            block.copies.erase(keep, block.copies.end());
+        }
+        auto appeared = changed & block.current;
+        for (size_t i = 0; appeared.any() && i < appeared.size(); i++) {
+            if (!appeared.test(i))
+                continue;
+            appeared.reset(i);
+            df::coord pos(block.origin.x + (i & 15), block.origin.y + (i >> 4), block.origin.z);
+            auto c = Constructions::findAtTile(pos);
+            if (!c) {
+                block.current.reset(i);
+                continue;
+            }
+            block.copies.emplace_back(*c);
+            if (added)
+                added->emplace_back(*c);
+        }
+        block.tracked = block.current;
+    }
+    block.current.reset();
+}
 
-    // find new constructions - swapping found constructions over from constructions to next_construction_set
+// Starts tracking the constructions in world->event.constructions from scratch.
+static void trackAllConstructions(color_ostream& out) {
+    constructionBlocks.clear();
+    // the vector is sorted by position, so consecutive constructions usually
+    // share a block
+    ConstructionBlock *block = nullptr;
+    uint64_t blockKey = 0;
     for (auto c : df::global::world->event.constructions) {
-        auto &construction = *c;
-        auto it = constructions.find(construction);
-        if (it == constructions.end()) {
-            // handle new construction event later
-            new_constructions.emplace_back(construction);
+        if ( !c ) {
+            if ( Once::doOnce("EventManager.onLoad null constr") ) {
+                out.print("EventManager.onLoad: null construction.\n");
+            }
+            continue;
+        }
+        if (c->pos == df::coord() ) {
+            if ( Once::doOnce("EventManager.onLoad null position of construction.\n") )
+                out.print("EventManager.onLoad null position of construction.\n");
+            continue;
         }
-        else {
-            constructions.erase(it);
+        uint64_t key = getConstructionBlockKey(c->pos);
+        if (!block || key != blockKey) {
+            block = &getConstructionBlock(c->pos);
+            blockKey = key;
         }
-        next_construction_set.emplace(construction);
+        block->current.set(getConstructionTileIndex(c->pos));
+    }
+    for (auto &[_, block] : constructionBlocks)
+        diffConstructionBlock(block, nullptr, nullptr);
+}
+
+// Brings the tracked constructions in the map blocks that changed since the
+// last pass up to date.
+static void updateChangedConstructions(vector<df::construction> *removed, vector<df::construction> *added) {
+    if (!constructionFeedSubscribed) {
+        // report everything that changed while nobody was listening
+        Maps::subscribeChanges(&constructionBlocks);
+        constructionFeedSubscribed = true;
+        constructionFeedCursor = 0;
     }
 
-    constructions.swap(next_construction_set);
+    vector<df::map_block *> blocks;
+    constructionFeedCursor = Maps::getChangedBlocks(constructionFeedCursor, blocks);
+    for (auto mapBlock : blocks) {
+        auto it = constructionBlocks.find(getConstructionBlockKey(mapBlock->map_pos));
+        ConstructionBlock *block = it == constructionBlocks.end() ? nullptr : &it->second;
+        // only constructed tiles and tracked ones can have a construction, so
+        // those are the only ones looked up in the constructions vector
+        for (size_t i = 0; i < 256; i++) {
+            int x = i & 15, y = i >> 4;
+            if (!(block && block->tracked.test(i))
+                    && tileMaterial(mapBlock->tiletype[x][y]) != tiletype_material::CONSTRUCTION)
+                continue;
+            df::coord pos = mapBlock->map_pos + df::coord(x, y, 0);
+            if (!Constructions::findAtTile(pos))
+                continue;
+            if (!block)
+                block = &getConstructionBlock(pos);
+            block->current.set(i);
+        }
+        if (!block)
+            continue;
+        diffConstructionBlock(*block, removed, added);
+        if (block->tracked.none())
+            constructionBlocks.erase(getConstructionBlockKey(block->origin));
+    }
+}
+
+static void stopConstructionFeed() {
+    if (!constructionFeedSubscribed)
+        return;
+    Maps::unsubscribeChanges(&constructionBlocks);
+    constructionFeedSubscribed = false;
+}
+
+static void manageConstructionEvent(color_ostream& out) {
+    if (!df::global::world)
+        return;
+
+    multimap<Plugin*, EventHandler> copy(handlers[EventType::CONSTRUCTION].begin(), handlers[EventType::CONSTRUCTION].end());
+
+    vector<df::construction> removed_constructions;
+    vector<df::construction> new_constructions;
+    updateChangedConstructions(&removed_constructions, &new_constructions);
 
-    // now next_construction_set contains all the constructions that were removed (not found in df::global::world->event.constructions)
-    for (auto& construction : next_construction_set) {
+    for (auto& construction : removed_constructions) {
         // handle construction removed event
         for (const auto &[_,handle]: copy) {
             DEBUG(log,out).print("calling handler for destroyed construction event\n");
@@ -969,115 +1102,137 @@ static void manageInvasionEvent(color_ostream& out) {
     }
 }
 
+// only the fields that are compared when diffing contribute. an empty
+// inventory hashes to 0, like a unit that has not been seen before.
+static uint64_t inventoryFingerprint(const df::unit *unit) {
+    if (unit->inventory.empty())
+        return 0;
+
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    };
+    for (auto dfitem : unit->inventory) {
+        mix(uint32_t(dfitem->item->id));
+        mix(uint32_t(dfitem->mode));
+        mix(uint32_t(dfitem->body_part_id));
+        mix(uint32_t(dfitem->wound_id));
+    }
+    return hash ? hash : 1;
+}
+
 static void manageEquipmentEvent(color_ostream& out) {
     if (!df::global::world)
         return;
     multimap<Plugin*,EventHandler> copy(handlers[EventType::INVENTORY_CHANGE].begin(), handlers[EventType::INVENTORY_CHANGE].end());
 
-    unordered_map<int32_t, InventoryItem> itemIdToInventoryItem;
-    unordered_set<int32_t> currentlyEquipped;
-
-    vector<InventoryChangeData> equipment_pickups;
-    vector<InventoryChangeData> equipment_drops;
-    vector<InventoryChangeData> equipment_changes;
-
+    struct PendingChange {
+        int32_t unitId;
+        ptrdiff_t item_old;
+        ptrdiff_t item_new;
+    };
 
-    // This vector stores the pointers to newly created changed items
-    // needed as the stack allocated temporary (in the loop) is lost when we go to
-    // handle the event calls, so we move that data to the heap if its needed,
-    // and then once we are done we delete everything.
-    vector<InventoryItem*> changed_items;
+    // These are kept between calls so that their storage is reused. The copies
+    // of changed items are only turned into pointers for the event data once
+    // all of them have been added, since the arena may move as it grows.
+    static vector<InventoryItem> changed_items;
+    static vector<PendingChange> pending_pickups;
+    static vector<PendingChange> pending_drops;
+    static vector<PendingChange> pending_changes;
+    static vector<InventoryChangeData> equipment_events;
+    changed_items.clear();
+    pending_pickups.clear();
+    pending_drops.clear();
+    pending_changes.clear();
+    equipment_events.clear();
+
+    auto keep = [&](const InventoryItem &item) -> ptrdiff_t {
+        changed_items.push_back(item);
+        return changed_items.size() - 1;
+    };
 
     for (auto unit : df::global::world->units.all) {
-        itemIdToInventoryItem.clear();
-        currentlyEquipped.clear();
-        /*if ( unit->flags1.bits.inactive )
+        if (unit->id < 0)
             continue;
-        */
+        size_t idx = unit->id;
+        if (idx >= equipmentFingerprints.size())
+            equipmentFingerprints.resize(idx + 1, 0);
 
-        auto oldEquipment = equipmentLog.find(unit->id);
-        bool hadEquipment = oldEquipment != equipmentLog.end();
-        vector<InventoryItem>* temp;
-        if ( hadEquipment ) {
-            temp = &((*oldEquipment).second);
-        } else {
-            temp = new vector<InventoryItem>;
-        }
-        //vector<InventoryItem>& v = (*oldEquipment).second;
-        vector<InventoryItem>& v = *temp;
-        for (auto & i : v) {
-            itemIdToInventoryItem[i.itemId] = i;
-        }
-        for ( size_t b = 0; b < unit->inventory.size(); b++ ) {
-            df::unit_inventory_item* dfitem_new = unit->inventory[b];
-            currentlyEquipped.insert(dfitem_new->item->id);
-            InventoryItem item_new(dfitem_new->item->id, *dfitem_new);
-            auto c = itemIdToInventoryItem.find(dfitem_new->item->id);
-            if ( c == itemIdToInventoryItem.end() ) {
+        uint64_t fingerprint = inventoryFingerprint(unit);
+        if (fingerprint == equipmentFingerprints[idx])
+            continue;
+        equipmentFingerprints[idx] = fingerprint;
+
+        // inventories are short, so linear searches beat building lookup tables
+        vector<InventoryItem>& equipment = equipmentLog[unit->id];
+        for (auto dfitem_new : unit->inventory) {
+            int32_t itemId = dfitem_new->item->id;
+            auto c = std::find_if(equipment.begin(), equipment.end(),
+                [&](const InventoryItem &i) { return i.itemId == itemId; });
+            if ( c == equipment.end() ) {
                 //new item equipped (probably just picked up)
-                changed_items.emplace_back(new InventoryItem(item_new));
-                equipment_pickups.emplace_back(unit->id, nullptr, changed_items.back());
+                pending_pickups.push_back({unit->id, -1, keep(InventoryItem(itemId, *dfitem_new))});
                 continue;
             }
-            InventoryItem item_old = c->second;
 
-            df::unit_inventory_item& item0 = item_old.item;
-            df::unit_inventory_item& item1 = item_new.item;
-            if ( item0.mode == item1.mode && item0.body_part_id == item1.body_part_id && item0.wound_id == item1.wound_id )
+            df::unit_inventory_item& item0 = c->item;
+            if ( item0.mode == dfitem_new->mode && item0.body_part_id == dfitem_new->body_part_id && item0.wound_id == dfitem_new->wound_id )
                 continue;
             //some sort of change in how it's equipped
-            changed_items.emplace_back(new InventoryItem(item_new));
-            InventoryItem* item_new_ptr = changed_items.back();
-            changed_items.emplace_back(new InventoryItem(item_old));
-            InventoryItem* item_old_ptr = changed_items.back();
-            equipment_changes.emplace_back(unit->id, item_old_ptr, item_new_ptr);
+            auto item_new = keep(InventoryItem(itemId, *dfitem_new));
+            auto item_old = keep(*c);
+            pending_changes.push_back({unit->id, item_old, item_new});
         }
         //check for dropped items
-        for (auto i : v) {
-            if ( currentlyEquipped.find(i.itemId) != currentlyEquipped.end() )
+        for (auto & i : equipment) {
+            if (std::any_of(unit->inventory.begin(), unit->inventory.end(),
+                    [&](df::unit_inventory_item *dfitem) { return dfitem->item->id == i.itemId; }))
                 continue;
             //TODO: delete ptr if invalid
-            changed_items.emplace_back(new InventoryItem(i));
-            equipment_drops.emplace_back(unit->id, changed_items.back(), nullptr);
+            pending_drops.push_back({unit->id, keep(i), -1});
         }
-        if ( !hadEquipment )
-            delete temp;
 
         //update equipment
-        vector<InventoryItem>& equipment = equipmentLog[unit->id];
         equipment.clear();
-        for (auto dfitem : unit->inventory) {
-            InventoryItem item(dfitem->item->id, *dfitem);
-            equipment.push_back(item);
-        }
+        for (auto dfitem : unit->inventory)
+            equipment.emplace_back(dfitem->item->id, *dfitem);
     }
 
+    if (changed_items.empty())
+        return;
+
+    auto resolve = [&](ptrdiff_t idx) -> InventoryItem* {
+        return idx < 0 ? nullptr : &changed_items[idx];
+    };
+    for (auto pending : {&pending_pickups, &pending_drops, &pending_changes})
+        for (auto &change : *pending)
+            equipment_events.emplace_back(change.unitId, resolve(change.item_old), resolve(change.item_new));
+
     // now handle events
-    std::for_each(equipment_pickups.begin(), equipment_pickups.end(), [&](InventoryChangeData& data) {
-        for (auto &[_, handle] : copy) {
-            DEBUG(log,out).print("calling handler for new item equipped inventory change event\n");
-            run_handler(out, EventType::INVENTORY_CHANGE, handle, (void*) &data);
-        }
-    });
-    std::for_each(equipment_drops.begin(), equipment_drops.end(), [&](InventoryChangeData& data) {
+    size_t num_pickups = pending_pickups.size(), num_drops = pending_drops.size();
+    for (size_t i = 0; i < equipment_events.size(); i++) {
+        auto &data = equipment_events[i];
         for (auto &[_, handle] : copy) {
-            DEBUG(log,out).print("calling handler for dropped item inventory change event\n");
+            if (i < num_pickups)
+                DEBUG(log,out).print("calling handler for new item equipped inventory change event\n");
+            else if (i < num_pickups + num_drops)
+                DEBUG(log,out).print("calling handler for dropped item inventory change event\n");
+            else
+                DEBUG(log,out).print("calling handler for inventory change event\n");
             run_handler(out, EventType::INVENTORY_CHANGE, handle, (void*) &data);
         }
-    });
-    std::for_each(equipment_changes.begin(), equipment_changes.end(), [&](InventoryChangeData& data) {
-        for (auto &[_, handle] : copy) {
-            DEBUG(log,out).print("calling handler for inventory change event\n");
-            run_handler(out, EventType::INVENTORY_CHANGE, handle, (void*) &data);
-        }
-    });
+    }
+}
 
-    // clean up changed items list
-    std::for_each(changed_items.begin(), changed_items.end(), [](InventoryItem* p){
-        delete p;
-    });
+static const ReportUnits *findReportUnits(int32_t report_id) {
+    if ( report_id < reportUnitsBase || report_id - reportUnitsBase >= (int32_t)reportToRelevantUnits.size() )
+        return nullptr;
+    return &reportToRelevantUnits[report_id - reportUnitsBase];
 }
 
+// adds the reports that are newer than the last call to the index. unit report
+// logs are appended to as reports are made, so only their tails are examined.
 static void updateReportToRelevantUnits() {
     if (!df::global::world)
         return;
@@ -1085,18 +1240,42 @@ static void updateReportToRelevantUnits() {
         return;
     reportToRelevantUnitsTime = df::global::world->frame_counter;
 
+    auto &reports = df::global::world->status.reports;
+    if ( reports.empty() || reports.back()->id <= lastIndexedReport )
+        return;
+    int32_t oldest = reports.front()->id;
+    int32_t newest = reports.back()->id;
+
+    // drop the slots of discarded reports and add slots for the new ones
+    while ( !reportToRelevantUnits.empty() && reportUnitsBase < oldest ) {
+        reportToRelevantUnits.pop_front();
+        reportUnitsBase++;
+    }
+    if ( reportToRelevantUnits.empty() )
+        reportUnitsBase = std::max(oldest, lastIndexedReport + 1);
+    while ( reportUnitsBase + (int32_t)reportToRelevantUnits.size() <= newest )
+        reportToRelevantUnits.emplace_back();
+
     for (auto unit : df::global::world->units.all) {
         for ( int16_t b = df::enum_traits<df::unit_report_type>::first_item_value; b <= df::enum_traits<df::unit_report_type>::last_item_value; b++ ) {
             if ( b == df::unit_report_type::Sparring )
                 continue;
-            for ( size_t c = 0; c < unit->reports.log[b].size(); c++ ) {
-                int32_t report = unit->reports.log[b][c];
-                if ( std::find(reportToRelevantUnits[report].begin(), reportToRelevantUnits[report].end(), unit->id) != reportToRelevantUnits[report].end() )
+            auto &log = unit->reports.log[b];
+            for ( size_t c = log.size(); c-- > 0 && log[c] > lastIndexedReport; ) {
+                if ( log[c] < reportUnitsBase || log[c] > newest )
+                    continue;
+                auto &entry = reportToRelevantUnits[log[c] - reportUnitsBase];
+                size_t kept = std::min<size_t>(entry.count, ReportUnits::MAX_UNITS);
+                if ( std::find(entry.units, entry.units + kept, unit->id) != entry.units + kept )
                     continue;
-                reportToRelevantUnits[unit->reports.log[b][c]].push_back(unit->id);
+                if ( kept < ReportUnits::MAX_UNITS )
+                    entry.units[kept] = unit->id;
+                if ( entry.count < UINT8_MAX )
+                    entry.count++;
             }
         }
     }
+    lastIndexedReport = newest;
 }
 
 static void manageReportEvent(color_ostream& out) {
@@ -1137,9 +1316,12 @@ static void manageUnitAttackEvent(color_ostream& out) {
     std::vector<df::report*>& reports = df::global::world->status.reports;
     size_t idx = df::report::binsearch_index(reports, lastReportUnitAttack, false);
     // returns the index to the key equal to or greater than the key provided
-    idx = reports[idx]->id == lastReportUnitAttack ? idx + 1 : idx; // we need the index after (where the new stuff is)
+    while (idx < reports.size() && reports[idx]->id <= lastReportUnitAttack) {
+        idx++; // we need the index after (where the new stuff is)
+    }
 
-    std::set<int32_t> strikeReports;
+    // reports are in id order, so these are too
+    std::vector<int32_t> strikeReports;
     for ( ; idx < reports.size(); idx++ ) {
         df::report* report = reports[idx];
         lastReportUnitAttack = report->id;
@@ -1147,7 +1329,7 @@ static void manageUnitAttackEvent(color_ostream& out) {
             continue;
         df::announcement_type type = report->type;
         if ( type == df::announcement_type::COMBAT_STRIKE_DETAILS ) {
-            strikeReports.insert(report->id);
+            strikeReports.push_back(report->id);
         }
     }
 
@@ -1171,13 +1353,15 @@ static void manageUnitAttackEvent(color_ostream& out) {
             reportStr += report2->text;
         }
 
-        std::vector<int32_t>& relevantUnits = reportToRelevantUnits[report->id];
-        if ( relevantUnits.size() != 2 ) {
+        auto relevantUnits = findReportUnits(report->id);
+        if ( !relevantUnits || relevantUnits->count != 2 ) {
             continue;
         }
 
-        df::unit* unit1 = df::unit::find(relevantUnits[0]);
-        df::unit* unit2 = df::unit::find(relevantUnits[1]);
+        df::unit* unit1 = df::unit::find(relevantUnits->units[0]);
+        df::unit* unit2 = df::unit::find(relevantUnits->units[1]);
+        if ( !unit1 || !unit2 )
+            continue;
 
         df::unit_wound* wound1 = getWound(unit1,unit2);
         df::unit_wound* wound2 = getWound(unit2,unit1);
@@ -1244,36 +1428,24 @@ static void manageUnitAttackEvent(color_ostream& out) {
     }
 }
 
-static std::string getVerb(df::unit* unit, const std::string &reportStr) {
-    std::string result(reportStr);
-    std::string name = unit->name.first_name + " ";
-    bool match = strncmp(result.c_str(), name.c_str(), name.length()) == 0;
-    if ( match ) {
-        result = result.substr(name.length());
-        result = result.substr(0,result.length()-1);
-        return result;
-    }
-    //use profession name
-    name = "The " + Units::getProfessionName(unit) + " ";
-    match = strncmp(result.c_str(), name.c_str(), name.length()) == 0;
-    if ( match ) {
-        result = result.substr(name.length());
-        result = result.substr(0,result.length()-1);
-        return result;
-    }
-
-    if ( unit->id != 0 ) {
+// returns the rest of the report after "<subject> " without its final period,
+// or an empty string if the report doesn't start with the subject
+static std::string getPredicate(std::string_view reportStr, std::string_view subject) {
+    if ( reportStr.size() <= subject.size() || !reportStr.starts_with(subject) || reportStr[subject.size()] != ' ' )
         return "";
-    }
+    auto rest = reportStr.substr(subject.size() + 1);
+    return std::string(rest.substr(0, rest.empty() ? 0 : rest.size() - 1));
+}
 
-    std::string you = "You ";
-    match = strncmp(result.c_str(), name.c_str(), name.length()) == 0;
-    if ( match ) {
-        result = result.substr(name.length());
-        result = result.substr(0,result.length()-1);
-        return result;
-    }
-    return "";
+static std::string getVerb(df::unit* unit, const std::string &reportStr) {
+    std::string verb = getPredicate(reportStr, unit->name.first_name);
+    if ( !verb.empty() )
+        return verb;
+    //use profession name
+    verb = getPredicate(reportStr, "The " + Units::getProfessionName(unit));
+    if ( !verb.empty() || unit->id != 0 )
+        return verb;
+    return getPredicate(reportStr, "You");
 }
 
 static InteractionData getAttacker(color_ostream& out, df::report* attackEvent, df::unit* lastAttacker, df::report* defendEvent, vector<df::unit*>& relevantUnits) {
@@ -1400,17 +1572,22 @@ static vector<df::unit*> gatherRelevantUnits(color_ostream& out, df::report* r1,
 //out.print("%s,%d\n",__FILE__,__LINE__);
     for (auto report : reports) {
 //out.print("%s,%d\n",__FILE__,__LINE__);
-        vector<int32_t>& units = reportToRelevantUnits[report->id];
-        if ( units.size() > 2 ) {
+        auto units = findReportUnits(report->id);
+        if ( !units )
+            continue;
+        if ( units->count > 2 ) {
             if ( Once::doOnce("EventManager interaction too many relevant units") ) {
                 out.print("{},{}: too many relevant units. On report\n \'{}\'\n", __FILE__, __LINE__, report->text);
             }
         }
-        for (int & unit_id : units)
+        size_t kept = std::min<size_t>(units->count, ReportUnits::MAX_UNITS);
+        for (size_t i = 0; i < kept; i++) {
+            int32_t unit_id = units->units[i];
             if (ids.find(unit_id) == ids.end() ) {
                 ids.insert(unit_id);
                 result.push_back(df::unit::find(unit_id));
             }
+        }
     }
 //out.print("%s,%d\n",__FILE__,__LINE__);
     return result;
@@ -36,6 +36,7 @@ distribution.
 #include "modules/Items.h"
 #include "modules/Job.h"
 #include "modules/Materials.h"
+#include "modules/Raws.h"
 #include "modules/Translation.h"
 #include "modules/Units.h"
 #include "modules/World.h"
@@ -197,27 +198,15 @@ bool ItemTypeInfo::find(const string &token)
     if (items.size() == 1)
         return true;
 
-    auto &defs = world->raws.itemdefs;
-    switch (type)
-    {
-#define ITEM(type,vec,tclass) \
-    case type: \
-        for (size_t i = 0; i < defs.vec.size(); i++) { \
-            if (defs.vec[i]->id == items[1]) { \
-                subtype = i; custom = defs.vec[i]; return true; \
-            } \
-        } \
-        break;
-ITEMDEF_VECTORS
-#undef ITEM
+    if (Items::getSubtypeCount(type) < 0)
+        return items[1] == "NONE";
 
-    default:
-        if (items[1] == "NONE")
-            return true;
-        break;
-    }
-
-    return (subtype >= 0);
+    int32_t idx = Raws::findItemSubtype(type, items[1]);
+    if (idx < 0)
+        return false;
+    subtype = idx;
+    custom = Items::getSubtypeDef(type, idx);
+    return true;
 }
 
 bool ItemTypeInfo::matches(df::job_item_vector_id vec_id) {
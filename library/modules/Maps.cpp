@@ -37,6 +37,7 @@ distribution.
 #include "modules/Buildings.h"
 #include "modules/MapCache.h"
 #include "modules/Maps.h"
+#include "modules/Units.h"
 
 #include "df/biome_type.h"
 #include "df/block_burrow.h"
@@ -60,6 +61,7 @@ distribution.
 #include "df/plant_root_tile.h"
 #include "df/plant_tree_info.h"
 #include "df/plant_tree_tile.h"
+#include "df/plotinfost.h"
 #include "df/region_map_entry.h"
 #include "df/world.h"
 #include "df/world_data.h"
@@ -74,6 +76,7 @@ distribution.
 #include <map>
 #include <set>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 using std::max;
@@ -1523,3 +1526,421 @@ int Maps::removeAreaAquifer(df::coord pos1, df::coord pos2, std::function<bool(d
 
     return totalAffectedCount;
 }
+
+/*
+ * Map change feed
+ */
+
+// blocks checked per update by the rotating scan
+static const size_t CHANGE_SCAN_BLOCKS_PER_UPDATE = 512;
+// blocks that changed within this many updates are checked on every update
+static const uint32_t CHANGE_HOT_UPDATES = 100;
+
+struct BlockChangeState {
+    uint64_t hash = 0;
+    Maps::MapGeneration generation = 0;
+    uint32_t checked = 0; // update in which the block was last hashed
+    uint32_t changed = 0; // update in which the hash last changed
+    bool hot = false;
+};
+
+struct MapChangeFeed {
+    std::set<const void *> subscribers;
+
+    int32_t x_blocks = 0, y_blocks = 0, z_levels = 0;
+    std::vector<BlockChangeState> blocks;
+    bool need_baseline = true;
+
+    uint32_t update = 0;
+    Maps::MapGeneration generation = 0;
+    size_t scan_pos = 0;
+    std::vector<int> hot;
+    std::vector<int> marked;
+
+    // (generation, block) for every change after log_start, in order
+    std::vector<std::pair<Maps::MapGeneration, int>> log;
+    Maps::MapGeneration log_start = 0;
+
+    int block_index(const df::coord &map_pos) const {
+        int bx = map_pos.x >> 4, by = map_pos.y >> 4;
+        if (map_pos.x < 0 || map_pos.y < 0 || map_pos.z < 0 ||
+                bx >= x_blocks || by >= y_blocks || map_pos.z >= z_levels)
+            return -1;
+        return (map_pos.z * y_blocks + by) * x_blocks + bx;
+    }
+
+    df::map_block *get_block(int idx) const {
+        return Maps::getBlock(idx % x_blocks, (idx / x_blocks) % y_blocks, idx / (x_blocks * y_blocks));
+    }
+
+    void reset() {
+        x_blocks = y_blocks = z_levels = 0;
+        blocks.clear();
+        hot.clear();
+        marked.clear();
+        log.clear();
+        scan_pos = 0;
+        need_baseline = true;
+    }
+};
+
+static MapChangeFeed change_feed;
+
+// Hashes 64-bit words in four independent lanes so that the loop can be
+// vectorized. Each step is a bijection of the lane value, so a change to any
+// single word always changes the result.
+static inline void hash_words(uint64_t lanes[4], const void *data, size_t bytes, uint64_t mask = ~uint64_t(0))
+{
+    auto bytes_in = (const uint8_t *)data;
+    for (size_t i = 0; i + 32 <= bytes; i += 32) {
+        uint64_t words[4];
+        memcpy(words, bytes_in + i, sizeof(words));
+        for (int l = 0; l < 4; l++)
+            lanes[l] = (lanes[l] ^ (words[l] & mask)) * 0x100000001b3ULL;
+    }
+}
+
+static uint64_t hash_block(df::map_block *block)
+{
+    if (!block)
+        return 0;
+
+    // units walking around are not map changes
+    df::tile_occupancy ignored;
+    ignored.whole = 0;
+    ignored.bits.unit = 1;
+    ignored.bits.unit_grounded = 1;
+    uint64_t occ_mask = ~((uint64_t(ignored.whole) << 32) | ignored.whole);
+
+    static_assert(sizeof(block->tiletype) % 32 == 0);
+    static_assert(sizeof(block->designation) % 32 == 0);
+    static_assert(sizeof(block->occupancy) % 32 == 0);
+    static_assert(sizeof(df::tile_occupancy) == 4);
+
+    uint64_t lanes[4] = { 0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL,
+                          0x9e3779b97f4a7c15ULL, 0x7f4a7c159e3779b9ULL };
+    hash_words(lanes, block->tiletype, sizeof(block->tiletype));
+    hash_words(lanes, block->designation, sizeof(block->designation));
+    hash_words(lanes, block->occupancy, sizeof(block->occupancy), occ_mask);
+
+    uint64_t hash = lanes[0] ^ (lanes[1] * 31) ^ (lanes[2] * 961) ^ (lanes[3] * 29791);
+    // reserve 0 for missing blocks
+    return hash ? hash : 1;
+}
+
+static void change_feed_baseline()
+{
+    auto &feed = change_feed;
+    feed.reset();
+    Maps::getSize(feed.x_blocks, feed.y_blocks, feed.z_levels);
+    if (feed.x_blocks <= 0 || feed.y_blocks <= 0 || feed.z_levels <= 0) {
+        feed.reset();
+        return;
+    }
+    feed.blocks.resize(size_t(feed.x_blocks) * feed.y_blocks * feed.z_levels);
+    feed.generation++;
+    for (size_t idx = 0; idx < feed.blocks.size(); idx++) {
+        auto &state = feed.blocks[idx];
+        state.hash = hash_block(feed.get_block(idx));
+        state.generation = feed.generation;
+    }
+    // the log only holds changes after the baseline, so any earlier
+    // cursor is answered by scanning the block states
+    feed.log_start = feed.generation;
+    feed.need_baseline = false;
+}
+
+static void change_feed_update()
+{
+    auto &feed = change_feed;
+
+    int32_t x, y, z;
+    Maps::getSize(x, y, z);
+    if (feed.need_baseline || x != feed.x_blocks || y != feed.y_blocks || z != feed.z_levels) {
+        change_feed_baseline();
+        return;
+    }
+
+    uint32_t update = ++feed.update;
+    std::vector<int> changed;
+    auto check = [&](int idx) {
+        auto &state = feed.blocks[idx];
+        if (state.checked == update)
+            return;
+        state.checked = update;
+        uint64_t hash = hash_block(feed.get_block(idx));
+        if (hash != state.hash) {
+            state.hash = hash;
+            changed.push_back(idx);
+        }
+    };
+
+    for (int idx : feed.marked)
+        check(idx);
+    feed.marked.clear();
+
+    for (size_t i = 0; i < feed.hot.size(); ) {
+        int idx = feed.hot[i];
+        auto &state = feed.blocks[idx];
+        if (update - state.changed > CHANGE_HOT_UPDATES) {
+            state.hot = false;
+            feed.hot[i] = feed.hot.back();
+            feed.hot.pop_back();
+            continue;
+        }
+        check(idx);
+        i++;
+    }
+
+    size_t count = std::min(CHANGE_SCAN_BLOCKS_PER_UPDATE, feed.blocks.size());
+    for (size_t i = 0; i < count; i++) {
+        if (feed.scan_pos >= feed.blocks.size())
+            feed.scan_pos = 0;
+        check(feed.scan_pos++);
+    }
+
+    if (changed.empty())
+        return;
+
+    feed.generation++;
+    for (int idx : changed) {
+        auto &state = feed.blocks[idx];
+        state.generation = feed.generation;
+        state.changed = update;
+        if (!state.hot) {
+            state.hot = true;
+            feed.hot.push_back(idx);
+        }
+        feed.log.emplace_back(feed.generation, idx);
+    }
+
+    // drop the older half of the log, keeping whole generations; queries
+    // older than that fall back to scanning the block states
+    if (feed.log.size() > std::max<size_t>(4096, feed.blocks.size())) {
+        auto cut_gen = feed.log[feed.log.size() / 2].first;
+        auto cut = std::lower_bound(feed.log.begin(), feed.log.end(), cut_gen,
+            [](const std::pair<Maps::MapGeneration, int> &entry, Maps::MapGeneration gen) {
+                return entry.first < gen;
+            });
+        feed.log.erase(feed.log.begin(), cut);
+        feed.log_start = cut_gen - 1;
+    }
+}
+
+struct WalkableGroupCache {
+    Maps::WalkableGroupSet groups;
+    bool valid = false;
+    int32_t computed_frame = -1;
+    // for the entrance cache: the map generation seen at the last check and
+    // the frame in which it last changed
+    Maps::MapGeneration generation = 0;
+    int32_t change_frame = -1;
+
+    void reset() {
+        groups.clear();
+        valid = false;
+        computed_frame = change_frame = -1;
+        generation = 0;
+    }
+};
+
+static WalkableGroupCache entrance_groups;
+static WalkableGroupCache citizen_groups;
+
+void maps_onStateChange(color_ostream &out, state_change_event event)
+{
+    switch (event) {
+    case SC_MAP_LOADED:
+    case SC_MAP_UNLOADED:
+        change_feed.reset();
+        if (entrance_groups.valid)
+            Maps::unsubscribeChanges(&entrance_groups);
+        entrance_groups.reset();
+        citizen_groups.reset();
+        break;
+    default:
+        break;
+    }
+}
+
+void maps_onUpdate(color_ostream &out)
+{
+    if (change_feed.subscribers.empty() || !Maps::IsValid())
+        return;
+    change_feed_update();
+}
+
+void Maps::subscribeChanges(const void *owner)
+{
+    change_feed.subscribers.insert(owner);
+}
+
+void Maps::unsubscribeChanges(const void *owner)
+{
+    change_feed.subscribers.erase(owner);
+    if (change_feed.subscribers.empty())
+        change_feed.reset();
+}
+
+Maps::MapGeneration Maps::getMapGeneration()
+{
+    return change_feed.generation;
+}
+
+Maps::MapGeneration Maps::getBlockGeneration(df::map_block *block)
+{
+    CHECK_NULL_POINTER(block);
+    int idx = change_feed.block_index(block->map_pos);
+    return idx < 0 ? 0 : change_feed.blocks[idx].generation;
+}
+
+Maps::MapGeneration Maps::getChangedBlocks(MapGeneration since, std::vector<df::map_block *> &blocks)
+{
+    auto &feed = change_feed;
+    if (feed.need_baseline || !IsValid())
+        return since;
+
+    if (since < feed.log_start) {
+        for (size_t idx = 0; idx < feed.blocks.size(); idx++) {
+            if (feed.blocks[idx].generation <= since)
+                continue;
+            if (auto block = feed.get_block(idx))
+                blocks.push_back(block);
+        }
+        return feed.generation;
+    }
+
+    auto it = std::upper_bound(feed.log.begin(), feed.log.end(), since,
+        [](Maps::MapGeneration gen, const std::pair<Maps::MapGeneration, int> &entry) {
+            return gen < entry.first;
+        });
+    for (; it != feed.log.end(); ++it) {
+        // a block that changed several times is reported for its latest change only
+        if (feed.blocks[it->second].generation != it->first)
+            continue;
+        if (auto block = feed.get_block(it->second))
+            blocks.push_back(block);
+    }
+    return feed.generation;
+}
+
+void Maps::markBlockChanged(df::map_block *block)
+{
+    CHECK_NULL_POINTER(block);
+    if (change_feed.subscribers.empty())
+        return;
+    int idx = change_feed.block_index(block->map_pos);
+    if (idx >= 0)
+        change_feed.marked.push_back(idx);
+}
+
+bool Maps::WalkableGroupSet::add(df::coord pos)
+{
+    auto group = getWalkableGroup(pos);
+    if (!group)
+        return false;
+    groups.insert(group);
+    return true;
+}
+
+void Maps::WalkableGroupSet::add(const std::vector<df::coord> &sources)
+{
+    for (auto &pos : sources)
+        add(pos);
+}
+
+bool Maps::WalkableGroupSet::canReach(df::coord pos) const
+{
+    return contains(getWalkableGroup(pos));
+}
+
+size_t Maps::WalkableGroupSet::canReach(const std::vector<df::coord> &positions, std::vector<bool> &reachable) const
+{
+    reachable.assign(positions.size(), false);
+    if (groups.empty())
+        return 0;
+
+    // consecutive positions are usually in the same block
+    size_t count = 0;
+    df::map_block *block = NULL;
+    df::coord block_pos(-1, -1, -1);
+    for (size_t i = 0; i < positions.size(); i++) {
+        auto &pos = positions[i];
+        df::coord bpos(pos.x & ~15, pos.y & ~15, pos.z);
+        if (bpos != block_pos) {
+            block = getTileBlock(pos);
+            block_pos = bpos;
+        }
+        if (block && contains(index_tile(block->walkable, pos))) {
+            reachable[i] = true;
+            count++;
+        }
+    }
+    return count;
+}
+
+static const int32_t ENTRANCE_REFRESH_TICKS = 100;
+
+const Maps::WalkableGroupSet &Maps::getEntranceWalkableGroups()
+{
+    using df::global::plotinfo;
+
+    auto &cache = entrance_groups;
+    if (!IsValid() || !world || !plotinfo) {
+        cache.groups.clear();
+        return cache.groups;
+    }
+
+    if (!cache.valid)
+        subscribeChanges(&cache);
+
+    int32_t frame = world->frame_counter;
+    auto generation = getMapGeneration();
+    if (generation != cache.generation) {
+        cache.generation = generation;
+        cache.change_frame = frame;
+    }
+
+    // DF updates walkable groups on the tick after the map changes, so a
+    // change needs one more recompute once the game has advanced past it
+    if (cache.valid && frame - cache.computed_frame < ENTRANCE_REFRESH_TICKS &&
+            (cache.computed_frame > cache.change_frame || frame == cache.change_frame))
+        return cache.groups;
+
+    uint32_t count_x, count_y, count_z;
+    getTileSize(count_x, count_y, count_z);
+    auto &edge = plotinfo->map_edge;
+    size_t num_edge_tiles = std::min(edge.surface_x.size(),
+        std::min(edge.surface_y.size(), edge.surface_z.size()));
+
+    cache.groups.clear();
+    for (size_t idx = 0; idx < num_edge_tiles; ++idx) {
+        df::coord pos(edge.surface_x[idx], edge.surface_y[idx], edge.surface_z[idx]);
+        if (pos.x == 0 || pos.y == 0 || pos.x == int32_t(count_x) - 1 || pos.y == int32_t(count_y) - 1)
+            cache.groups.add(pos);
+    }
+    cache.valid = true;
+    cache.computed_frame = frame;
+    return cache.groups;
+}
+
+const Maps::WalkableGroupSet &Maps::getCitizenWalkableGroups()
+{
+    auto &cache = citizen_groups;
+    if (!IsValid() || !world) {
+        cache.groups.clear();
+        return cache.groups;
+    }
+
+    int32_t frame = world->frame_counter;
+    if (cache.valid && cache.computed_frame == frame)
+        return cache.groups;
+
+    cache.groups.clear();
+    Units::forCitizens([&](df::unit *unit) {
+        cache.groups.add(Units::getPosition(unit));
+    });
+    cache.valid = true;
+    cache.computed_frame = frame;
+    return cache.groups;
+}
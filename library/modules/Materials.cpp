@@ -25,6 +25,7 @@ distribution.
 #include "Internal.h"
 #include "Types.h"
 #include "modules/Materials.h"
+#include "modules/Raws.h"
 #include "VersionInfo.h"
 #include "MemAccess.h"
 #include "Error.h"
@@ -236,13 +237,9 @@ bool MaterialInfo::findInorganic(const std::string &token)
         return true;
     }
 
-    auto &raws = world->raws;
-    for (size_t i = 0; i < raws.inorganics.all.size(); i++)
-    {
-        df::inorganic_raw *p = raws.inorganics.all[i];
-        if (p->id == token)
-            return decode(0, i);
-    }
+    int32_t i = Raws::findInorganic(token);
+    if (i >= 0)
+        return decode(0, i);
     return decode(-1);
 }
 
@@ -250,23 +247,19 @@ bool MaterialInfo::findPlant(const std::string &token, const std::string &subtok
 {
     if (token.empty())
         return decode(-1);
-    auto &raws = world->raws;
-    for (size_t i = 0; i < raws.plants.all.size(); i++)
-    {
-        df::plant_raw *p = raws.plants.all[i];
-        if (p->id != token)
-            continue;
+    int32_t i = Raws::findPlant(token);
+    if (i < 0)
+        return decode(-1);
+    df::plant_raw *p = world->raws.plants.all[i];
 
-        // As a special exception, return the structural material with empty subtoken
-        if (subtoken.empty())
-            return decode(p->material_defs.type[plant_material_def::basic_mat], p->material_defs.idx[plant_material_def::basic_mat]);
+    // As a special exception, return the structural material with empty subtoken
+    if (subtoken.empty())
+        return decode(p->material_defs.type[plant_material_def::basic_mat], p->material_defs.idx[plant_material_def::basic_mat]);
 
-        for (size_t j = 0; j < p->material.size(); j++)
-            if (p->material[j]->id == subtoken)
-                return decode(PLANT_BASE+j, i);
+    for (size_t j = 0; j < p->material.size(); j++)
+        if (p->material[j]->id == subtoken)
+            return decode(PLANT_BASE+j, i);
 
-        break;
-    }
     return decode(-1);
 }
 
@@ -274,19 +267,15 @@ bool MaterialInfo::findCreature(const std::string &token, const std::string &sub
 {
     if (token.empty() || subtoken.empty())
         return decode(-1);
-    auto &raws = world->raws;
-    for (size_t i = 0; i < raws.creatures.all.size(); i++)
-    {
-        df::creature_raw *p = raws.creatures.all[i];
-        if (p->creature_id != token)
-            continue;
+    int32_t i = Raws::findCreature(token);
+    if (i < 0)
+        return decode(-1);
+    df::creature_raw *p = world->raws.creatures.all[i];
 
-        for (size_t j = 0; j < p->material.size(); j++)
-            if (p->material[j]->id == subtoken)
-                return decode(CREATURE_BASE+j, i);
+    for (size_t j = 0; j < p->material.size(); j++)
+        if (p->material[j]->id == subtoken)
+            return decode(CREATURE_BASE+j, i);
 
-        break;
-    }
     return decode(-1);
 }
 
@@ -40,7 +40,13 @@ distribution.
 
 #include <json/json.h>
 
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace DFHack {
     DBG_DECLARE(core, persistence, DebugCategory::LINFO);
@@ -48,24 +54,178 @@ namespace DFHack {
 
 using namespace DFHack;
 
-static std::unordered_map<int, std::multimap<std::string, std::shared_ptr<Persistence::DataEntry>>> store;
-static std::unordered_map<size_t, std::shared_ptr<Persistence::DataEntry>> entry_cache;
+// entries are keyed by views into the interned key storage below, and the
+// transparent comparator lets lookups by string_view avoid allocating
+typedef std::multimap<std::string_view, std::shared_ptr<Persistence::DataEntry>, std::less<>> entity_store_t;
+static std::unordered_map<int, entity_store_t> store;
+// secondary index by interned key id for callers that hold a KeyId
+static std::unordered_map<int, std::unordered_map<Persistence::KeyId, std::vector<std::shared_ptr<Persistence::DataEntry>>>> key_id_index;
+
+// interned keys are never freed so that KeyIds held by plugins stay valid
+// across world loads. std::deque keeps references stable as it grows.
+static std::deque<std::string> interned_keys;
+static std::unordered_map<std::string_view, Persistence::KeyId> interned_key_ids;
 
 static uint32_t lastLoadSaveTickCount = 0;
 
+// entities whose set of entries has changed since the last save
+static std::unordered_set<int> dirty_entities;
+// encoded file contents from the last save, reused when an entity is unchanged
+static std::unordered_map<int, std::string> entity_snapshots;
+
+// binary save file layout: the magic header followed by a stream of records,
+// each prefixed with its uint32 length. a truncated or malformed record makes
+// the whole file unloadable, like a malformed JSON file.
+static const char BINARY_MAGIC[] = "DFHKPST1";
+static const size_t BINARY_MAGIC_LEN = sizeof(BINARY_MAGIC) - 1;
+
 size_t next_entry_id = 0;   // goes more positive
 int next_fake_df_id = -101; // goes more negative
 
+static void append_u32(std::string &buf, uint32_t val) {
+    buf.append(reinterpret_cast<const char *>(&val), sizeof(val));
+}
+
+static void append_str(std::string &buf, const std::string &str) {
+    append_u32(buf, str.size());
+    buf.append(str);
+}
+
+static bool read_u32(const char *&p, const char *end, uint32_t &val) {
+    if (size_t(end - p) < sizeof(val))
+        return false;
+    memcpy(&val, p, sizeof(val));
+    p += sizeof(val);
+    return true;
+}
+
+static bool read_str(const char *&p, const char *end, std::string &str) {
+    uint32_t len;
+    if (!read_u32(p, end, len) || size_t(end - p) < len)
+        return false;
+    str.assign(p, len);
+    p += len;
+    return true;
+}
+
+static bool read_blob(const char *&p, const char *end, std::vector<uint8_t> &blob) {
+    uint32_t len;
+    if (!read_u32(p, end, len) || size_t(end - p) < len)
+        return false;
+    blob.assign(p, p + len);
+    p += len;
+    return true;
+}
+
+void Persistence::Binary::appendRecord(std::string &buf, const Record &record) {
+    std::string payload;
+    append_str(payload, record.key);
+    append_u32(payload, uint32_t(record.fake_df_id < 0 ? record.fake_df_id : 0));
+    append_str(payload, record.str_value);
+    append_u32(payload, record.int_values.size());
+    for (int val : record.int_values)
+        append_u32(payload, uint32_t(val));
+    // the blob is optional at the end of the record
+    if (record.blob_value.size()) {
+        append_u32(payload, record.blob_value.size());
+        payload.append(reinterpret_cast<const char *>(record.blob_value.data()), record.blob_value.size());
+    }
+    append_str(buf, payload);
+}
+
+static bool read_record(const std::string &payload, Persistence::Binary::Record &record) {
+    const char *p = payload.data();
+    const char *end = p + payload.size();
+    uint32_t fake_df_id, num_ints;
+    if (!read_str(p, end, record.key) || !read_u32(p, end, fake_df_id)
+            || !read_str(p, end, record.str_value) || !read_u32(p, end, num_ints))
+        return false;
+    record.fake_df_id = int(fake_df_id);
+    record.int_values.clear();
+    for (size_t i = 0; i < num_ints; i++) {
+        uint32_t val;
+        if (!read_u32(p, end, val))
+            return false;
+        record.int_values.push_back(int(val));
+    }
+    record.blob_value.clear();
+    return p == end || (read_blob(p, end, record.blob_value) && p == end);
+}
+
+bool Persistence::Binary::readRecords(std::string_view contents, std::vector<Record> &records) {
+    records.clear();
+    const char *p = contents.data();
+    const char *end = p + contents.size();
+    std::string payload;
+    while (p < end) {
+        if (!read_str(p, end, payload) || !read_record(payload, records.emplace_back()))
+            return false;
+    }
+    return true;
+}
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static std::string blob_to_hex(const std::vector<uint8_t> &blob) {
+    std::string hex;
+    hex.reserve(blob.size() * 2);
+    for (uint8_t b : blob) {
+        hex.push_back(HEX_DIGITS[b >> 4]);
+        hex.push_back(HEX_DIGITS[b & 0xf]);
+    }
+    return hex;
+}
+
+static std::vector<uint8_t> hex_to_blob(const std::string &hex) {
+    auto nibble = [](char c) -> uint8_t {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return 0;
+    };
+    std::vector<uint8_t> blob(hex.size() / 2);
+    for (size_t i = 0; i < blob.size(); i++)
+        blob[i] = (nibble(hex[i*2]) << 4) | nibble(hex[i*2+1]);
+    return blob;
+}
+
+Persistence::KeyId Persistence::internKey(std::string_view key) {
+    CoreSuspender suspend;
+
+    auto it = interned_key_ids.find(key);
+    if (it != interned_key_ids.end())
+        return it->second;
+
+    KeyId id = interned_keys.size();
+    const std::string &interned = interned_keys.emplace_back(key);
+    interned_key_ids.emplace(interned, id);
+    return id;
+}
+
 struct Persistence::DataEntry {
     const size_t entry_id;
     const int entity_id;
-    const std::string key;
+    const KeyId key_id;
+    const std::string &key;
     int fake_df_id;
     std::string str_value;
     std::array<int, PersistentDataItem::NumInts> int_values;
-
-    explicit DataEntry(int entity_id, const std::string &key)
-    : entry_id(next_entry_id++), entity_id(entity_id), key(key) {
+    std::vector<uint8_t> blob_value;
+
+    // cleared when the entry is deleted or the world is unloaded
+    std::atomic<bool> valid = true;
+
+    // set when the entry has been modified since it was last encoded
+    bool dirty = true;
+    // set once a mutable reference to a value has been handed out. the holder
+    // can write through it at any time, so the entry is re-encoded and
+    // compared with its previous record on every save.
+    bool mutable_access = false;
+    // length-prefixed binary record from the last encoding
+    std::string encoded;
+
+    explicit DataEntry(int entity_id, std::string_view key)
+    : entry_id(next_entry_id++), entity_id(entity_id), key_id(internKey(key)), key(interned_keys[key_id]) {
         fake_df_id = 0;
         for (size_t i = 0; i < PersistentDataItem::NumInts; i++)
             int_values.at(i) = -1;
@@ -80,6 +240,8 @@ struct Persistence::DataEntry {
             for (size_t i = 0; i < PersistentDataItem::NumInts; i++)
                 int_values.at(i) = json["i"].get(i, Json::Value(-1)).asInt();
         }
+        if (json.isMember("b"))
+            blob_value = hex_to_blob(json["b"].asString());
     }
 
     Json::Value toJSON() const {
@@ -89,20 +251,63 @@ struct Persistence::DataEntry {
             json["f"] = fake_df_id;
         if (str_value.size())
             json["s"] = str_value;
-        size_t num_set_ints = 0;
-        for (size_t i = 0; i < PersistentDataItem::NumInts; i++) {
-            if (int_values.at(i) != -1)
-                num_set_ints = i + 1;
-        }
+        size_t num_set_ints = getNumSetInts();
         if (num_set_ints) {
             Json::Value ints(Json::arrayValue);
             for (size_t i = 0; i < num_set_ints; i++)
                 ints.append(int_values.at(i));
             json["i"] = std::move(ints);
         }
+        if (blob_value.size())
+            json["b"] = blob_to_hex(blob_value);
         return json;
     }
 
+    size_t getNumSetInts() const {
+        size_t num_set_ints = 0;
+        for (size_t i = 0; i < PersistentDataItem::NumInts; i++) {
+            if (int_values.at(i) != -1)
+                num_set_ints = i + 1;
+        }
+        return num_set_ints;
+    }
+
+    Binary::Record toRecord() const {
+        Binary::Record record;
+        record.key = key;
+        record.fake_df_id = fake_df_id;
+        record.str_value = str_value;
+        record.int_values.assign(int_values.begin(), int_values.begin() + getNumSetInts());
+        record.blob_value = blob_value;
+        return record;
+    }
+
+    // re-encodes the entry if it may have changed. returns whether the record
+    // differs from the previous encoding.
+    bool updateEncoded() {
+        if (!dirty && !mutable_access)
+            return false;
+        std::string record;
+        Binary::appendRecord(record, toRecord());
+        dirty = false;
+        if (record == encoded)
+            return false;
+        encoded = std::move(record);
+        return true;
+    }
+
+    static std::shared_ptr<DataEntry> fromRecord(int entity_id, Binary::Record &record) {
+        std::shared_ptr<DataEntry> entry(new DataEntry(entity_id, record.key));
+        entry->fake_df_id = record.fake_df_id;
+        entry->str_value = std::move(record.str_value);
+        for (size_t i = 0; i < record.int_values.size() && i < PersistentDataItem::NumInts; i++)
+            entry->int_values.at(i) = record.int_values[i];
+        entry->blob_value = std::move(record.blob_value);
+        Binary::appendRecord(entry->encoded, entry->toRecord());
+        entry->dirty = false;
+        return entry;
+    }
+
     bool isReferencedBy(const PersistentDataItem & item) {
         return item.data.get() == this;
     }
@@ -122,6 +327,7 @@ const std::string &PersistentDataItem::key() const
 std::string &PersistentDataItem::val()
 {
     CHECK_INVALID_ARGUMENT(isValid());
+    data->mutable_access = true;
     return data->str_value;
 }
 const std::string &PersistentDataItem::val() const
@@ -133,6 +339,7 @@ int &PersistentDataItem::ival(int i)
 {
     CHECK_INVALID_ARGUMENT(isValid());
     CHECK_INVALID_ARGUMENT(i >= 0 && i < (int)NumInts);
+    data->mutable_access = true;
     return data->int_values.at(i);
 }
 int PersistentDataItem::ival(int i) const
@@ -141,20 +348,26 @@ int PersistentDataItem::ival(int i) const
     CHECK_INVALID_ARGUMENT(i >= 0 && i < (int)NumInts);
     return data->int_values.at(i);
 }
+std::vector<uint8_t> &PersistentDataItem::blob()
+{
+    CHECK_INVALID_ARGUMENT(isValid());
+    data->mutable_access = true;
+    return data->blob_value;
+}
+const std::vector<uint8_t> &PersistentDataItem::blob() const
+{
+    CHECK_INVALID_ARGUMENT(isValid());
+    return data->blob_value;
+}
 
 const std::string & PersistentDataItem::get_str() {
     static const std::string empty;
-    return isValid() ? val() : empty;
+    return isValid() ? data->str_value : empty;
 }
 
 bool PersistentDataItem::isValid() const
 {
-    if (data == nullptr)
-        return false;
-
-    CoreSuspender suspend;
-
-    return entry_cache.contains(data->entry_id) && entry_cache.at(data->entry_id) == data;
+    return data != nullptr && data->valid;
 }
 
 int PersistentDataItem::fake_df_id() {
@@ -162,17 +375,45 @@ int PersistentDataItem::fake_df_id() {
         return 0;
 
     // set it if unset
-    if (data->fake_df_id == 0)
+    if (data->fake_df_id == 0) {
         data->fake_df_id = next_fake_df_id--;
+        data->dirty = true;
+    }
 
     return data->fake_df_id;
 }
 
+static void write_file(color_ostream &out, const std::filesystem::path &path, const std::string &contents) {
+    // write to a temporary file and rename it into place so an interrupted
+    // save never leaves a partial file behind
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+    bool ok;
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(BINARY_MAGIC, BINARY_MAGIC_LEN);
+        file.write(contents.data(), contents.size());
+        file.close();
+        ok = !file.fail();
+    }
+    std::error_code ec;
+    if (ok)
+        std::filesystem::rename(tmp_path, path, ec);
+    if (!ok || ec)
+        out.printerr("Cannot save data to: '{}'\n", path);
+}
+
 void Persistence::Internal::clear(color_ostream& out) {
     CoreSuspender suspend;
 
+    for (auto & entity_store_entry : store) {
+        for (auto & entries : entity_store_entry.second)
+            entries.second->valid = false;
+    }
     store.clear();
-    entry_cache.clear();
+    key_id_index.clear();
+    dirty_entities.clear();
+    entity_snapshots.clear();
     next_entry_id = 0;
     next_fake_df_id = -101;
 }
@@ -227,20 +468,31 @@ void Persistence::Internal::save(color_ostream& out) {
         }
     }
 
-    // write entity data
+    // unchanged entities reuse their file contents from the previous save, and
+    // only modified entries are re-encoded. the files are complete by the time
+    // we return, since DF copies them into the named save right after this.
     for (auto & entity_store_entry : store) {
         int entity_id = entity_store_entry.first;
-        Json::Value json(Json::arrayValue);
+        auto [snapshot_it, added] = entity_snapshots.try_emplace(entity_id);
+        auto & snapshot = snapshot_it->second;
+        bool changed = added || dirty_entities.contains(entity_id);
         for (auto & entries : entity_store_entry.second) {
-            if (entries.second == nullptr)
-                continue;
-            json.append(entries.second->toJSON());
+            if (entries.second && entries.second->updateEncoded())
+                changed = true;
+        }
+        if (changed) {
+            snapshot.clear();
+            for (auto & entries : entity_store_entry.second) {
+                if (entries.second == nullptr)
+                    continue;
+                snapshot.append(entries.second->encoded);
+            }
         }
         std::string name = (entity_id == Persistence::WORLD_ENTITY_ID) ?
             "world" : "entity-" + int_to_string(entity_id);
-        auto file = std::ofstream(getSaveFilePath("current", name));
-        file << json;
+        write_file(out, getSaveFilePath("current", name), snapshot);
     }
+    dirty_entities.clear();
 
     // write perf counters
     {
@@ -258,21 +510,29 @@ static bool get_entity_id(const std::string & fname, int & entity_id) {
     return true;
 }
 
-static void add_entry(std::multimap<std::string, std::shared_ptr<Persistence::DataEntry>> & entity_store_entry,
-        std::shared_ptr<Persistence::DataEntry> entry) {
+static void add_entry(entity_store_t & entity_store_entry, std::shared_ptr<Persistence::DataEntry> entry) {
     entity_store_entry.emplace(entry->key, entry);
-    entry_cache.emplace(entry->entry_id, entry);
+    key_id_index[entry->entity_id][entry->key_id].push_back(entry);
+    dirty_entities.emplace(entry->entity_id);
 }
 
 static void add_entry(int entity_id, std::shared_ptr<Persistence::DataEntry> entry) {
     add_entry(store[entity_id], entry);
 }
 
-static bool load_file(const std::filesystem::path & path, int entity_id) {
+static void add_loaded_entry(entity_store_t & entity_store_entry, std::shared_ptr<Persistence::DataEntry> entry) {
+    if (!entry || entry->key.empty())
+        return;
+    // ensure fake DF IDs remain globally unique
+    next_fake_df_id = std::min(next_fake_df_id, entry->fake_df_id - 1);
+    add_entry(entity_store_entry, entry);
+}
+
+static bool load_json(const std::string & contents, int entity_id) {
     Json::Value json;
     try {
-        std::ifstream file(path);
-        file >> json;
+        std::istringstream stream(contents);
+        stream >> json;
     } catch (std::exception &) {
         // empty file?
         return false;
@@ -280,19 +540,51 @@ static bool load_file(const std::filesystem::path & path, int entity_id) {
 
     if (json.isArray()) {
         auto & entity_store_entry = store[entity_id];
-        for (auto & value : json) {
-            std::shared_ptr<Persistence::DataEntry> entry(new Persistence::DataEntry(entity_id, value));
-            if (entry->key.empty())
-                continue;
-            // ensure fake DF IDs remain globally unique
-            next_fake_df_id = std::min(next_fake_df_id, entry->fake_df_id - 1);
-            add_entry(entity_store_entry, entry);
-        }
+        for (auto & value : json)
+            add_loaded_entry(entity_store_entry, std::make_shared<Persistence::DataEntry>(entity_id, value));
     }
 
     return true;
 }
 
+static bool load_binary(const std::string & contents, int entity_id) {
+    std::vector<Persistence::Binary::Record> records;
+    if (!Persistence::Binary::readRecords(std::string_view(contents).substr(BINARY_MAGIC_LEN), records))
+        return false;
+    auto & entity_store_entry = store[entity_id];
+    for (auto & record : records)
+        add_loaded_entry(entity_store_entry, Persistence::DataEntry::fromRecord(entity_id, record));
+    return true;
+}
+
+static bool read_file(const std::filesystem::path & path, std::string & contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    contents = ss.str();
+    return true;
+}
+
+static bool load_file(const std::filesystem::path & path, int entity_id) {
+    std::string contents;
+    if (!read_file(path, contents))
+        return false;
+
+    bool ok = contents.compare(0, BINARY_MAGIC_LEN, BINARY_MAGIC) == 0 ?
+        load_binary(contents, entity_id) : load_json(contents, entity_id);
+
+    // a freshly loaded entity matches what is on disk, so it has nothing new to save.
+    // entities loaded from the legacy JSON format are left dirty so they are
+    // rewritten in the binary format on the next save.
+    if (ok && contents.compare(0, BINARY_MAGIC_LEN, BINARY_MAGIC) == 0) {
+        dirty_entities.erase(entity_id);
+        entity_snapshots[entity_id] = contents.substr(BINARY_MAGIC_LEN);
+    }
+    return ok;
+}
+
 void Persistence::Internal::load(color_ostream& out) {
     CoreSuspender suspend;
     LastLoadSaveTickCountUpdater tickCountUpdater;
@@ -353,16 +645,33 @@ PersistentDataItem Persistence::getByKey(int entity_id, const std::string &key,
 
     CoreSuspender suspend;
 
-    bool found = store.contains(entity_id) && store[entity_id].contains(key);
+    auto entity_it = store.find(entity_id);
+    auto it = entity_it == store.end() ? entity_store_t::iterator() : entity_it->second.find(std::string_view(key));
+    bool found = entity_it != store.end() && it != entity_it->second.end();
     if (added)
         *added = !found;
     if (found)
-        return PersistentDataItem(store[entity_id].find(key)->second);
+        return PersistentDataItem(it->second);
     if (!added)
         return PersistentDataItem();
     return addItem(entity_id, key);
 }
 
+PersistentDataItem Persistence::getByKey(int entity_id, KeyId key_id) {
+    if (!is_good_entity_id(entity_id) || !Core::getInstance().isWorldLoaded())
+        return PersistentDataItem();
+
+    CoreSuspender suspend;
+
+    auto entity_it = key_id_index.find(entity_id);
+    if (entity_it == key_id_index.end())
+        return PersistentDataItem();
+    auto it = entity_it->second.find(key_id);
+    if (it == entity_it->second.end() || it->second.empty())
+        return PersistentDataItem();
+    return PersistentDataItem(it->second.front());
+}
+
 bool Persistence::deleteItem(const PersistentDataItem &item) {
     if (!item.isValid())
         return false;
@@ -374,8 +683,13 @@ bool Persistence::deleteItem(const PersistentDataItem &item) {
     auto range = store[entity_id].equal_range(item.key());
     for (auto it = range.first; it != range.second; ++it) {
         if (it->second->isReferencedBy(item)) {
-            entry_cache.erase(it->second->entry_id);
+            auto & by_key_id = key_id_index[entity_id][it->second->key_id];
+            std::erase(by_key_id, it->second);
+            if (by_key_id.empty())
+                key_id_index[entity_id].erase(it->second->key_id);
+            it->second->valid = false;
             store[entity_id].erase(it);
+            dirty_entities.emplace(entity_id);
             break;
         }
     }
@@ -431,7 +745,112 @@ void Persistence::getAllByKey(std::vector<PersistentDataItem> &vec, int entity_i
         vec.emplace_back(it->second);
 }
 
+void Persistence::forEachByKey(int entity_id, std::string_view key, const visitor_fn &fn) {
+    if (!is_good_entity_id(entity_id) || !Core::getInstance().isWorldLoaded())
+        return;
+
+    CoreSuspender suspend;
+
+    auto entity_it = store.find(entity_id);
+    if (entity_it == store.end())
+        return;
+
+    auto range = entity_it->second.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        PersistentDataItem item(it->second);
+        if (!fn(item))
+            break;
+    }
+}
+
+void Persistence::forEachByKey(int entity_id, KeyId key_id, const visitor_fn &fn) {
+    if (!is_good_entity_id(entity_id) || !Core::getInstance().isWorldLoaded())
+        return;
+
+    CoreSuspender suspend;
+
+    auto entity_it = key_id_index.find(entity_id);
+    if (entity_it == key_id_index.end())
+        return;
+    auto it = entity_it->second.find(key_id);
+    if (it == entity_it->second.end())
+        return;
+
+    for (auto & entry : it->second) {
+        PersistentDataItem item(entry);
+        if (!fn(item))
+            break;
+    }
+}
+
+void Persistence::forEachByKeyRange(int entity_id, std::string_view min, std::string_view max, const visitor_fn &fn) {
+    if (!is_good_entity_id(entity_id) || !Core::getInstance().isWorldLoaded())
+        return;
+
+    CoreSuspender suspend;
+
+    auto entity_it = store.find(entity_id);
+    if (entity_it == store.end())
+        return;
+
+    auto end = entity_it->second.lower_bound(max);
+    for (auto it = entity_it->second.lower_bound(min); it != end; ++it) {
+        PersistentDataItem item(it->second);
+        if (!fn(item))
+            break;
+    }
+}
+
+void Persistence::forEachByKeyPrefix(int entity_id, std::string_view prefix, const visitor_fn &fn) {
+    if (!is_good_entity_id(entity_id) || !Core::getInstance().isWorldLoaded())
+        return;
+
+    CoreSuspender suspend;
+
+    auto entity_it = store.find(entity_id);
+    if (entity_it == store.end())
+        return;
+
+    for (auto it = entity_it->second.lower_bound(prefix);
+            it != entity_it->second.end() && it->first.starts_with(prefix); ++it) {
+        PersistentDataItem item(it->second);
+        if (!fn(item))
+            break;
+    }
+}
+
 uint32_t Persistence::getUnsavedSeconds() {
     uint32_t durMS =  Core::getInstance().p->getTickCount() - lastLoadSaveTickCount;
     return durMS / 1000;
 }
+
+bool Persistence::exportJSON(int entity_id, const std::filesystem::path &path) {
+    if (!is_good_entity_id(entity_id) || !Core::getInstance().isWorldLoaded())
+        return false;
+
+    CoreSuspender suspend;
+
+    Json::Value json(Json::arrayValue);
+    if (store.contains(entity_id)) {
+        for (auto & entries : store[entity_id]) {
+            if (entries.second)
+                json.append(entries.second->toJSON());
+        }
+    }
+
+    std::ofstream file(path);
+    file << json;
+    return !file.fail();
+}
+
+bool Persistence::importJSON(int entity_id, const std::filesystem::path &path) {
+    if (!is_good_entity_id(entity_id) || !Core::getInstance().isWorldLoaded())
+        return false;
+
+    CoreSuspender suspend;
+
+    std::string contents;
+    if (!read_file(path, contents))
+        return false;
+    return load_json(contents, entity_id);
+}
@@ -0,0 +1,172 @@
+/*
+https://github.com/peterix/dfhack
+Copyright (c) 2009-2012 Petr Mrázek (peterix@gmail.com)
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this software.
+
+Permission is granted to anyone to use this software for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must
+not claim that you wrote the original software. If you use this
+software in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original software.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+
+#include "Internal.h"
+
+#include "Core.h"
+#include "DataDefs.h"
+#include "MiscUtils.h"
+
+#include "modules/Items.h"
+#include "modules/Raws.h"
+
+#include "df/caste_raw.h"
+#include "df/creature_raw.h"
+#include "df/inorganic_raw.h"
+#include "df/itemdef.h"
+#include "df/plant_raw.h"
+#include "df/reaction.h"
+#include "df/world.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace DFHack;
+using namespace df::enums;
+
+using df::global::world;
+
+namespace {
+    // Token -> index map for one raws vector. The vector is only replaced
+    // when a world is loaded, so its size and storage are enough to tell
+    // whether the index still describes it.
+    struct TokenIndex {
+        std::unordered_map<std::string, int32_t> ids;
+        size_t size = 0;
+        const void *data = nullptr;
+        bool built = false;
+
+        void clear() {
+            ids.clear();
+            size = 0;
+            data = nullptr;
+            built = false;
+        }
+    };
+
+    struct {
+        TokenIndex inorganics;
+        TokenIndex plants;
+        TokenIndex creatures;
+        TokenIndex reactions;
+        std::unordered_map<int, TokenIndex> itemdefs;
+    } indexes;
+
+    // lookups may come from the worker threads of parallel_for
+    std::mutex index_mutex;
+}
+
+template<typename T>
+static int32_t lookup(TokenIndex &index, const std::vector<T *> &vec,
+                      std::string T::*field, const std::string &token)
+{
+    std::lock_guard<std::mutex> lock(index_mutex);
+    if (!index.built || index.size != vec.size() || index.data != vec.data()) {
+        index.clear();
+        index.ids.reserve(vec.size());
+        // emplace keeps the first of any duplicates, like a linear search
+        for (size_t i = 0; i < vec.size(); i++)
+            index.ids.emplace(vec[i]->*field, int32_t(i));
+        index.size = vec.size();
+        index.data = vec.data();
+        index.built = true;
+    }
+
+    auto it = index.ids.find(token);
+    if (it == index.ids.end())
+        return -1;
+    return it->second;
+}
+
+int32_t Raws::findInorganic(const std::string &id)
+{
+    return lookup(indexes.inorganics, world->raws.inorganics.all, &df::inorganic_raw::id, id);
+}
+
+int32_t Raws::findPlant(const std::string &id)
+{
+    return lookup(indexes.plants, world->raws.plants.all, &df::plant_raw::id, id);
+}
+
+int32_t Raws::findCreature(const std::string &id)
+{
+    return lookup(indexes.creatures, world->raws.creatures.all, &df::creature_raw::creature_id, id);
+}
+
+int32_t Raws::findCaste(int32_t creature, const std::string &id)
+{
+    // creatures have only a handful of castes, so these are not indexed
+    auto raw = vector_get(world->raws.creatures.all, creature);
+    if (!raw)
+        return -1;
+    return linear_index(raw->caste, &df::caste_raw::caste_id, id);
+}
+
+int32_t Raws::findReaction(const std::string &code)
+{
+    return lookup(indexes.reactions, world->raws.reactions.reactions, &df::reaction::code, code);
+}
+
+int32_t Raws::findItemSubtype(df::item_type type, const std::string &id)
+{
+    int count = Items::getSubtypeCount(type);
+    if (count <= 0)
+        return -1;
+
+    std::lock_guard<std::mutex> lock(index_mutex);
+    auto &index = indexes.itemdefs[type];
+    if (!index.built || index.size != size_t(count)) {
+        index.clear();
+        index.ids.reserve(count);
+        for (int i = 0; i < count; i++)
+            if (auto def = Items::getSubtypeDef(type, i))
+                index.ids.emplace(def->id, i);
+        index.size = count;
+        index.built = true;
+    }
+
+    auto it = index.ids.find(id);
+    if (it == index.ids.end())
+        return -1;
+    return it->second;
+}
+
+void Raws::clearIndexes()
+{
+    std::lock_guard<std::mutex> lock(index_mutex);
+    indexes.inorganics.clear();
+    indexes.plants.clear();
+    indexes.creatures.clear();
+    indexes.reactions.clear();
+    indexes.itemdefs.clear();
+}
+
+void raws_onStateChange(color_ostream &out, state_change_event event)
+{
+    if (event == SC_WORLD_UNLOADED)
+        Raws::clearIndexes();
+}
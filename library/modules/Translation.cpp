@@ -43,7 +43,9 @@ distribution.
 #include "df/language_word_table_index.h"
 #include "df/world.h"
 
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <map>
 
@@ -109,10 +111,82 @@ void addNameWord (string &out, const string &word)
     out.append(Translation::capitalize(word));
 }
 
+namespace {
+    // Everything translateName reads from a name, plus its options.
+    struct NameKey {
+        string first_name;
+        string nickname;
+        int32_t language;
+        int32_t words[7];
+        int16_t parts_of_speech[7];
+        int16_t nickname_mode;
+        bool in_english;
+        bool only_last_part;
+
+        bool operator==(const NameKey &other) const = default;
+    };
+
+    struct NameKeyHash {
+        size_t operator() (const NameKey &key) const {
+            size_t h = std::hash<string>()(key.first_name);
+            auto combine = [&](size_t v) { h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2); };
+            combine(std::hash<string>()(key.nickname));
+            combine(std::hash<int32_t>()(key.language));
+            for (int i = 0; i < 7; i++) {
+                combine(std::hash<int32_t>()(key.words[i]));
+                combine(std::hash<int16_t>()(key.parts_of_speech[i]));
+            }
+            combine((size_t(key.nickname_mode) << 2) | (key.in_english << 1) | key.only_last_part);
+            return h;
+        }
+    };
+
+    // the same names are translated over and over by unit lists and overlays.
+    // the cache is dropped when it gets this big, so names that are no longer
+    // shown don't pile up.
+    const size_t MAX_CACHED_NAMES = 16384;
+
+    std::unordered_map<NameKey, string, NameKeyHash> name_cache;
+    // names may be translated from the worker threads of parallel_for
+    std::mutex name_cache_mutex;
+}
+
+static df::d_init_nickname get_nickname_mode() {
+    return (d_init && gametype) ? d_init->display.nickname[*gametype] : d_init_nickname::CENTRALIZE;
+}
+
+static NameKey make_name_key(const df::language_name *name, bool inEnglish, bool onlyLastPart,
+                             df::d_init_nickname nickname_mode)
+{
+    NameKey key;
+    key.first_name = name->first_name;
+    key.nickname = name->nickname;
+    key.language = name->language;
+    for (int i = 0; i < 7; i++) {
+        key.words[i] = name->words[i];
+        key.parts_of_speech[i] = name->parts_of_speech[i];
+    }
+    key.nickname_mode = nickname_mode;
+    key.in_english = inEnglish;
+    key.only_last_part = onlyLastPart;
+    return key;
+}
+
+// drops the cached translations of the name as it is now
+static void forget_name(const df::language_name *name) {
+    auto nickname_mode = get_nickname_mode();
+    std::lock_guard<std::mutex> lock(name_cache_mutex);
+    for (bool inEnglish : {false, true})
+        for (bool onlyLastPart : {false, true})
+            name_cache.erase(make_name_key(name, inEnglish, onlyLastPart, nickname_mode));
+}
+
 void Translation::setNickname(df::language_name *name, std::string nick)
 {
     CHECK_NULL_POINTER(name);
 
+    forget_name(name);
+
     if (!name->has_name)
     {
         if (nick.empty())
@@ -170,10 +244,9 @@ static string translate_english_word(const df::language_name * name, size_t part
     return words->forms[part];
 }
 
-string Translation::translateName(const df::language_name * name, bool inEnglish, bool onlyLastPart)
+static string build_name(const df::language_name * name, bool inEnglish, bool onlyLastPart,
+                         df::d_init_nickname nickname_mode)
 {
-    CHECK_NULL_POINTER(name);
-
     string out;
     string word;
 
@@ -184,7 +257,7 @@ string Translation::translateName(const df::language_name * name, bool inEnglish
         if (!name->nickname.empty())
         {
             word = "`" + name->nickname + "'";
-            switch ((d_init && gametype) ? d_init->display.nickname[*gametype] : d_init_nickname::CENTRALIZE)
+            switch (nickname_mode)
             {
             case d_init_nickname::REPLACE_ALL:
                 out = word;
@@ -259,6 +332,55 @@ string Translation::translateName(const df::language_name * name, bool inEnglish
     return out;
 }
 
+// expects name_cache_mutex to be held
+static const string & lookup_name(const df::language_name * name, bool inEnglish, bool onlyLastPart,
+                                  df::d_init_nickname nickname_mode)
+{
+    auto key = make_name_key(name, inEnglish, onlyLastPart, nickname_mode);
+    auto it = name_cache.find(key);
+    if (it != name_cache.end())
+        return it->second;
+
+    if (name_cache.size() >= MAX_CACHED_NAMES)
+        name_cache.clear();
+    string out = build_name(name, inEnglish, onlyLastPart, nickname_mode);
+    return name_cache.emplace(std::move(key), std::move(out)).first->second;
+}
+
+string Translation::translateName(const df::language_name * name, bool inEnglish, bool onlyLastPart)
+{
+    CHECK_NULL_POINTER(name);
+
+    auto nickname_mode = get_nickname_mode();
+    std::lock_guard<std::mutex> lock(name_cache_mutex);
+    return lookup_name(name, inEnglish, onlyLastPart, nickname_mode);
+}
+
+void Translation::translateNames(const std::vector<const df::language_name *> &names,
+                                 std::vector<std::string> &out, bool inEnglish, bool onlyLastPart)
+{
+    out.clear();
+    out.reserve(names.size());
+
+    auto nickname_mode = get_nickname_mode();
+    std::lock_guard<std::mutex> lock(name_cache_mutex);
+    for (auto name : names)
+        out.push_back(name ? lookup_name(name, inEnglish, onlyLastPart, nickname_mode) : string());
+}
+
+void Translation::clearNameCache()
+{
+    std::lock_guard<std::mutex> lock(name_cache_mutex);
+    name_cache.clear();
+}
+
+void translation_onStateChange(color_ostream &out, state_change_event event)
+{
+    // the language raws go away with the world
+    if (event == SC_WORLD_UNLOADED)
+        Translation::clearNameCache();
+}
+
 Random::MersenneRNG rng;
 bool rng_inited = false;
 // void word_selectorst::choose_word(int32_t &index,short &asp,WordPlace place)
@@ -1216,6 +1216,15 @@ string Units::getReadableName(df::unit *unit, bool skip_english) {
     return formatReadableName(unit, prof_name, skip_english);
 }
 
+void Units::getReadableNames(vector<string> &names, const vector<df::unit *> &units, bool skip_english) {
+    // the translated parts come from the name cache, so only the profession
+    // and status parts are rebuilt for units that were named before
+    names.clear();
+    names.reserve(units.size());
+    for (auto unit : units)
+        names.push_back(unit ? getReadableName(unit, skip_english) : "");
+}
+
 double Units::getAge(df::unit *unit, bool true_age) {
     using df::global::cur_year;
     using df::global::cur_year_tick;
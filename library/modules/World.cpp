@@ -27,6 +27,7 @@ distribution.
 #include "Debug.h"
 
 #include "modules/Gui.h"
+#include "modules/Maps.h"
 #include "modules/Translation.h"
 #include "modules/Units.h"
 #include "modules/World.h"
@@ -41,6 +42,11 @@ distribution.
 #include "df/world_data.h"
 #include "df/world_site.h"
 
+#include <algorithm>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
 using std::string;
 
 using namespace DFHack;
@@ -296,6 +302,52 @@ bool World::DeletePersistentData(const PersistentDataItem &item) {
     return Persistence::deleteItem(item);
 }
 
+typedef df::block_square_event_world_constructionst tilemask_event;
+
+// Blocks that hold a tile mask, per persistent item (by fake id). An item's
+// blocks are found with one pass over the map the first time it is asked
+// about, and the index is then kept up to date by the functions below.
+static std::unordered_map<int, std::unordered_map<df::map_block *, tilemask_event *>> tilemask_index;
+// lookups may come from parallel_for workers
+static std::shared_mutex tilemask_mutex;
+
+static tilemask_event *find_tilemask_event(df::map_block *block, int id) {
+    for (auto ev : block->block_events) {
+        if (ev->getType() != block_square_event_type::world_construction)
+            continue;
+        auto wcsev = strict_virtual_cast<tilemask_event>(ev);
+        if (wcsev && wcsev->construction_id == id)
+            return wcsev;
+    }
+    return NULL;
+}
+
+// must be called with tilemask_mutex held exclusively
+static std::unordered_map<df::map_block *, tilemask_event *> &index_tilemasks(int id) {
+    auto [it, inserted] = tilemask_index.try_emplace(id);
+    if (inserted) {
+        for (auto block : world->map.map_blocks)
+            if (auto ev = find_tilemask_event(block, id))
+                it->second.emplace(block, ev);
+    }
+    return it->second;
+}
+
+static tilemask_event *lookup_tilemask(int id, df::map_block *block) {
+    {
+        std::shared_lock lock(tilemask_mutex);
+        auto it = tilemask_index.find(id);
+        if (it != tilemask_index.end()) {
+            auto found = it->second.find(block);
+            return found == it->second.end() ? NULL : found->second;
+        }
+    }
+    std::unique_lock lock(tilemask_mutex);
+    auto &blocks = index_tilemasks(id);
+    auto found = blocks.find(block);
+    return found == blocks.end() ? NULL : found->second;
+}
+
 df::tile_bitmask *World::getPersistentTilemask(PersistentDataItem &item, df::map_block *block, bool create) {
     if (!block)
         return NULL;
@@ -304,18 +356,17 @@ df::tile_bitmask *World::getPersistentTilemask(PersistentDataItem &item, df::map
     if (id > -100)
         return NULL;
 
-    for (auto ev : block->block_events) {
-        if (ev->getType() != block_square_event_type::world_construction)
-            continue;
-        auto wcsev = strict_virtual_cast<df::block_square_event_world_constructionst>(ev);
-        if (!wcsev || wcsev->construction_id != id)
-            continue;
-        return &wcsev->tile_bitmask;
-    }
+    if (auto ev = lookup_tilemask(id, block))
+        return &ev->tile_bitmask;
 
     if (!create)
         return NULL;
 
+    std::unique_lock lock(tilemask_mutex);
+    auto &blocks = index_tilemasks(id);
+    if (auto found = blocks.find(block); found != blocks.end())
+        return &found->second->tile_bitmask;
+
     auto ev = df::allocate<df::block_square_event_world_constructionst>();
     if (!ev)
         return NULL;
@@ -323,6 +374,7 @@ df::tile_bitmask *World::getPersistentTilemask(PersistentDataItem &item, df::map
     ev->construction_id = id;
     ev->tile_bitmask.clear();
     vector_insert_at(block->block_events, 0, (df::block_square_event*)ev);
+    blocks.emplace(block, ev);
 
     return &ev->tile_bitmask;
 }
@@ -335,6 +387,7 @@ bool World::deletePersistentTilemask(PersistentDataItem &item, df::map_block *bl
     if (id > -100)
         return false;
 
+    std::unique_lock lock(tilemask_mutex);
     bool found = false;
     for (int i = block->block_events.size()-1; i >= 0; i--) {
         auto ev = block->block_events[i];
@@ -349,5 +402,90 @@ bool World::deletePersistentTilemask(PersistentDataItem &item, df::map_block *bl
         found = true;
     }
 
+    if (auto it = tilemask_index.find(id); it != tilemask_index.end())
+        it->second.erase(block);
+
     return found;
 }
+
+void World::getPersistentTilemaskBlocks(PersistentDataItem &item, std::vector<df::map_block *> *blocks) {
+    CHECK_NULL_POINTER(blocks);
+    blocks->clear();
+
+    int id = item.fake_df_id();
+    if (id > -100)
+        return;
+
+    std::unique_lock lock(tilemask_mutex);
+    for (auto &entry : index_tilemasks(id))
+        blocks->push_back(entry.first);
+}
+
+// calls fn(block, mask, x, y) for the tiles of each block within the cuboid
+template<typename Fn>
+static void for_tilemask_area(const df::coord &pos1, const df::coord &pos2, Fn fn) {
+    df::coord min(std::min(pos1.x, pos2.x), std::min(pos1.y, pos2.y), std::min(pos1.z, pos2.z));
+    df::coord max(std::max(pos1.x, pos2.x), std::max(pos1.y, pos2.y), std::max(pos1.z, pos2.z));
+    for (int z = min.z; z <= max.z; z++) {
+        for (int by = min.y >> 4; by <= max.y >> 4; by++) {
+            for (int bx = min.x >> 4; bx <= max.x >> 4; bx++) {
+                auto block = Maps::getBlock(bx, by, z);
+                if (!block)
+                    continue;
+                int x1 = std::max(min.x - bx * 16, 0);
+                int x2 = std::min(max.x - bx * 16, 15);
+                int y1 = std::max(min.y - by * 16, 0);
+                int y2 = std::min(max.y - by * 16, 15);
+                fn(block, x1, x2, y1, y2);
+            }
+        }
+    }
+}
+
+void World::setPersistentTilemaskArea(PersistentDataItem &item, const df::coord &pos1, const df::coord &pos2, bool enable) {
+    for_tilemask_area(pos1, pos2, [&](df::map_block *block, int x1, int x2, int y1, int y2) {
+        auto mask = getPersistentTilemask(item, block, enable);
+        if (!mask)
+            return;
+        for (int x = x1; x <= x2; x++)
+            for (int y = y1; y <= y2; y++)
+                mask->setassignment(x, y, enable);
+        // drop emptied masks so that they are no longer enumerated
+        if (!enable && !mask->has_assignments())
+            deletePersistentTilemask(item, block);
+    });
+}
+
+size_t World::getPersistentTilemaskArea(PersistentDataItem &item, const df::coord &pos1, const df::coord &pos2, std::vector<df::coord> *tiles) {
+    size_t count = 0;
+    for_tilemask_area(pos1, pos2, [&](df::map_block *block, int x1, int x2, int y1, int y2) {
+        auto mask = getPersistentTilemask(item, block);
+        if (!mask)
+            return;
+        for (int x = x1; x <= x2; x++) {
+            for (int y = y1; y <= y2; y++) {
+                if (!mask->getassignment(x, y))
+                    continue;
+                ++count;
+                if (tiles)
+                    tiles->push_back(block->map_pos + df::coord(x, y, 0));
+            }
+        }
+    });
+    return count;
+}
+
+void world_onStateChange(color_ostream &out, state_change_event event) {
+    switch (event) {
+    case SC_MAP_LOADED:
+    case SC_MAP_UNLOADED:
+    case SC_WORLD_UNLOADED:
+    {
+        std::unique_lock lock(tilemask_mutex);
+        tilemask_index.clear();
+        break;
+    }
+    default:
+        break;
+    }
+}
@@ -25,6 +25,8 @@
 
 #include <map>
 #include <algorithm>
+#include <chrono>
+#include <thread>
 #include <math.h>
 
 #ifdef LINUX_BUILD
@@ -84,12 +86,29 @@ struct NoiseFunction
      * the threshold causing placement of a vein tile.
      */
     virtual float eval(float x, float y, float z) = 0;
+    /*
+     * Evaluates count (at most MAX_ROW) points along the X axis,
+     * producing the same values as eval(xs[i], y, z).
+     */
+    virtual void eval_row(const float *xs, float y, float z, int count, float *out) {
+        for (int i = 0; i < count; i++)
+            out[i] = eval(xs[i], y, z);
+    }
     virtual t_range range() = 0;
     virtual void displace(float &x, float &y, float &z) = 0;
 };
 
 inline float apow(float a, float b) { return powf(fabsf(a), b); }
 
+// Rows are evaluated one block row at a time
+static const int MAX_ROW = 16;
+
+static inline void scale_row(float *dst, const float *xs, float div, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = xs[i]/div;
+}
+
 struct Distribution : NoiseFunction
 {
     float bx, by, bz;
@@ -125,6 +144,20 @@ struct DistributionVein : Distribution
                     +0.6f*strand1b(x/16,y/16,z/8), 0.6f);
     }
 
+    void eval_row(const float *xs, float y, float z, int count, float *out) {
+        float sx[MAX_ROW], d1[MAX_ROW], d2[MAX_ROW], s1a[MAX_ROW], s1b[MAX_ROW];
+        scale_row(sx, xs, 96, count);
+        density1.row(sx, y/96, z/48, count, d1);
+        scale_row(sx, xs, 48, count);
+        density2.row(sx, y/48, z/24, count, d2);
+        scale_row(sx, xs, 24, count);
+        strand1a.row(sx, y/24, z/12, count, s1a);
+        scale_row(sx, xs, 16, count);
+        strand1b.row(sx, y/16, z/8, count, s1b);
+        for (int i = 0; i < count; i++)
+            out[i] = 0.1f * d1[i] + 0.2f * d2[i] - apow(s1a[i] + 0.6f*s1b[i], 0.6f);
+    }
+
     t_range range() { return t_range(-0.3f-1.33f,0.3f); }
 };
 
@@ -144,6 +177,18 @@ struct DistributionCluster : Distribution
              + shape(x/24, y/24, z/8);
     }
 
+    void eval_row(const float *xs, float y, float z, int count, float *out) {
+        float sx[MAX_ROW], d1[MAX_ROW], d2[MAX_ROW], sh[MAX_ROW];
+        scale_row(sx, xs, 96, count);
+        density1.row(sx, y/96, z/32, count, d1);
+        scale_row(sx, xs, 48, count);
+        density2.row(sx, y/48, z/16, count, d2);
+        scale_row(sx, xs, 24, count);
+        shape.row(sx, y/24, z/8, count, sh);
+        for (int i = 0; i < count; i++)
+            out[i] = 0.2f * d1[i] + 0.6f * d2[i] + sh[i];
+    }
+
     t_range range() { return t_range(-1.8f,1.8f); }
 };
 
@@ -164,6 +209,20 @@ struct DistributionClusterSmall : Distribution
              + apow(shape(x*scale, y*scale, z*scale), 0.1f);
     }
 
+    void eval_row(const float *xs, float y, float z, int count, float *out) {
+        const float scale = 1.0f/4.3f;
+        float sx[MAX_ROW], d1[MAX_ROW], d2[MAX_ROW], sh[MAX_ROW];
+        scale_row(sx, xs, 96, count);
+        density1.row(sx, y/96, z/48, count, d1);
+        scale_row(sx, xs, 24, count);
+        density2.row(sx, y/24, z/12, count, d2);
+        for (int i = 0; i < count; i++)
+            sx[i] = xs[i]*scale;
+        shape.row(sx, y*scale, z*scale, count, sh);
+        for (int i = 0; i < count; i++)
+            out[i] = 0.06f * d1[i] + 0.12f * d2[i] + apow(sh[i], 0.1f);
+    }
+
     t_range range() { return t_range(-0.18f,1.18f); }
 };
 
@@ -183,6 +242,19 @@ struct DistributionClusterOne : Distribution
              + shape(x-bx, y-by, z-bz);
     }
 
+    void eval_row(const float *xs, float y, float z, int count, float *out) {
+        float sx[MAX_ROW], d1[MAX_ROW], d2[MAX_ROW], sh[MAX_ROW];
+        scale_row(sx, xs, 96, count);
+        density1.row(sx, y/96, z/48, count, d1);
+        scale_row(sx, xs, 48, count);
+        density2.row(sx, y/48, z/24, count, d2);
+        for (int i = 0; i < count; i++)
+            sx[i] = xs[i]-bx;
+        shape.row(sx, y-by, z-bz, count, sh);
+        for (int i = 0; i < count; i++)
+            out[i] = 0.05f * d1[i] + 0.1f * d2[i] + sh[i];
+    }
+
     t_range range() { return t_range(-1.15f,1.15f); }
 };
 
@@ -280,8 +352,8 @@ struct GeoBlock
         memset(material, -1, sizeof(material));
     }
 
-    bool prepare_arena(int16_t env_material, NoiseFunction::Ptr fn);
-    int measure_placement(float threshold);
+    bool prepare_arena(int16_t env_material, NoiseFunction *fn);
+    void collect_unmined_weights(std::vector<float> &out);
     void place_tiles(float threshold, int16_t new_material, df::inclusion_type itype);
 };
 
@@ -1114,7 +1186,7 @@ void VeinGenerator::write_block_tiles(Block *b, df::coord2d column, int z)
  * Vein placement code
  */
 
-bool GeoBlock::prepare_arena(int16_t basemat, NoiseFunction::Ptr fn)
+bool GeoBlock::prepare_arena(int16_t basemat, NoiseFunction *fn)
 {
     arena_mask = arena_unmined = 0;
     arena_material = basemat;
@@ -1125,14 +1197,27 @@ bool GeoBlock::prepare_arena(int16_t basemat, NoiseFunction::Ptr fn)
 
     fn->displace(x0, y0, z);
 
+    float xs[16], row[16];
     for (int x = 0; x < 16; x++)
+        xs[x] = x0+x;
+
+    // Evaluate the noise a row at a time, skipping rows with no arena tiles
+    for (int y = 0; y < 16; y++)
     {
-        for (int y = 0; y < 16; y++)
+        bool any = false;
+        for (int x = 0; x < 16 && !any; x++)
+            any = (material[x][y] == arena_material);
+        if (!any)
+            continue;
+
+        fn->eval_row(xs, y0+y, z, 16, row);
+
+        for (int x = 0; x < 16; x++)
         {
             if (material[x][y] != arena_material)
                 continue;
 
-            weight[x][y] = fn->eval(x0+x, y0+y, z);
+            weight[x][y] = row[x];
 
             arena_mask |= (1<<x);
             if (unmined.getassignment(x,y))
@@ -1143,12 +1228,10 @@ bool GeoBlock::prepare_arena(int16_t basemat, NoiseFunction::Ptr fn)
     return arena_mask != 0;
 }
 
-int GeoBlock::measure_placement(float threshold)
+void GeoBlock::collect_unmined_weights(std::vector<float> &out)
 {
     if (!arena_unmined)
-        return 0;
-
-    int count = 0;
+        return;
 
     for (int x = 0; x < 16; x++)
     {
@@ -1157,15 +1240,10 @@ int GeoBlock::measure_placement(float threshold)
 
         for (int y = 0; y < 16; y++)
         {
-            if (material[x][y] != arena_material || weight[x][y] < threshold)
-                continue;
-
-            if (unmined.getassignment(x,y))
-                count++;
+            if (material[x][y] == arena_material && unmined.getassignment(x,y))
+                out.push_back(weight[x][y]);
         }
     }
-
-    return count;
 }
 
 void GeoBlock::place_tiles(float threshold, int16_t new_material, df::inclusion_type itype)
@@ -1186,12 +1264,10 @@ void GeoBlock::place_tiles(float threshold, int16_t new_material, df::inclusion_
     }
 }
 
-static int measure(const std::vector<GeoBlock*> &arena, float threshold)
+// Returns the number of weights that are >= threshold; weights must be sorted.
+static int measure(const std::vector<float> &weights, float threshold)
 {
-    int count = 0;
-    for (size_t i = 0; i < arena.size(); i++)
-        count += arena[i]->measure_placement(threshold);
-    return count;
+    return weights.end() - std::lower_bound(weights.begin(), weights.end(), threshold);
 }
 
 void VeinExtent::link(GeoLayer *layer)
@@ -1232,6 +1308,7 @@ void VeinExtent::merge_into(Ptr target)
 
 void VeinExtent::place_tiles()
 {
+    std::vector<GeoBlock*> candidates;
     std::vector<GeoBlock*> arena;
 
     int env_material = parent_mat();
@@ -1239,14 +1316,34 @@ void VeinExtent::place_tiles()
     for (size_t i = 0; i < layers.size(); i++)
     {
         auto layer = layers[i];
-
-        for (auto bit = layer->block_list.begin(); bit != layer->block_list.end(); ++bit)
-        {
-            if ((*bit)->prepare_arena(env_material, distribution))
-                arena.push_back(*bit);
-        }
+        candidates.insert(candidates.end(), layer->block_list.begin(), layer->block_list.end());
+    }
+
+    // Evaluating the noise dominates the run time. Each block only touches
+    // its own state and the distribution is read-only, so blocks can be
+    // prepared in parallel. Keep enough blocks per thread to amortize the
+    // thread startup cost, and no more threads than the hardware has.
+    std::vector<char> in_arena(candidates.size());
+    NoiseFunction *fn = distribution.get();
+    size_t max_threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                          std::max<size_t>(1, candidates.size() / 64));
+    parallel_for(candidates.size(), [&](size_t i) {
+        in_arena[i] = candidates[i]->prepare_arena(env_material, fn);
+    }, max_threads);
+
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        if (in_arena[i])
+            arena.push_back(candidates[i]);
     }
 
+    // The set of candidate tiles doesn't change during the search, so
+    // sort their weights once and count by bisection instead of rescanning.
+    std::vector<float> weights;
+    for (size_t i = 0; i < arena.size(); i++)
+        arena[i]->collect_unmined_weights(weights);
+    std::sort(weights.begin(), weights.end());
+
     // Binary search to meet the required number
     auto range = distribution->range();
     float mid;
@@ -1254,7 +1351,7 @@ void VeinExtent::place_tiles()
     for (int i = 0; i < 32; i++) // iteration limit
     {
         mid = (range.first + range.second) / 2;
-        int count = placed_tiles = measure(arena, mid);
+        int count = placed_tiles = measure(weights, mid);
 
         if (count == num_tiles)
             break;
@@ -1610,14 +1707,46 @@ bool VeinGenerator::place_veins(bool verbose)
     return true;
 }
 
+// Reports the time taken by each phase when requested
+struct PhaseTimer
+{
+    color_ostream &out;
+    bool enabled;
+    std::chrono::steady_clock::time_point start, phase_start;
+
+    PhaseTimer(color_ostream &out, bool enabled) : out(out), enabled(enabled) {
+        start = phase_start = std::chrono::steady_clock::now();
+    }
+
+    static long long ms_since(std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - since).count();
+    }
+
+    void phase(const char *name) {
+        if (enabled)
+            out.print("  {}: {} ms\n", name, ms_since(phase_start));
+        phase_start = std::chrono::steady_clock::now();
+    }
+
+    void total() {
+        if (enabled)
+            out.print("  total: {} ms ({} threads)\n", ms_since(start),
+                std::max(1u, std::thread::hardware_concurrency()));
+    }
+};
+
 command_result cmd_3dveins(color_ostream &con, std::vector<std::string> & parameters)
 {
     bool verbose = false;
+    bool timing = false;
 
     for (size_t i = 0; i < parameters.size(); i++)
     {
         if (parameters[i] == "verbose")
             verbose = true;
+        else if (parameters[i] == "timing")
+            timing = true;
         else
             return CR_WRONG_USAGE;
     }
@@ -1635,24 +1764,31 @@ command_result cmd_3dveins(color_ostream &con, std::vector<std::string> & parame
     }
 
     VeinGenerator generator(con);
+    PhaseTimer timer(con, timing);
 
     con.print("Collecting statistics...\n");
 
     if (!generator.init_biomes())
         return CR_FAILURE;
+    timer.phase("init biomes");
     if (!generator.scan_tiles())
         return CR_FAILURE;
+    timer.phase("scan tiles");
 
     con.print("Generating veins...\n");
 
     if (!generator.form_veins())
         return CR_FAILURE;
+    timer.phase("form veins");
     if (!generator.place_veins(verbose))
         return CR_FAILURE;
+    timer.phase("place veins");
 
     con.print("Writing tiles...\n");
 
     generator.write_tiles();
+    timer.phase("write tiles");
+    timer.total();
 
     return CR_OK;
 }
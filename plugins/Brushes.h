@@ -1,9 +1,11 @@
 #pragma once
 #include <llimits.h>
+#include <map>
 #include <sstream>
 #include <string>
 #include <stack>
 #include <set>
+#include <vector>
 
 typedef vector <df::coord> coord_vec;
 class Brush
@@ -15,6 +17,25 @@ public:
         return "unknown";
     }
 };
+/**
+ * Groups the tiles by map block and calls fn(block, offsets) once for each
+ * block, with the tile offsets within that block. Painting a block at a time
+ * saves looking up the block for every tile and every field of it. Tiles in
+ * blocks that don't exist are skipped.
+ */
+template<typename Fn>
+void forEachBrushBlock(MapExtras::MapCache & mc, const coord_vec & tiles, Fn && fn)
+{
+    std::map<DFHack::DFCoord, std::vector<df::coord2d>> by_block;
+    for (auto & pos : tiles)
+        by_block[DFHack::DFCoord(pos.x >> 4, pos.y >> 4, pos.z)].emplace_back(pos.x & 15, pos.y & 15);
+    for (auto & [blockc, offsets] : by_block)
+    {
+        if (auto block = mc.BlockAt(blockc))
+            fn(block, offsets);
+    }
+}
+
 /**
  * generic 3D rectangle brush. you can specify the dimensions of
  * the rectangle and optionally which tile is its 'center'
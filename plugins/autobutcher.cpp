@@ -66,11 +66,13 @@ static std::unordered_map<string, int> race_to_id;
 
 static const int32_t CYCLE_TICKS = 5987;
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 10);
 
 static void init_autobutcher(color_ostream &out);
 static void cleanup_autobutcher(color_ostream &out);
 static command_result df_autobutcher(color_ostream &out, vector<string> &parameters);
 static void autobutcher_cycle(color_ostream &out);
+static void start_cycle(color_ostream &out);
 
 DFhackCExport command_result plugin_init(color_ostream &out, vector <PluginCommand> &commands) {
     commands.push_back(PluginCommand(
@@ -151,7 +153,7 @@ DFhackCExport command_result plugin_onstatechange(color_ostream &out, state_chan
 
 DFhackCExport command_result plugin_onupdate(color_ostream &out) {
     if (world->frame_counter - cycle_timestamp >= CYCLE_TICKS)
-        autobutcher_cycle(out);
+        start_cycle(out);
     return CR_OK;
 }
 
@@ -204,6 +206,9 @@ static const struct_field_info autobutcher_options_fields[] = {
 };
 struct_identity autobutcher_options::_identity(sizeof(autobutcher_options), &df::allocator_fn<autobutcher_options>, NULL, "autobutcher_options", NULL, autobutcher_options_fields);
 
+static bool isInappropriateUnit(df::unit *unit);
+static bool isProtectedUnit(df::unit *unit);
+
 static bool isHighPriority(df::unit *unit) {
     return Units::isGay(unit) || Units::isGelded(unit);
 }
@@ -261,6 +266,12 @@ public:
     UnitsPQ fa_units;
     UnitsPQ ma_units;
 
+    // ids of the units sorted into this race by a cycle in progress. units can
+    // die or leave the map between the slices of a cycle, so they are only
+    // resolved and queued when the cycle ends.
+    vector<int32_t> scanned_butcherable;
+    vector<int32_t> scanned_protected;
+
     WatchedRace(color_ostream &out, int id, bool watch, unsigned _fk, unsigned _mk, unsigned _fa, unsigned _ma)
         : raceId(id), isWatched(watch), fk(_fk), mk(_mk), fa(_fa), ma(_ma),
         fk_prot(0), fa_prot(0), mk_prot(0), ma_prot(0),
@@ -335,7 +346,24 @@ public:
         }
     }
 
+    void PushScannedUnits() {
+        for (auto id : scanned_protected) {
+            auto unit = df::unit::find(id);
+            if (unit && !isInappropriateUnit(unit))
+                PushProtectedUnit(unit);
+        }
+        for (auto id : scanned_butcherable) {
+            auto unit = df::unit::find(id);
+            if (unit && !isInappropriateUnit(unit) && !Units::isMarkedForSlaughter(unit))
+                PushButcherableUnit(unit);
+        }
+        scanned_protected.clear();
+        scanned_butcherable.clear();
+    }
+
     void ClearUnits() {
+        scanned_protected.clear();
+        scanned_butcherable.clear();
         fk_prot = fa_prot = mk_prot = ma_prot = 0;
         fk_units = UnitsPQ(compareKids);
         fa_units = UnitsPQ(compareKids);
@@ -347,8 +375,15 @@ public:
         limit = std::max(limit, 0);
         int count = 0;
         while (units.size() > (size_t)limit) {
-            doMarkForSlaughter(units.top());
+            auto unit = units.top();
             units.pop();
+            // a unit that has become protected since it was scanned now
+            // counts towards the target instead
+            if (isProtectedUnit(unit)) {
+                limit = std::max(limit - 1, 0);
+                continue;
+            }
+            doMarkForSlaughter(unit);
             ++count;
         }
         return count;
@@ -676,74 +711,121 @@ static bool isProtectedUnit(df::unit *unit) {
         || !unit->name.nickname.empty();
 }
 
-static void autobutcher_cycle(color_ostream &out) {
-    // mark that we have recently run
-    cycle_timestamp = world->frame_counter;
+static void scan_unit(color_ostream &out, df::unit *unit) {
+    // this check is now divided into two steps, squeezed autowatch into the middle
+    // first one ignores completely inappropriate units (dead, undead, not belonging to the fort, ...)
+    // then let autowatch add units to the watchlist which will probably start breeding (owned pets, war animals, ...)
+    // then process units counting those which can't be butchered (war animals, named pets, ...)
+    // so that they are treated as "own stock" as well and count towards the target quota
+    if (isInappropriateUnit(unit)
+        || Units::isMarkedForSlaughter(unit)
+        || !Units::isTame(unit))
+        return;
+
+    WatchedRace *w;
+    if (watched_races.count(unit->race)) {
+        w = watched_races[unit->race];
+    }
+    else if (!config.get_bool(CONFIG_AUTOWATCH)) {
+        return;
+    }
+    else {
+        w = new WatchedRace(out, unit->race, true, config.get_int(CONFIG_DEFAULT_FK),
+            config.get_int(CONFIG_DEFAULT_MK), config.get_int(CONFIG_DEFAULT_FA),
+            config.get_int(CONFIG_DEFAULT_MA));
+        w->UpdateConfig(out);
+        watched_races.emplace(unit->race, w);
 
-    DEBUG(cycle,out).print("running {} cycle\n", plugin_name);
+        INFO(cycle,out).print("New race added to autobutcher watchlist: {}\n",
+            Units::getRaceNamePluralById(unit->race));
+    }
 
-    // check if there is anything to watch before walking through units vector
-    if (!config.get_bool(CONFIG_AUTOWATCH)) {
-        bool watching = false;
+    if (w->isWatched) {
+        // don't butcher protected units, but count them as stock as well
+        // this way they count towards target quota, so if you order that you want 1 female adult cat
+        // and have 2 cats, one of them being a pet, the other gets butchered
+        if(isProtectedUnit(unit))
+            w->scanned_protected.push_back(unit->id);
+        else
+            w->scanned_butcherable.push_back(unit->id);
+    }
+}
+
+// A cycle walks the active units a few at a time over several frames, sorting
+// them into the watched races, then marks the surplus once all have been seen.
+class AutobutcherCycle : public PluginTask {
+public:
+    AutobutcherCycle() : PluginTask("autobutcher", 1000) {}
+
+protected:
+    void begin(color_ostream &out) override {
+        DEBUG(cycle,out).print("running {} cycle\n", plugin_name);
+        // units can leave the active list between slices, so walk a snapshot
+        unit_ids.clear();
+        for (auto unit : world->units.active)
+            unit_ids.push_back(unit->id);
+        next_unit = 0;
+    }
+
+    bool step(color_ostream &out) override {
+        if (next_unit >= unit_ids.size())
+            return false;
+        if (auto unit = df::unit::find(unit_ids[next_unit++]))
+            scan_unit(out, unit);
+        return true;
+    }
+
+    void end(color_ostream &out) override {
         for (auto w : watched_races) {
-            if (w.second->isWatched) {
-                watching = true;
-                break;
+            w.second->PushScannedUnits();
+            int slaughter_count = w.second->ProcessUnits();
+            if (slaughter_count) {
+                std::stringstream ss;
+                ss << slaughter_count;
+                INFO(cycle,out).print("{} marked for slaughter: {}\n",
+                    Units::getRaceNamePluralById(w.first), ss.str());
             }
         }
-        if (!watching)
-            return;
     }
 
-    for (auto unit : world->units.active) {
-        // this check is now divided into two steps, squeezed autowatch into the middle
-        // first one ignores completely inappropriate units (dead, undead, not belonging to the fort, ...)
-        // then let autowatch add units to the watchlist which will probably start breeding (owned pets, war animals, ...)
-        // then process units counting those which can't be butchered (war animals, named pets, ...)
-        // so that they are treated as "own stock" as well and count towards the target quota
-        if (isInappropriateUnit(unit)
-            || Units::isMarkedForSlaughter(unit)
-            || !Units::isTame(unit))
-            continue;
+    void abandon() override {
+        for (auto w : watched_races)
+            w.second->ClearUnits();
+    }
 
-        WatchedRace *w;
-        if (watched_races.count(unit->race)) {
-            w = watched_races[unit->race];
-        }
-        else if (!config.get_bool(CONFIG_AUTOWATCH)) {
-            continue;
-        }
-        else {
-            w = new WatchedRace(out, unit->race, true, config.get_int(CONFIG_DEFAULT_FK),
-                config.get_int(CONFIG_DEFAULT_MK), config.get_int(CONFIG_DEFAULT_FA),
-                config.get_int(CONFIG_DEFAULT_MA));
-            w->UpdateConfig(out);
-            watched_races.emplace(unit->race, w);
-
-            INFO(cycle,out).print("New race added to autobutcher watchlist: {}\n",
-                Units::getRaceNamePluralById(unit->race));
-        }
+private:
+    vector<int32_t> unit_ids;
+    size_t next_unit = 0;
+};
 
-        if (w->isWatched) {
-            // don't butcher protected units, but count them as stock as well
-            // this way they count towards target quota, so if you order that you want 1 female adult cat
-            // and have 2 cats, one of them being a pet, the other gets butchered
-            if(isProtectedUnit(unit))
-                w->PushProtectedUnit(unit);
-            else
-                w->PushButcherableUnit(unit);
-        }
-    }
+static AutobutcherCycle cycle_task;
 
+static bool has_work() {
+    // check if there is anything to watch before walking through units vector
+    if (config.get_bool(CONFIG_AUTOWATCH))
+        return true;
     for (auto w : watched_races) {
-        int slaughter_count = w.second->ProcessUnits();
-        if (slaughter_count) {
-            std::stringstream ss;
-            ss << slaughter_count;
-            INFO(cycle,out).print("{} marked for slaughter: {}\n",
-                Units::getRaceNamePluralById(w.first), ss.str());
-        }
+        if (w.second->isWatched)
+            return true;
     }
+    return false;
+}
+
+// start a cycle that the core runs over the next frames
+static void start_cycle(color_ostream &out) {
+    // mark that we have recently run
+    cycle_timestamp = world->frame_counter;
+    if (has_work())
+        cycle_task.start(out, plugin_self);
+}
+
+// run a complete cycle right away
+static void autobutcher_cycle(color_ostream &out) {
+    cycle_timestamp = world->frame_counter;
+    if (!has_work())
+        return;
+    cycle_task.start(out, plugin_self);
+    cycle_task.finish(out);
 }
 
 /////////////////////////////////////
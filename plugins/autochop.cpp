@@ -105,6 +105,7 @@ static void validate_burrow_configs(color_ostream &out) {
 
 static const int32_t CYCLE_TICKS = 1181;
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 10);
 
 static command_result do_command(color_ostream &out, vector<string> &parameters);
 static int32_t do_cycle(color_ostream &out, bool force_designate = false);
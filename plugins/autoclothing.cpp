@@ -53,6 +53,7 @@ namespace DFHack {
 
 static const int32_t CYCLE_TICKS = 1283; // one day-ish
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 10);
 
 static const string CONFIG_KEY = string(plugin_name) + "/config";
 enum ConfigValues {
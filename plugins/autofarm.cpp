@@ -45,6 +45,7 @@ namespace DFHack {
 
 static const int32_t CYCLE_TICKS = 53; // one hour-ish
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 5);
 
 class AutoFarm {
 private:
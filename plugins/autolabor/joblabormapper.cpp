@@ -18,6 +18,7 @@
 #include "DataDefs.h"
 #include "MiscUtils.h"
 #include "modules/Materials.h"
+#include "modules/Raws.h"
 
 #include <df/building.h>
 #include <df/building_actual.h>
@@ -618,14 +619,12 @@ class jlfunc_custom : public jlfunc
 public:
     df::unit_labor get_labor(df::job* j)
     {
-        for (auto r : df::reaction::get_vector())
+        int32_t idx = Raws::findReaction(j->reaction_name);
+        if (idx >= 0)
         {
-            if (r->code == j->reaction_name)
-            {
-                df::job_skill skill = r->skill;
-                df::unit_labor labor = ENUM_ATTR(job_skill, labor, skill);
-                return labor;
-            }
+            df::job_skill skill = df::reaction::get_vector()[idx]->skill;
+            df::unit_labor labor = ENUM_ATTR(job_skill, labor, skill);
+            return labor;
         }
         return df::unit_labor::NONE;
     }
@@ -933,13 +932,11 @@ df::unit_labor JobLaborMapper::find_job_labor(df::job* j)
 {
     if (j->job_type == df::job_type::CustomReaction)
     {
-        for (auto r : df::reaction::get_vector())
+        int32_t idx = Raws::findReaction(j->reaction_name);
+        if (idx >= 0)
         {
-            if (r->code == j->reaction_name)
-            {
-                df::job_skill skill = r->skill;
-                return ENUM_ATTR(job_skill, labor, skill);
-            }
+            df::job_skill skill = df::reaction::get_vector()[idx]->skill;
+            return ENUM_ATTR(job_skill, labor, skill);
         }
         return df::unit_labor::NONE;
     }
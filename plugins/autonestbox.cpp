@@ -49,6 +49,7 @@ enum ConfigValues {
 static bool did_complain = false; // avoids message spam
 static const int32_t CYCLE_TICKS = 6067;
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 5);
 
 static command_result df_autonestbox(color_ostream &out, vector<string> &parameters);
 static void autonestbox_cycle(color_ostream &out);
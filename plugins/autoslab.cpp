@@ -122,6 +122,7 @@ DFhackCExport command_result plugin_onstatechange(color_ostream &out, state_chan
 }
 
 static const int32_t CYCLE_TICKS = 1289;
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 5);
 
 DFhackCExport command_result plugin_onupdate(color_ostream &out)
 {
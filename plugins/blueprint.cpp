@@ -11,6 +11,7 @@
 #include "DataIdentity.h"
 #include "Debug.h"
 #include "LuaTools.h"
+#include "MiscUtils.h"
 #include "PluginManager.h"
 #include "PluginLua.h"
 #include "TileTypes.h"
@@ -43,6 +44,8 @@
 #include "df/tile_occupancy.h"
 #include "df/world.h"
 
+#include <cstdio>
+#include <fstream>
 #include <queue>
 #include <sstream>
 #include <unordered_map>
@@ -165,24 +168,35 @@ struct tile_context {
 
 typedef vector<const char *> bp_row;     // index is x coordinate
 typedef map<int16_t, bp_row> bp_area;    // key is y coordinate
-typedef map<int16_t, bp_area> bp_volume; // key is z coordinate
 
 typedef const char * (get_tile_fn)(color_ostream &out, const df::coord &pos, const tile_context &ctx);
 typedef void (init_ctx_fn)(const df::coord &pos, tile_context &ctx);
 
+// Blueprints are generated one z-level at a time. Each processor collects the
+// tiles of the current z-level, appends them to its spool file, and then
+// forgets them, so memory use is bounded by a single z-level no matter how
+// deep the blueprint is. The spools are copied into the output files at the end.
 struct blueprint_processor {
-    bp_volume mapdata;
+    bp_area area;
+    // storage for the dynamically created tile strings of the current z-level
+    std::set<string> strings;
+    string spool_path;
+    std::fstream spool;
+    bool has_tiles = false;  // whether any z-level had tiles
+    bool has_output = false; // whether anything was written to the spool
+    int16_t zprev = 0;       // for minimal output: the next unwritten z index
     const string mode;
     const string phase;
     const bool force_create;
+    // whether get_tile can run on a worker thread (i.e. doesn't call into Lua)
+    const bool thread_safe;
     get_tile_fn * const get_tile;
     init_ctx_fn * const init_ctx;
-    std::set<df::building *> seen;
     blueprint_processor(const string &mode, const string &phase,
-                        bool force_create, get_tile_fn *get_tile,
-                        init_ctx_fn *init_ctx)
+                        bool force_create, bool thread_safe,
+                        get_tile_fn *get_tile, init_ctx_fn *init_ctx)
         : mode(mode), phase(phase), force_create(force_create),
-          get_tile(get_tile), init_ctx(init_ctx) { }
+          thread_safe(thread_safe), get_tile(get_tile), init_ctx(init_ctx) { }
 };
 
 // global caches, lazily initialized and cleared at the end of each blueprint
@@ -190,7 +204,8 @@ struct blueprint_processor {
 // which is currently ensured by the higher-level DFHack command handling code.
 // if this assumption ever becomes untrue, we'll need to protect the caches
 // with thread synchronization primitives or make the caches per-blueprint.
-static std::set<string> string_cache;
+// the caches are only read while phases are being generated, so they can be
+// shared by the worker threads.
 static std::unordered_map<df::coord, df::engraving *> engravings_cache;
 static std::unordered_map<df::coord, df::job *> dig_job_cache;
 static PersistentDataItem warm_config, damp_config;
@@ -223,7 +238,6 @@ static void init_caches(DFHack::color_ostream &out, bool cache_engravings) {
 }
 
 static void clear_caches() {
-    string_cache.clear();
     engravings_cache.clear();
     dig_job_cache.clear();
     warm_config = PersistentDataItem();
@@ -235,12 +249,14 @@ static void clear_caches() {
 // significantly speeds up processing and allows us to handle very large maps
 // (e.g. 16x16 embarks) without running out of memory. This cache provides a
 // mechanism for storing dynamically created strings so their memory stays
-// allocated until we write out the blueprints at the end.
-// If NULL is passed as the str, the cache is cleared.
+// allocated until the current z-level is written to the spool. Each thread
+// stores into the strings of the processor it is running.
+static thread_local std::set<string> *string_cache = NULL;
+
 static const char * cache(const char *str) {
     if (!str)
         return NULL;
-    return string_cache.emplace(str).first->c_str();
+    return string_cache->emplace(str).first->c_str();
 }
 
 // Convenience wrapper for std::string.
@@ -347,7 +363,7 @@ static const char * get_tile_dig(color_ostream &out, const df::coord &pos, const
     if (td && td->bits.dig != df::tile_dig_designation::No)
         return add_markers(pos, get_tile_dig_designation(pos, td->bits.dig));
     if (dig_job_cache.contains(pos))
-        if (const char * ret = get_tile_dig_job(td, dig_job_cache[pos]))
+        if (const char * ret = get_tile_dig_job(td, dig_job_cache.at(pos)))
             return add_markers(pos, ret);
 
     auto tt = Maps::getTileType(pos);
@@ -382,7 +398,7 @@ static const char * get_tile_dig(color_ostream &out, const df::coord &pos, const
 }
 
 static const char * get_tile_smooth_minimal(color_ostream &out, const df::coord &pos, const tile_context &) {
-    if (dig_job_cache.contains(pos) && dig_job_cache[pos]->job_type == df::job_type::CarveFortification)
+    if (dig_job_cache.contains(pos) && dig_job_cache.at(pos)->job_type == df::job_type::CarveFortification)
         return "s";
 
     auto tt = Maps::getTileType(pos);
@@ -411,8 +427,8 @@ static const char * get_tile_smooth_with_engravings(color_ostream &out, const df
         return smooth_minimal;
 
     if (dig_job_cache.contains(pos) &&
-            (dig_job_cache[pos]->job_type == df::job_type::DetailFloor ||
-             dig_job_cache[pos]->job_type == df::job_type::DetailWall))
+            (dig_job_cache.at(pos)->job_type == df::job_type::DetailFloor ||
+             dig_job_cache.at(pos)->job_type == df::job_type::DetailWall))
         return "s";
 
     if (auto td = Maps::getTileDesignation(pos); td && td->bits.smooth == 2)
@@ -443,8 +459,8 @@ static const char * get_tile_smooth_all(color_ostream &out, const df::coord &pos
         return smooth_minimal;
 
     if (dig_job_cache.contains(pos) &&
-            (dig_job_cache[pos]->job_type == df::job_type::SmoothFloor ||
-             dig_job_cache[pos]->job_type == df::job_type::SmoothWall))
+            (dig_job_cache.at(pos)->job_type == df::job_type::SmoothFloor ||
+             dig_job_cache.at(pos)->job_type == df::job_type::SmoothWall))
         return "s";
 
     if (auto td = Maps::getTileDesignation(pos); td && td->bits.smooth == 1)
@@ -492,7 +508,7 @@ static const char * get_tile_carve_minimal(color_ostream &out, const df::coord &
         return NULL;
 
     if (dig_job_cache.contains(pos)) {
-        df::job *job = dig_job_cache[pos];
+        df::job *job = dig_job_cache.at(pos);
         switch (job->job_type) {
         case df::job_type::CarveTrack:
             switch (tileShape(*tt))
@@ -543,8 +559,8 @@ static const char * get_tile_carve(color_ostream &out, const df::coord &pos, con
         return tile_carve_minimal;
 
     if (dig_job_cache.contains(pos) &&
-            (dig_job_cache[pos]->job_type == df::job_type::DetailFloor ||
-             dig_job_cache[pos]->job_type == df::job_type::DetailWall))
+            (dig_job_cache.at(pos)->job_type == df::job_type::DetailFloor ||
+             dig_job_cache.at(pos)->job_type == df::job_type::DetailWall))
         return "e";
 
     if (auto td = Maps::getTileDesignation(pos); td && td->bits.smooth == 2)
@@ -1416,60 +1432,67 @@ static bool is_meta_phase(color_ostream &out,
     return ret;
 }
 
-static void write_minimal(ofstream &ofile, const blueprint_options &opts,
-                          const bp_volume &mapdata) {
-    if (mapdata.begin() == mapdata.end())
+static void write_minimal_level(std::ostream &ofile, const blueprint_options &opts,
+                                blueprint_processor &processor, int16_t zidx) {
+    if (processor.area.empty())
         return;
 
     const string z_key = opts.depth > 0 ? "#<" : "#>";
 
-    int16_t zprev = 0;
-    for (auto &area : mapdata) {
-        for ( ; zprev < area.first; ++zprev)
-            ofile << z_key << endl;
-        int16_t yprev = 0;
-        for (auto &row : area.second) {
-            for ( ; yprev < row.first; ++yprev)
-                ofile << endl;
-            size_t xprev = 0;
-            auto &tiles = row.second;
-            size_t rowsize = tiles.size();
-            for (size_t x = 0; x < rowsize; ++x) {
-                if (!tiles[x])
-                    continue;
-                for ( ; xprev < x; ++xprev)
-                    ofile << ",";
-                ofile << tiles[x];
-            }
+    for ( ; processor.zprev < zidx; ++processor.zprev)
+        ofile << z_key << endl;
+    int16_t yprev = 0;
+    for (auto &row : processor.area) {
+        for ( ; yprev < row.first; ++yprev)
+            ofile << endl;
+        size_t xprev = 0;
+        auto &tiles = row.second;
+        size_t rowsize = tiles.size();
+        for (size_t x = 0; x < rowsize; ++x) {
+            if (!tiles[x])
+                continue;
+            for ( ; xprev < x; ++xprev)
+                ofile << ",";
+            ofile << tiles[x];
         }
-        ofile << endl;
     }
+    ofile << endl;
 }
 
-static void write_pretty(ofstream &ofile, const blueprint_options &opts,
-                         const bp_volume &mapdata) {
+static void write_pretty_level(std::ostream &ofile, const blueprint_options &opts,
+                               const blueprint_processor &processor, int16_t zidx) {
     const string z_key = opts.depth > 0 ? "#<" : "#>";
 
-    int16_t absdepth = abs(opts.depth);
-    for (int16_t z = 0; z < absdepth; ++z) {
-        const bp_area *area = NULL;
-        if (mapdata.count(z))
-            area = &mapdata.at(z);
-        for (int16_t y = 0; y < opts.height; ++y) {
-            const bp_row *row = NULL;
-            if (area && area->count(y))
-                row = &area->at(y);
-            for (int16_t x = 0; x < opts.width; ++x) {
-                const char *tile = NULL;
-                if (row)
-                    tile = row->at(x);
-                ofile << (tile ? tile : " ") << ",";
-            }
-            ofile << "#" << endl;
+    for (int16_t y = 0; y < opts.height; ++y) {
+        const bp_row *row = NULL;
+        if (processor.area.count(y))
+            row = &processor.area.at(y);
+        for (int16_t x = 0; x < opts.width; ++x) {
+            const char *tile = NULL;
+            if (row)
+                tile = row->at(x);
+            ofile << (tile ? tile : " ") << ",";
         }
-        if (z < absdepth - 1)
-            ofile << z_key << endl;
+        ofile << "#" << endl;
     }
+    if (zidx < abs(opts.depth) - 1)
+        ofile << z_key << endl;
+}
+
+// appends the tiles of the current z-level to the spool and releases them
+static void spool_level(const blueprint_options &opts, blueprint_processor &processor,
+                        bool pretty, int16_t zidx) {
+    if (!processor.area.empty())
+        processor.has_tiles = true;
+    if (pretty || !processor.area.empty()) {
+        if (pretty)
+            write_pretty_level(processor.spool, opts, processor, zidx);
+        else
+            write_minimal_level(processor.spool, opts, processor, zidx);
+        processor.has_output = true;
+    }
+    processor.area.clear();
+    processor.strings.clear();
 }
 
 static string get_modeline(color_ostream &out, const blueprint_options &opts,
@@ -1493,8 +1516,8 @@ static string get_modeline(color_ostream &out, const blueprint_options &opts,
 static bool write_blueprint(color_ostream &out,
                             map<string, ofstream*> &output_files,
                             const blueprint_options &opts,
-                            const blueprint_processor &processor,
-                            bool pretty, int32_t ordinal) {
+                            blueprint_processor &processor,
+                            int32_t ordinal) {
     string fname;
     if (!get_filename(fname, out, opts, processor.phase, ordinal))
         return false;
@@ -1504,10 +1527,11 @@ static bool write_blueprint(color_ostream &out,
     ofstream &ofile = *output_files[fname];
     ofile << get_modeline(out, opts, processor.mode, processor.phase) << endl;
 
-    if (pretty)
-        write_pretty(ofile, opts, processor.mapdata);
-    else
-        write_minimal(ofile, opts, processor.mapdata);
+    if (processor.has_output) {
+        processor.spool.flush();
+        processor.spool.seekg(0);
+        ofile << processor.spool.rdbuf();
+    }
 
     return true;
 }
@@ -1543,21 +1567,55 @@ static void ensure_building(const df::coord &pos, tile_context &ctx) {
 static void add_processor(vector<blueprint_processor> &processors,
                           const blueprint_options &opts, const char *mode,
                           const char *phase, bool require_phase,
-                          get_tile_fn * const get_tile,
+                          bool thread_safe, get_tile_fn * const get_tile,
                           init_ctx_fn * const init_ctx = NULL) {
     if (opts.auto_phase || require_phase)
         processors.push_back(blueprint_processor(mode, phase, require_phase,
-                                                 get_tile, init_ctx));
+                                                 thread_safe, get_tile,
+                                                 init_ctx));
+}
+
+static void process_level(color_ostream &out, blueprint_processor &processor,
+                          const df::coord &start, const df::coord &end,
+                          int32_t z, int16_t width, bool pretty) {
+    // empty row instance to pass to emplace() below
+    static const bp_row EMPTY_ROW;
+
+    string_cache = &processor.strings;
+    for (int32_t y = start.y; y < end.y; y++) {
+        for (int32_t x = start.x; x < end.x; x++) {
+            df::coord pos(x, y, z);
+            tile_context ctx;
+            ctx.pretty = pretty;
+            ctx.processor = &processor;
+            if (processor.init_ctx)
+                processor.init_ctx(pos, ctx);
+            const char *tile_str = processor.get_tile(out, pos, ctx);
+            if (tile_str) {
+                auto row = processor.area.emplace(y - start.y, EMPTY_ROW);
+                auto &tiles = row.first->second;
+                if (row.second)
+                    tiles.resize(width);
+                tiles[x - start.x] = tile_str;
+            }
+        }
+    }
+    string_cache = NULL;
+}
+
+static void close_spools(vector<blueprint_processor> &processors) {
+    for (blueprint_processor &processor : processors) {
+        if (processor.spool.is_open())
+            processor.spool.close();
+        if (!processor.spool_path.empty())
+            std::remove(processor.spool_path.c_str());
+    }
 }
 
 static bool do_transform(color_ostream &out,
                          const df::coord &start, const df::coord &end,
                          blueprint_options opts, // copy so we can munge it
                          vector<string> &filenames) {
-    // empty map instances to pass to emplace() below
-    static const bp_area EMPTY_AREA;
-    static const bp_row EMPTY_ROW;
-
     init_caches(out, opts.engrave);
 
     vector<blueprint_processor> processors;
@@ -1566,18 +1624,21 @@ static bool do_transform(color_ostream &out,
     if (opts.engrave) smooth_get_tile_fn = get_tile_smooth_with_engravings;
     if (opts.smooth) smooth_get_tile_fn = get_tile_smooth_all;
 
-    add_processor(processors, opts, "dig", "dig", opts.dig, get_tile_dig);
-    add_processor(processors, opts, "dig", "smooth", opts.carve,
+    add_processor(processors, opts, "dig", "dig", opts.dig, true, get_tile_dig);
+    add_processor(processors, opts, "dig", "smooth", opts.carve, true,
                   smooth_get_tile_fn);
-    add_processor(processors, opts, "dig", "carve", opts.carve,
+    add_processor(processors, opts, "dig", "carve", opts.carve, true,
                   opts.engrave ? get_tile_carve : get_tile_carve_minimal);
     add_processor(processors, opts, "build", "construct", opts.construct,
-                  get_tile_construct, ensure_building);
-    add_processor(processors, opts, "build", "build", opts.build,
+                  true, get_tile_construct, ensure_building);
+    add_processor(processors, opts, "build", "build", opts.build, true,
                   get_tile_build, ensure_building);
-    add_processor(processors, opts, "place", "place", opts.place,
+    // stockpile and zone properties are read through Lua, so these phases
+    // have to run on the main thread
+    add_processor(processors, opts, "place", "place", opts.place, false,
                   get_tile_place, ensure_building);
-    add_processor(processors, opts, "zone", "zone", opts.zone, get_tile_zone);
+    add_processor(processors, opts, "zone", "zone", opts.zone, false,
+                  get_tile_zone);
     if (processors.empty()) {
         out.printerr("no phases requested! nothing to do!\n");
         return false;
@@ -1586,38 +1647,46 @@ static bool do_transform(color_ostream &out,
     if (!create_output_dir(out, opts))
         return false;
 
+    const string spool_base = BLUEPRINT_USER_DIR + opts.name;
+    for (blueprint_processor &processor : processors) {
+        processor.spool_path = spool_base + "." + processor.phase + ".spool";
+        processor.spool.open(processor.spool_path, std::ios::in | std::ios::out | std::ios::trunc);
+        if (!processor.spool.is_open()) {
+            out.printerr("could not create temporary file: '{}'\n", processor.spool_path);
+            close_spools(processors);
+            return false;
+        }
+    }
+
+    vector<blueprint_processor *> parallel, serial;
+    for (blueprint_processor &processor : processors)
+        (processor.thread_safe ? parallel : serial).push_back(&processor);
+
+    // the phases only read the map and the caches above, so the independent
+    // phases of each z-level are generated concurrently. the core is suspended
+    // for the whole command, so the game can't change the map underneath us.
     const bool pretty = opts.format != "minimal";
     const int32_t z_inc = start.z < end.z ? 1 : -1;
     for (int32_t z = start.z; z != end.z; z += z_inc) {
-        for (int32_t y = start.y; y < end.y; y++) {
-            for (int32_t x = start.x; x < end.x; x++) {
-                df::coord pos(x, y, z);
-                tile_context ctx;
-                ctx.pretty = pretty;
-                for (blueprint_processor &processor : processors) {
-                    ctx.processor = &processor;
-                    if (processor.init_ctx)
-                        processor.init_ctx(pos, ctx);
-                    const char *tile_str = processor.get_tile(out, pos, ctx);
-                    if (tile_str) {
-                        // ensure our z-index is in the order we want to write
-                        auto area = processor.mapdata.emplace(abs(z - start.z),
-                                                              EMPTY_AREA);
-                        auto row = area.first->second.emplace(y - start.y,
-                                                              EMPTY_ROW);
-                        auto &tiles = row.first->second;
-                        if (row.second)
-                            tiles.resize(opts.width);
-                        tiles[x - start.x] = tile_str;
-                    }
-                }
-            }
+        parallel_for(parallel.size(), [&](size_t idx) {
+            process_level(out, *parallel[idx], start, end, z, opts.width, pretty);
+        });
+        for (auto processor : serial)
+            process_level(out, *processor, start, end, z, opts.width, pretty);
+        for (blueprint_processor &processor : processors)
+            spool_level(opts, processor, pretty, abs(z - start.z));
+    }
+    // pretty blueprints also include the levels that were cropped at the map edge
+    if (pretty) {
+        for (int16_t zidx = abs(end.z - start.z); zidx < abs(opts.depth); ++zidx) {
+            for (blueprint_processor &processor : processors)
+                spool_level(opts, processor, pretty, zidx);
         }
     }
 
     vector<string> meta_phases;
     for (blueprint_processor &processor : processors) {
-        if (processor.mapdata.empty() && !processor.force_create)
+        if (!processor.has_tiles && !processor.force_create)
             continue;
         if (is_meta_phase(out, opts, processor.phase))
             meta_phases.push_back(processor.phase);
@@ -1629,7 +1698,7 @@ static bool do_transform(color_ostream &out,
     int32_t ordinal = 0;
     map<string, ofstream*> output_files;
     for (blueprint_processor &processor : processors) {
-        if (processor.mapdata.empty() && !processor.force_create)
+        if (!processor.has_tiles && !processor.force_create)
             continue;
         bool meta_phase = is_meta_phase(out, opts, processor.phase);
         if (!in_meta)
@@ -1639,8 +1708,7 @@ static bool do_transform(color_ostream &out,
             ++ordinal;
         }
         in_meta = meta_phase;
-        if (!write_blueprint(out, output_files, opts, processor, pretty,
-                             ordinal))
+        if (!write_blueprint(out, output_files, opts, processor, ordinal))
             break;
     }
     if (in_meta)
@@ -1652,6 +1720,8 @@ static bool do_transform(color_ostream &out,
         delete(it.second);
     }
 
+    close_spools(processors);
+
     return true;
 }
 
@@ -1,6 +1,7 @@
 #include "buildingplan.h"
 #include "buildingtypekey.h"
 #include "defaultitemfilters.h"
+#include "itemindex.h"
 #include "plannedbuilding.h"
 
 #include "Debug.h"
@@ -71,7 +72,6 @@ void PlannedBuilding::remove(color_ostream &out) {
 
 static const int32_t CYCLE_TICKS = 599; // twice per game day
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
-int32_t walkability_timestamp = -1; // world->frame_counter at last update of walkability groups
 
 static int get_num_filters(color_ostream &out, BuildingTypeKey key) {
     int num_filters = 0;
@@ -194,7 +194,6 @@ static DefaultItemFilters & get_item_filters(color_ostream &out, const BuildingT
 }
 
 static command_result do_command(color_ostream &out, vector<string> &parameters);
-void update_walkability_groups();
 void buildingplan_cycle(color_ostream &out, Tasks &tasks,
         unordered_map<int32_t, PlannedBuilding> &planned_buildings, bool unsuspend_on_finalize);
 
@@ -276,6 +275,8 @@ static bool is_suspendmanager_enabled(color_ostream &out) {
 
 DFhackCExport command_result plugin_load_world_data (color_ostream &out) {
     mat_cache.clear();
+    clearMaterialTraits();
+    item_index.clear();
     load_material_cache();
     Lua::CallLuaModuleFunction(out, "plugins.buildingplan", "reload_pens");
     return CR_OK;
@@ -283,7 +284,7 @@ DFhackCExport command_result plugin_load_world_data (color_ostream &out) {
 
 DFhackCExport command_result plugin_load_site_data (color_ostream &out) {
     cycle_timestamp = 0;
-    walkability_timestamp = -1;
+    item_index.clear();
     config = World::GetPersistentSiteData(CONFIG_KEY);
 
     if (!config.isValid()) {
@@ -681,13 +682,17 @@ static int scanAvailableItems(color_ostream &out, df::building_type type, int16_
         filter.setMaxQuality(df::item_quality::Artifact);
     }
 
-    update_walkability_groups(); // ensure that itemPassesScreen is accurate
-
     int count = 0;
     for (auto vector_id : vector_ids) {
         auto other_id = ENUM_ATTR(job_item_vector_id, other, vector_id);
-        for (auto &item : df::global::world->items.other[other_id]) {
-            if (itemPassesScreen(out, item) && matchesFilters(item, jitem, heat, filter, special)) {
+        for (auto &[key, group] : item_index.getGroups(other_id)) {
+            if (!matchesMaterialFilters(key.item_type, key.item_subtype,
+                                        key.mat_type, key.mat_index, jitem, heat))
+                continue;
+            for (auto &member : group) {
+                auto item = member.item;
+                if (!itemPassesLocationScreen(out, item) || !matchesItemFilters(item, jitem, filter, special))
+                    continue;
                 if (item_ids)
                     item_ids->emplace_back(item->id);
                 if (counts) {
@@ -6,6 +6,7 @@
 
 #include "df/building.h"
 #include "df/burrow.h"
+#include "df/item_type.h"
 #include "df/job_item.h"
 #include "df/job_item_vector_id.h"
 
@@ -17,7 +18,6 @@ typedef std::map<df::job_item_vector_id, std::map<std::string, Bucket>> Tasks;
 
 extern const std::string FILTER_CONFIG_KEY;
 extern const std::string BLD_CONFIG_KEY;
-extern int32_t walkability_timestamp;
 
 enum ConfigValues {
     CONFIG_BLOCKS = 1,
@@ -53,9 +53,12 @@ enum ItemSelectionChoice {
 };
 
 std::vector<df::job_item_vector_id> getVectorIds(DFHack::color_ostream &out, const df::job_item *job_item, bool ignore_filters);
-bool itemPassesScreen(DFHack::color_ostream& out, df::item* item);
+bool itemPassesFlagScreen(df::item* item);
+bool itemPassesLocationScreen(DFHack::color_ostream& out, df::item* item);
 bool matchesHeatSafety(int16_t mat_type, int32_t mat_index, HeatSafety heat);
-bool matchesFilters(df::item * item, const df::job_item * job_item, HeatSafety heat, const ItemFilter &item_filter, const std::set<std::string> &special);
+bool matchesMaterialFilters(df::item_type itype, int16_t isubtype, int16_t mat_type, int32_t mat_index,
+        const df::job_item * job_item, HeatSafety heat);
+bool matchesItemFilters(df::item * item, const df::job_item * job_item, const ItemFilter &item_filter, const std::set<std::string> &special);
 bool isJobReady(DFHack::color_ostream &out, const std::vector<df::job_item *> &jitems);
 void finalizeBuilding(DFHack::color_ostream &out, df::building *bld, bool unsuspend_on_finalize);
 df::burrow *getIgnoreBurrow();
@@ -1,5 +1,6 @@
 #include "plannedbuilding.h"
 #include "buildingplan.h"
+#include "itemindex.h"
 
 #include "Debug.h"
 
@@ -46,29 +47,6 @@ struct BadFlags {
     }
 };
 
-// cache of walkability groups that have citizens in them
-static std::unordered_set<uint16_t> accessible_walkability_groups;
-
-void update_walkability_groups(){
-
-    // ensure that we update at most once per tick
-    auto frame_counter = df::global::world->frame_counter;
-    if (frame_counter == walkability_timestamp)
-        return;
-    else
-        walkability_timestamp = frame_counter;
-
-    accessible_walkability_groups.clear();
-    auto get_group = [](df::unit *unit){
-        auto group = Maps::getWalkableGroup(Units::getPosition(unit));
-        if (group != 0)
-        {
-            accessible_walkability_groups.insert(group);
-        }
-    };
-    Units::forCitizens(get_group);
-}
-
 // This is tricky. we want to choose an item that can be brought to the job site, but that's not
 // necessarily the same as job->pos. it could be many tiles off in any direction (e.g. for bridges), or
 // up or down (e.g. for stairs). For now, just return if the item is in the same walkability group
@@ -76,28 +54,12 @@ void update_walkability_groups(){
 static bool isAccessible(color_ostream& out, df::item* item) {
     df::coord item_pos = Items::getPosition(item);
     uint16_t walkability_group = Maps::getWalkableGroup(item_pos);
-    bool is_walkable = accessible_walkability_groups.contains(walkability_group);
+    bool is_walkable = Maps::getCitizenWalkableGroups().contains(walkability_group);
     TRACE(cycle, out).print("item {} in walkability_group {} at ({},{},{}) is {}accessible from job site\n",
         item->id, walkability_group, item_pos.x, item_pos.y, item_pos.z, is_walkable ? "(probably) " : "not ");
     return is_walkable;
 }
 
-// as of v50, soap, coal, and ash are no longer valid building materials
-static bool isUnusableBar(color_ostream& out, df::item* item) {
-    if (item->getType() != df::item_type::BAR)
-        return false;
-
-    MaterialInfo minfo(item);
-    string token = minfo.getToken();
-    if (token.starts_with("COAL:") || token == "ASH")
-        return true;
-
-    df::job_item_flags2 ok;
-    df::job_item_flags2 mask;
-    minfo.getMatchBits(ok, mask);
-    return ok.bits.soap;
-}
-
 static bool isInWheelbarrow(color_ostream& out, df::item* item) {
     auto container = Items::getContainer(item);
     if (!container || container->getType() != df::item_type::TOOL)
@@ -110,12 +72,14 @@ bool isInIgnoreBurrow(df::item *item){
     return ignore_burrow && Burrows::isAssignedTile(ignore_burrow, Items::getPosition(item));
 }
 
-bool itemPassesScreen(color_ostream& out, df::item* item) {
+bool itemPassesFlagScreen(df::item* item) {
     static const BadFlags bad_flags;
-    return !(item->flags.whole & bad_flags.whole)
-        && !item->isAssignedToStockpile()
+    return !(item->flags.whole & bad_flags.whole);
+}
+
+bool itemPassesLocationScreen(color_ostream& out, df::item* item) {
+    return !item->isAssignedToStockpile()
         && isAccessible(out, item)
-        && !isUnusableBar(out, item)
         && !isInWheelbarrow(out, item)
         && !isInIgnoreBurrow(item);
 }
@@ -124,27 +88,31 @@ bool matchesHeatSafety(int16_t mat_type, int32_t mat_index, HeatSafety heat) {
      if (heat == HEAT_SAFETY_ANY)
         return true;
 
-    MaterialInfo minfo(mat_type, mat_index);
-    df::job_item_flags2 ok;
-    df::job_item_flags2 mask;
-    minfo.getMatchBits(ok, mask);
-
+    auto &traits = getMaterialTraits(mat_type, mat_index);
     if (heat >= HEAT_SAFETY_MAGMA)
-        return ok.bits.magma_safe;
+        return traits.magma_safe;
     if (heat == HEAT_SAFETY_FIRE)
-        return ok.bits.fire_safe || ok.bits.magma_safe;
+        return traits.fire_safe || traits.magma_safe;
     return false;
 }
 
-bool matchesFilters(df::item * item, const df::job_item * jitem, HeatSafety heat, const ItemFilter &item_filter, const std::set<string> &specials) {
+bool matchesMaterialFilters(df::item_type itype, int16_t isubtype, int16_t mat_type, int32_t mat_index,
+        const df::job_item * jitem, HeatSafety heat) {
     // check the properties that are not checked by Job::isSuitableItem()
-    if (jitem->item_type > -1 && jitem->item_type != item->getType())
+    if (jitem->item_type > -1 && jitem->item_type != itype)
+        return false;
+
+    if (jitem->item_subtype > -1 && jitem->item_subtype != isubtype)
         return false;
 
-    if (jitem->item_subtype > -1 &&
-        jitem->item_subtype != item->getSubtype())
+    if (!matchesHeatSafety(mat_type, mat_index, heat))
         return false;
 
+    return Job::isSuitableItem(jitem, itype, isubtype)
+        && Job::isSuitableMaterial(jitem, mat_type, mat_index, itype);
+}
+
+bool matchesItemFilters(df::item * item, const df::job_item * jitem, const ItemFilter &item_filter, const std::set<string> &specials) {
     if (jitem->flags2.bits.building_material && !item->isBuildMat())
         return false;
 
@@ -180,12 +148,7 @@ bool matchesFilters(df::item * item, const df::job_item * jitem, HeatSafety heat
             || Items::getGeneralRef(item, df::general_ref_type::CONTAINS_ITEM)))
         return false;
 
-    if (!matchesHeatSafety(item->getMaterial(), item->getMaterialIndex(), heat))
-        return false;
-
-    return Job::isSuitableItem(jitem, itype, item->getSubtype())
-        && Job::isSuitableMaterial(jitem, item->getMaterial(), item->getMaterialIndex(), itype)
-        && item_filter.matches(item);
+    return item_filter.matches(item);
 }
 
 bool isJobReady(color_ostream &out, const std::vector<df::job_item *> &jitems) {
@@ -271,24 +234,27 @@ static void doVector(color_ostream &out, df::job_item_vector_id vector_id,
         unordered_map<int32_t, PlannedBuilding> &planned_buildings,
         bool unsuspend_on_finalize) {
     auto other_id = ENUM_ATTR(job_item_vector_id, other, vector_id);
-    const auto item_vector = df::global::world->items.other[other_id];
+    auto &groups = item_index.getGroups(other_id);
 
-    DEBUG(cycle,out).print("matching {} item(s) in vector {} against {} filter bucket(s)\n",
-          item_vector.size(),
+    DEBUG(cycle,out).print("matching {} item group(s) in vector {} against {} filter bucket(s)\n",
+          groups.size(),
           ENUM_KEY_STR(job_item_vector_id, vector_id),
           buckets.size());
 
+    // the location screen is only run for items whose group matches a bucket,
+    // and at most once per item
+    unordered_map<int32_t, bool> location_ok;
+    auto passesLocationScreen = [&](df::item *item) {
+        auto [it, inserted] = location_ok.try_emplace(item->id, false);
+        if (inserted)
+            it->second = itemPassesLocationScreen(out, item);
+        return it->second;
+    };
+
     //  items we might want to attach (and their positions)
-    std::vector<df::item*> available;
-    for (auto item : item_vector) {
-        if (itemPassesScreen(out, item))
-            available.emplace_back(item);
-    }
     std::vector<std::pair<df::coord, df::item*>> matching;
     size_t num_matching = 0;
 
-    DEBUG(cycle,out).print("{} items available for assignment\n", available.size());
-
     for (auto bucket_it = buckets.begin(); bucket_it != buckets.end(); ) {
 
         TRACE(cycle,out).print("scanning bucket: {}/{}\n",
@@ -311,14 +277,23 @@ static void doVector(color_ostream &out, df::job_item_vector_id vector_id,
             // first task of the bucket: filter/count available items
             if (first_task) {
                 matching.clear();
-                for(auto item : available)
-                    if (!item->flags.bits.in_job &&
-                        matchesFilters(item,
-                                       jitems[filter_idx],
-                                       pb.heat_safety,
-                                       pb.item_filters[rev_filter_idx],
-                                       pb.specials))
-                        matching.emplace_back(Items::getPosition(item),item);
+                auto jitem = jitems[filter_idx];
+                for (auto &[key, group] : groups) {
+                    if (!matchesMaterialFilters(key.item_type, key.item_subtype,
+                                                key.mat_type, key.mat_index,
+                                                jitem, pb.heat_safety))
+                        continue;
+                    for (auto &member : group) {
+                        auto item = member.item;
+                        if (!item->flags.bits.in_job &&
+                            passesLocationScreen(item) &&
+                            matchesItemFilters(item,
+                                               jitem,
+                                               pb.item_filters[rev_filter_idx],
+                                               pb.specials))
+                            matching.emplace_back(Items::getPosition(item),item);
+                    }
+                }
 
                 num_matching = matching.size();
                 first_task = false;
@@ -405,8 +380,6 @@ void buildingplan_cycle(color_ostream &out, Tasks &tasks,
             "running buildingplan cycle for %zu registered buildings\n",
             planned_buildings.size());
 
-    update_walkability_groups();
-
     for (auto it = tasks.begin(); it != tasks.end(); ) {
         auto vector_id = it->first;
         // we could make this a set, but it's only a few elements
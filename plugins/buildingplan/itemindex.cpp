@@ -0,0 +1,112 @@
+#include "buildingplan.h"
+#include "itemindex.h"
+
+#include "modules/Materials.h"
+
+#include "df/item.h"
+#include "df/world.h"
+
+using std::string;
+
+ItemIndex item_index;
+
+// materials don't change while a world is loaded, so their traits only need
+// to be decoded once
+static std::unordered_map<uint64_t, MaterialTraits> material_traits;
+
+const MaterialTraits & getMaterialTraits(int16_t mat_type, int32_t mat_index) {
+    uint64_t key = (uint64_t(uint16_t(mat_type)) << 32) | uint32_t(mat_index);
+    auto it = material_traits.find(key);
+    if (it != material_traits.end())
+        return it->second;
+
+    DFHack::MaterialInfo minfo(mat_type, mat_index);
+    df::job_item_flags2 ok;
+    df::job_item_flags2 mask;
+    minfo.getMatchBits(ok, mask);
+    string token = minfo.getToken();
+
+    MaterialTraits traits;
+    traits.fire_safe = ok.bits.fire_safe;
+    traits.magma_safe = ok.bits.magma_safe;
+    traits.unusable_bar = ok.bits.soap || token.starts_with("COAL:") || token == "ASH";
+    return material_traits.emplace(key, traits).first->second;
+}
+
+void clearMaterialTraits() {
+    material_traits.clear();
+}
+
+std::size_t ItemIndex::KeyHash::operator() (const Key &key) const {
+    uint64_t packed = (uint64_t(uint16_t(int16_t(key.item_type))) << 48)
+        | (uint64_t(uint16_t(key.item_subtype)) << 32)
+        | uint32_t(key.mat_index);
+    return std::hash<uint64_t>()(packed) ^ (std::hash<int16_t>()(key.mat_type) << 1);
+}
+
+void ItemIndex::insert(VectorIndex &index, Entry &entry, int32_t id, df::item *item, const Key &key) {
+    auto &group = index.groups[key];
+    entry.indexed = true;
+    entry.key = key;
+    entry.slot = group.size();
+    group.push_back({id, item});
+}
+
+void ItemIndex::erase(VectorIndex &index, Entry &entry) {
+    auto group_it = index.groups.find(entry.key);
+    auto &group = group_it->second;
+    // move the last member into the vacated slot. members are only identified
+    // by id here since the item may already have been deleted.
+    auto last = group.back();
+    group[entry.slot] = last;
+    index.entries.at(last.id).slot = entry.slot;
+    group.pop_back();
+    if (group.empty())
+        index.groups.erase(group_it);
+    entry.indexed = false;
+}
+
+const ItemIndex::Groups & ItemIndex::getGroups(df::items_other_id other_id) {
+    auto &index = vectors[other_id];
+    uint32_t generation = ++index.generation;
+
+    auto &item_vector = df::global::world->items.other[other_id];
+    for (auto item : item_vector) {
+        auto [it, inserted] = index.entries.try_emplace(item->id);
+        auto &entry = it->second;
+        entry.generation = generation;
+        if (!inserted && entry.flags == item->flags.whole)
+            continue;
+
+        entry.flags = item->flags.whole;
+        if (entry.indexed)
+            erase(index, entry);
+        if (itemPassesFlagScreen(item)) {
+            Key key{item->getType(), item->getSubtype(),
+                    item->getMaterial(), item->getMaterialIndex()};
+            // as of v50, soap, coal, and ash are no longer valid building materials
+            if (key.item_type != df::item_type::BAR
+                    || !getMaterialTraits(key.mat_type, key.mat_index).unusable_bar)
+                insert(index, entry, item->id, item, key);
+        }
+    }
+
+    // drop the items that have left the vector since the last refresh
+    if (index.entries.size() > item_vector.size()) {
+        for (auto it = index.entries.begin(); it != index.entries.end(); ) {
+            if (it->second.generation == generation) {
+                ++it;
+                continue;
+            }
+            if (it->second.indexed)
+                erase(index, it->second);
+            it = index.entries.erase(it);
+        }
+    }
+
+    return index.groups;
+}
+
+void ItemIndex::clear() {
+    vectors.clear();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "df/item_type.h"
+#include "df/items_other_id.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace df {
+    struct item;
+}
+
+// properties of a material that the cycle checks for every candidate item
+struct MaterialTraits {
+    bool fire_safe;
+    bool magma_safe;
+    bool unusable_bar; // soap, coal, and ash are no longer building materials
+};
+
+const MaterialTraits & getMaterialTraits(int16_t mat_type, int32_t mat_index);
+void clearMaterialTraits();
+
+// Index of the items in an items.other vector that pass the flag and material
+// screens, grouped by the properties that filters test for the group as a
+// whole: item type, item subtype, and material. The index for each vector is
+// kept between cycles and refreshed by comparing item flags with what was
+// seen last time, so only items that changed, appeared, or disappeared are
+// screened again.
+class ItemIndex {
+public:
+    struct Key {
+        df::item_type item_type;
+        int16_t item_subtype;
+        int16_t mat_type;
+        int32_t mat_index;
+
+        bool operator==(const Key &other) const = default;
+    };
+
+    struct KeyHash {
+        std::size_t operator() (const Key &key) const;
+    };
+
+    struct Member {
+        int32_t id;
+        df::item *item;
+    };
+
+    typedef std::unordered_map<Key, std::vector<Member>, KeyHash> Groups;
+
+    // brings the index for the vector up to date and returns its groups
+    const Groups & getGroups(df::items_other_id other_id);
+
+    void clear();
+
+private:
+    struct Entry {
+        uint32_t flags = 0;
+        uint32_t generation = 0;
+        bool indexed = false;
+        Key key;
+        size_t slot = 0;
+    };
+
+    struct VectorIndex {
+        uint32_t generation = 0;
+        std::unordered_map<int32_t, Entry> entries;
+        Groups groups;
+    };
+
+    std::unordered_map<int32_t, VectorIndex> vectors;
+
+    static void insert(VectorIndex &index, Entry &entry, int32_t id, df::item *item, const Key &key);
+    static void erase(VectorIndex &index, Entry &entry);
+};
+
+extern ItemIndex item_index;
@@ -6,8 +6,13 @@
 #include "DataDefs.h"
 #include "DataIdentity.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <map>
+#include <mutex>
+#include <sstream>
 #include <string>
 
 using namespace DFHack;
@@ -68,13 +73,20 @@ namespace
 class Checker
 {
     color_ostream & out;
+    // snapshot of the mapped memory ranges, sorted by start address
     std::vector<t_memrange> mapped;
     std::map<const void *, std::pair<std::string, CheckedStructure>> data;
     std::deque<QueueItem> queue;
+    // guards data, queue, and out while worker threads are running
+    std::recursive_mutex state_mutex;
+    std::condition_variable_any queue_cond;
+    size_t active_workers;
+    std::chrono::steady_clock::duration elapsed;
+    std::chrono::steady_clock::time_point last_progress;
 public:
-    size_t checked_count;
-    size_t error_count;
-    size_t maxerrors;
+    std::atomic<size_t> checked_count;
+    std::atomic<size_t> error_count;
+    std::atomic<size_t> maxerrors;
     bool maxerrors_reported;
     bool enums;
     bool sizes;
@@ -83,13 +95,25 @@ public:
     bool noprogress;
     bool maybepointer;
     uint8_t perturb_byte;
+    size_t threads;
+    std::chrono::milliseconds budget;
 
     Checker(color_ostream & out);
-    bool queue_item(const QueueItem & item, CheckedStructure cs);
+    // records the item as seen and, unless defer is false, queues it to be
+    // dispatched later. returns false if the item was already seen.
+    bool queue_item(const QueueItem & item, CheckedStructure cs, bool defer = true);
     void queue_globals();
+    // dispatches one queued item. returns false if the queue was empty.
     bool process_queue();
+    // dispatches queued items on the worker threads until the queue is empty
+    // or, if budget is nonzero, until budget has passed. returns false once
+    // the queue is empty.
+    bool process_queue_for(std::chrono::milliseconds budget);
+    bool process_queue_for() { return process_queue_for(budget); }
+    void report_progress(bool final);
 
     bool is_in_global(const QueueItem & item);
+    const t_memrange *find_mapped_range(const void *ptr) const;
     bool is_valid_dereference(const QueueItem & item, const CheckedStructure & cs, size_t size, bool quiet);
     inline bool is_valid_dereference(const QueueItem & item, const CheckedStructure & cs, bool quiet = false)
     {
@@ -121,7 +145,8 @@ public:
     static const char *const *get_enum_item_attr_or_key(const enum_identity *identity, int64_t value, const char *attr_name);
 
 private:
-    color_ostream & fail(int, const QueueItem &, const CheckedStructure &);
+    void snapshot_mapped_ranges();
+    void fail(int, const QueueItem &, const CheckedStructure &, const std::string &);
     void dispatch_item(const QueueItem &, const CheckedStructure &);
     void dispatch_single_item(const QueueItem &, const CheckedStructure &);
     void dispatch_primitive(const QueueItem &, const CheckedStructure &);
@@ -154,9 +179,9 @@ private:
 #define FAIL(message) \
     do \
     { \
-        auto & failstream = fail(__LINE__, item, cs); \
+        std::ostringstream failstream; \
         failstream << message; \
-        failstream << COLOR_RESET << std::endl; \
+        fail(__LINE__, item, cs, failstream.str()); \
         if (failfast) \
             UNEXPECTED; \
     } \
@@ -1,12 +1,18 @@
 #include "check-structures-sanity.h"
 
+#include "MiscUtils.h"
+
+#include <algorithm>
 #include <cinttypes>
 #include <queue>
+#include <thread>
 
 #include "df/large_integer.h"
 
 Checker::Checker(color_ostream & out) :
     out(out),
+    active_workers(0),
+    elapsed(0),
     checked_count(0),
     error_count(0),
     maxerrors(~size_t(0)),
@@ -16,24 +22,38 @@ Checker::Checker(color_ostream & out) :
     unnamed(false),
     failfast(false),
     noprogress(!out.is_console()),
-    maybepointer(false)
+    maybepointer(false),
+    perturb_byte(0),
+    threads(1),
+    budget(0)
 {
+    snapshot_mapped_ranges();
+}
+
+void Checker::snapshot_mapped_ranges()
+{
+    mapped.clear();
     Core::getInstance().p->getMemRanges(mapped);
+    std::sort(mapped.begin(), mapped.end(), [](const t_memrange & a, const t_memrange & b) -> bool
+    {
+        return uintptr_t(a.start) < uintptr_t(b.start);
+    });
 }
 
-color_ostream & Checker::fail(int line, const QueueItem & item, const CheckedStructure & cs)
+void Checker::fail(int line, const QueueItem & item, const CheckedStructure & cs, const std::string & message)
 {
+    std::lock_guard<std::recursive_mutex> lock(state_mutex);
     error_count++;
     out << COLOR_LIGHTRED << "sanity check failed (line " << line << "): ";
     out << COLOR_RESET << (cs.identity ? cs.identity->getFullName() : "?");
     out << " (accessed as " << item.path << "): ";
-    out << COLOR_YELLOW;
+    out << COLOR_YELLOW << message;
+    out << COLOR_RESET << std::endl;
     if (maxerrors && maxerrors != ~size_t(0))
         maxerrors--;
-    return out;
 }
 
-bool Checker::queue_item(const QueueItem & item, CheckedStructure cs)
+bool Checker::queue_item(const QueueItem & item, CheckedStructure cs, bool defer)
 {
     if (!cs.identity)
     {
@@ -60,6 +80,8 @@ bool Checker::queue_item(const QueueItem & item, CheckedStructure cs)
 
     auto ptr_end = PTR_ADD(item.ptr, cs.full_size());
 
+    std::lock_guard<std::recursive_mutex> lock(state_mutex);
+
     auto prev = data.lower_bound(item.ptr);
     if (prev != data.cbegin() && uintptr_t(prev->first) > uintptr_t(item.ptr))
     {
@@ -100,7 +122,11 @@ bool Checker::queue_item(const QueueItem & item, CheckedStructure cs)
     data.erase(overlap_start, overlap_end);
 
     data[item.ptr] = std::make_pair(item.path, cs);
-    queue.push_back(item);
+    if (defer)
+    {
+        queue.push_back(item);
+        queue_cond.notify_one();
+    }
     return true;
 }
 
@@ -139,6 +165,7 @@ void Checker::queue_globals()
 
 bool Checker::process_queue()
 {
+    std::unique_lock<std::recursive_mutex> lock(state_mutex);
     if (queue.empty())
     {
         return false;
@@ -147,18 +174,87 @@ bool Checker::process_queue()
     auto item = std::move(queue.front());
     queue.pop_front();
 
-    auto cs = data.find(item.ptr);
-    if (cs == data.end())
+    auto found = data.find(item.ptr);
+    if (found == data.end())
     {
         // happens if pointer is determined to be part of a larger structure
         return true;
     }
 
-    dispatch_item(item, cs->second.second);
+    // copied, since other workers may merge the entry into a larger structure
+    auto cs = found->second.second;
+    active_workers++;
+    lock.unlock();
+
+    dispatch_item(item, cs);
+
+    lock.lock();
+    active_workers--;
+    if (!active_workers || !queue.empty())
+        queue_cond.notify_all();
 
     return true;
 }
 
+bool Checker::process_queue_for(std::chrono::milliseconds budget)
+{
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    auto deadline = start + budget;
+
+    // the game may have run since the last slice
+    snapshot_mapped_ranges();
+
+    size_t workers = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    parallel_for(workers, [&](size_t worker)
+    {
+        while (budget.count() == 0 || clock::now() < deadline)
+        {
+            if (worker == 0)
+                report_progress(false);
+
+            if (process_queue())
+                continue;
+
+            // the items that other workers are dispatching may queue more
+            std::unique_lock<std::recursive_mutex> lock(state_mutex);
+            if (queue.empty() && !active_workers)
+                return;
+            queue_cond.wait(lock, [&] { return !queue.empty() || !active_workers; });
+        }
+    }, workers);
+
+    std::lock_guard<std::recursive_mutex> lock(state_mutex);
+    elapsed += clock::now() - start;
+    return !queue.empty();
+}
+
+void Checker::report_progress(bool final)
+{
+    using namespace std::chrono;
+
+    std::lock_guard<std::recursive_mutex> lock(state_mutex);
+    auto now = steady_clock::now();
+    if (!final && (noprogress || now - last_progress < milliseconds(250)))
+        return;
+    last_progress = now;
+
+    double seconds = duration<double>(elapsed).count();
+    size_t checked = checked_count;
+    out << "checked " << checked << " fields";
+    if (final)
+    {
+        out << " in " << fmt::format("{:.1f}", seconds) << "s";
+        if (seconds > 0)
+            out << " (" << size_t(checked / seconds) << " fields/s)";
+        out << ", " << error_count << " errors" << std::endl;
+    }
+    else
+    {
+        out << ", " << queue.size() << " queued\r" << std::flush;
+    }
+}
+
 
 void Checker::dispatch_item(const QueueItem & base, const CheckedStructure & cs)
 {
@@ -227,6 +323,7 @@ void Checker::dispatch_single_item(const QueueItem & item, const CheckedStructur
 
     if (!maxerrors)
     {
+        std::lock_guard<std::recursive_mutex> lock(state_mutex);
         if (!maxerrors_reported)
         {
             FAIL("error limit reached. bailing out with " << (queue.size() + 1) << " items remaining in the queue.");
@@ -348,11 +445,10 @@ void Checker::dispatch_pointer(const QueueItem & item, const CheckedStructure &
     if (cs.count || target->byte_size() <= 256)
     {
         // target is small, or we are inside an array of pointers; handle now
-        if (queue_item(target_item, target_cs))
+        // mark it as seen to make sure we're not stuck in a loop, but keep
+        // it out of the queue to prevent the queue growing too big
+        if (queue_item(target_item, target_cs, false))
         {
-            // we insert it into the queue to make sure we're not stuck in a loop
-            // get it back out of the queue to prevent the queue growing too big
-            queue.pop_back();
             dispatch_item(target_item, target_cs);
         }
     }
@@ -598,10 +694,13 @@ void Checker::dispatch_class(const QueueItem & item, const CheckedStructure & cs
         return;
     }
 
-    if (data.count(item.ptr) && data.at(item.ptr).first == item.path)
     {
-        // TODO: handle cases where this may overlap later data
-        data.at(item.ptr).second.identity = identity;
+        std::lock_guard<std::recursive_mutex> lock(state_mutex);
+        if (data.count(item.ptr) && data.at(item.ptr).first == item.path)
+        {
+            // TODO: handle cases where this may overlap later data
+            data.at(item.ptr).second.identity = identity;
+        }
     }
 
     dispatch_struct(QueueItem(item.path + "<" + identity->getFullName() + ">", item.ptr), CheckedStructure(identity));
@@ -798,9 +897,8 @@ void Checker::check_unknown_pointer(const QueueItem & item)
         if (allocated_size == sizeof(void *) || (allocated_size > sizeof(void *) && is_valid_dereference(ptr_item, 1, true)))
         {
             CheckedStructure ptr_cs(df::identity_traits<void *>::get());
-            if (queue_item(ptr_item, ptr_cs))
+            if (queue_item(ptr_item, ptr_cs, false))
             {
-                queue.pop_back();
                 dispatch_pointer(ptr_item, ptr_cs);
             }
         }
@@ -1036,7 +1134,10 @@ void Checker::check_stl_unordered_map(const QueueItem & item, const container_id
         return;
     }
 
-    out << umap->rehash_policy.max_load_factor << std::endl;
+    {
+        std::lock_guard<std::recursive_mutex> lock(state_mutex);
+        out << umap->rehash_policy.max_load_factor << std::endl;
+    }
 
     #define check_ptr_field(field, expect_null) \
         do { \
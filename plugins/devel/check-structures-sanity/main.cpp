@@ -3,10 +3,20 @@
 #include "LuaTools.h"
 #include "LuaWrapper.h"
 
+#include "modules/World.h"
+
+#include "df/world.h"
+
 DFHACK_PLUGIN("check-structures-sanity");
 
 static command_result command(color_ostream &, std::vector<std::string> &);
 
+// a check started with -budget, which advances a slice per paused frame
+static std::unique_ptr<Checker> running;
+// the game frame the budgeted check started on. queued pointers are only
+// valid as long as the game hasn't advanced.
+static int32_t running_frame;
+
 DFhackCExport command_result plugin_init(color_ostream &, std::vector<PluginCommand> & commands)
 {
     commands.push_back(PluginCommand(
@@ -14,7 +24,8 @@ DFhackCExport command_result plugin_init(color_ostream &, std::vector<PluginComm
         "performs a sanity check on df-structures",
         command,
         false,
-        "check-structures-sanity [-enums] [-sizes] [-lowmem] [-maxerrors n] [-failfast] [starting_point]\n"
+        "check-structures-sanity [-enums] [-sizes] [-lowmem] [-maxerrors n] [-failfast] [-threads n] [-budget ms] [starting_point]\n"
+        "check-structures-sanity -cancel\n"
         "\n"
         "-enums: report unexpected or unnamed enum or bitfield values.\n"
         "-sizes: report struct and class sizes that don't match structures. (requires sizecheck)\n"
@@ -22,6 +33,11 @@ DFhackCExport command_result plugin_init(color_ostream &, std::vector<PluginComm
         "-maxerrors n: set the maximum number of errors before bailing out.\n"
         "-failfast: crash if any error is encountered. useful only for debugging.\n"
         "-maybepointer: report integers that might actually be pointers.\n"
+        "-threads n: check with n worker threads, or one per core if n is 0. (defaults to 1)\n"
+        "-budget ms: check for at most ms milliseconds per frame while the game is paused,\n"
+        "    printing the results to the console when done. the check is cancelled if the\n"
+        "    game is unpaused before it finishes.\n"
+        "-cancel: stop a check started with -budget.\n"
         "starting_point: a lua expression or a word like 'screen', 'item', or 'building'. (defaults to df.global)\n"
         "\n"
         "by default, check-structures-sanity reports invalid pointers, vectors, strings, and vtables."
@@ -33,6 +49,44 @@ DFhackCExport command_result plugin_init(color_ostream &, std::vector<PluginComm
     return CR_OK;
 }
 
+DFhackCExport command_result plugin_shutdown(color_ostream &)
+{
+    running.reset();
+    return CR_OK;
+}
+
+DFhackCExport command_result plugin_onstatechange(color_ostream & out, state_change_event event)
+{
+    if (event == SC_WORLD_UNLOADED && running)
+    {
+        out.print("check-structures-sanity: world unloaded, check cancelled\n");
+        running.reset();
+    }
+    return CR_OK;
+}
+
+DFhackCExport command_result plugin_onupdate(color_ostream &)
+{
+    // the structures are only stable while the game is paused
+    if (!running || !World::ReadPauseState())
+        return CR_OK;
+
+    if (df::global::world->frame_counter != running_frame)
+    {
+        running->report_progress(true);
+        running.reset();
+        Core::getInstance().getConsole().printerr("check-structures-sanity: the game was unpaused, check cancelled\n");
+        return CR_OK;
+    }
+
+    if (running->process_queue_for())
+        return CR_OK;
+
+    running->report_progress(true);
+    running.reset();
+    return CR_OK;
+}
+
 // returns 0 if MALLOC_PERTURB_ is unset, or if set to 0, because 0 is not useful
 uint8_t check_malloc_perturb()
 {
@@ -52,11 +106,34 @@ uint8_t check_malloc_perturb()
 
 static command_result command(color_ostream & out, std::vector<std::string> & parameters)
 {
+    auto cancel_idx = std::find(parameters.begin(), parameters.end(), "-cancel");
+    if (cancel_idx != parameters.end())
+    {
+        if (parameters.size() > 1)
+            return CR_WRONG_USAGE;
+        if (running)
+        {
+            running->report_progress(true);
+            running.reset();
+            out.print("check-structures-sanity: check cancelled\n");
+        }
+        return CR_OK;
+    }
+
+    if (running)
+    {
+        out.printerr("check-structures-sanity: a check is already running. Use -cancel to stop it.\n");
+        return CR_FAILURE;
+    }
+
     uint8_t perturb_byte = check_malloc_perturb();
     if (!perturb_byte)
         out.printerr("check-structures-sanity: MALLOC_PERTURB_ not set. Some checks may be bypassed or fail.\n");
 
-    Checker checker(out);
+    // a budgeted check outlives this command, so it reports to the console
+    bool budgeted = std::find(parameters.begin(), parameters.end(), "-budget") != parameters.end();
+    auto checker_ptr = std::make_unique<Checker>(budgeted ? Core::getInstance().getConsole() : out);
+    auto & checker = *checker_ptr;
     checker.perturb_byte = perturb_byte;
 
     // check parameters with values first
@@ -82,6 +159,8 @@ static command_result command(color_ostream & out, std::vector<std::string> & pa
         } \
     }
     VAL_PARAM(maxerrors, std::stoul(value));
+    VAL_PARAM(threads, std::stoul(value));
+    VAL_PARAM(budget, std::chrono::milliseconds(std::stoul(value)));
 #undef VAL_PARAM
 
 #define BOOL_PARAM(name) \
@@ -140,15 +219,21 @@ static command_result command(color_ostream & out, std::vector<std::string> & pa
         checker.queue_item(item, CheckedStructure(identity));
     }
 
-    while (checker.process_queue())
+    if (checker.budget.count())
     {
-        if (!checker.noprogress)
+        if (!World::ReadPauseState())
         {
-            out << "checked " << checker.checked_count << " fields\r" << std::flush;
+            out.printerr("check-structures-sanity: pause the game before starting a check with -budget\n");
+            return CR_FAILURE;
         }
+        running_frame = df::global::world->frame_counter;
+        out.print("check-structures-sanity: checking in the background while the game is paused\n");
+        running = std::move(checker_ptr);
+        return CR_OK;
     }
 
-    out << "checked " << checker.checked_count << " fields" << std::endl;
+    checker.process_queue_for();
+    checker.report_progress(true);
 
     return checker.error_count ? CR_FAILURE : CR_OK;
 }
@@ -157,6 +157,8 @@ bool CheckedStructure::has_type_at_offset(const CheckedStructure & type, size_t
 const type_identity *Checker::wrap_in_stl_ptr_vector(const type_identity *base)
 {
     static std::map<const type_identity *, std::unique_ptr<const df::stl_ptr_vector_identity>> wrappers;
+    static std::mutex wrappers_mutex;
+    std::lock_guard<std::mutex> lock(wrappers_mutex);
     auto it = wrappers.find(base);
     if (it != wrappers.end())
     {
@@ -168,6 +170,8 @@ const type_identity *Checker::wrap_in_stl_ptr_vector(const type_identity *base)
 const type_identity *Checker::wrap_in_pointer(const type_identity *base)
 {
     static std::map<const type_identity *, std::unique_ptr<const df::pointer_identity>> wrappers;
+    static std::mutex wrappers_mutex;
+    std::lock_guard<std::mutex> lock(wrappers_mutex);
     auto it = wrappers.find(base);
     if (it != wrappers.end())
     {
@@ -1,5 +1,7 @@
 #include "check-structures-sanity.h"
 
+#include <algorithm>
+
 #ifdef WIN32
 #define WIN32_LEAN_AND_MEAN
 #define _WIN32_WINNT 0x0501
@@ -23,6 +25,24 @@ bool Checker::is_in_global(const QueueItem & item)
 
     return false;
 }
+const t_memrange *Checker::find_mapped_range(const void *ptr) const
+{
+    // the first range starting after ptr is just past the only one that can contain it
+    auto it = std::upper_bound(mapped.begin(), mapped.end(), uintptr_t(ptr), [](uintptr_t addr, const t_memrange & range) -> bool
+    {
+        return addr < uintptr_t(range.start);
+    });
+    if (it == mapped.begin())
+    {
+        return nullptr;
+    }
+    --it;
+    if (uintptr_t(ptr) >= uintptr_t(it->end))
+    {
+        return nullptr;
+    }
+    return &*it;
+}
 bool Checker::is_valid_dereference(const QueueItem & item, const CheckedStructure & cs, size_t size, bool quiet)
 {
     auto base = const_cast<void *>(item.ptr);
@@ -49,42 +69,29 @@ bool Checker::is_valid_dereference(const QueueItem & item, const CheckedStructur
         return false;
     }
 
-    bool found = true;
     auto expected_start = base;
     size_t remaining_size = size;
-    while (found)
+    while (auto range = find_mapped_range(expected_start))
     {
-        found = false;
-
-        for (auto & range : mapped)
+        if (!range->valid || !range->read)
         {
-            if (!range.isInRange(expected_start))
-            {
-                continue;
-            }
-
-            found = true;
-
-            if (!range.valid || !range.read)
-            {
-                if (!quiet)
-                {
-                    FAIL_PTR("pointer to invalid memory range");
-                }
-                return false;
-            }
-
-            auto expected_end = const_cast<void *>(PTR_ADD(expected_start, remaining_size - 1));
-            if (size && !range.isInRange(expected_end))
+            if (!quiet)
             {
-                auto next_start = PTR_ADD(range.end, 1);
-                remaining_size -= ptrdiff_t(next_start) - ptrdiff_t(expected_start);
-                expected_start = const_cast<void *>(next_start);
-                break;
+                FAIL_PTR("pointer to invalid memory range");
             }
+            return false;
+        }
 
-            return true;
+        auto expected_end = PTR_ADD(expected_start, remaining_size - 1);
+        if (size && uintptr_t(expected_end) >= uintptr_t(range->end))
+        {
+            auto next_start = PTR_ADD(range->end, 1);
+            remaining_size -= ptrdiff_t(next_start) - ptrdiff_t(expected_start);
+            expected_start = const_cast<void *>(next_start);
+            continue;
         }
+
+        return true;
     }
 
     if (quiet)
@@ -171,43 +178,36 @@ const char *Checker::get_vtable_name(const QueueItem & item, const CheckedStruct
     auto name = validate_and_dereference<const char *>(QueueItem(item, "?vtable?.info.name", info + 1), quiet);
 #endif
 
-    for (auto & range : mapped)
+    auto range = find_mapped_range(name);
+    if (!range)
+    {
+        return nullptr;
+    }
+
+    if (!range->valid || !range->read)
     {
-        if (!range.isInRange(const_cast<char *>(name)))
+        if (!quiet)
         {
-            continue;
+            FAIL("pointer to invalid memory range");
         }
+        return nullptr;
+    }
 
-        if (!range.valid || !range.read)
+    const char *first_letter = nullptr;
+    bool letter = false;
+    for (const char *p = name; uintptr_t(p) < uintptr_t(range->end); p++)
+    {
+        if ((*p >= 'a' && *p <= 'z') || *p == '_')
         {
-            if (!quiet)
+            if (!letter)
             {
-                FAIL("pointer to invalid memory range");
+                first_letter = p;
             }
-            return nullptr;
+            letter = true;
         }
-
-        const char *first_letter = nullptr;
-        bool letter = false;
-        for (const char *p = name; ; p++)
+        else if (!*p)
         {
-            if (!range.isInRange(const_cast<char *>(p)))
-            {
-                return nullptr;
-            }
-
-            if ((*p >= 'a' && *p <= 'z') || *p == '_')
-            {
-                if (!letter)
-                {
-                    first_letter = p;
-                }
-                letter = true;
-            }
-            else if (!*p)
-            {
-                return first_letter;
-            }
+            return first_letter;
         }
     }
 
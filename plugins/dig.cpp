@@ -18,6 +18,7 @@
 #include "df/map_block.h"
 #include "df/world.h"
 
+#include <bitset>
 #include <vector>
 #include <cstdio>
 #include <cstdlib>
@@ -61,6 +62,7 @@ static void unhide_surrounding_tagged_tiles(color_ostream& out, void* ptr);
 
 static const int32_t CYCLE_TICKS = 1223; // a prime number that's about a day
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 5);
 
 static vector<TexposHandle> textures;
 
@@ -139,14 +141,11 @@ DFhackCExport command_result plugin_load_site_data(color_ostream &out) {
         damp_config = World::AddPersistentSiteData(DAMP_CONFIG_KEY);
     }
 
-    for (auto & block : world->map.map_blocks) {
-        auto warm_mask = World::getPersistentTilemask(warm_config, block);
-        auto damp_mask = World::getPersistentTilemask(damp_config, block);
-        if (warm_mask || damp_mask) {
-            do_enable(true);
-            break;
-        }
-    }
+    vector<df::map_block *> warm_blocks, damp_blocks;
+    World::getPersistentTilemaskBlocks(warm_config, &warm_blocks);
+    World::getPersistentTilemaskBlocks(damp_config, &damp_blocks);
+    if (!warm_blocks.empty() || !damp_blocks.empty())
+        do_enable(true);
 
     return CR_OK;
 }
@@ -178,9 +177,17 @@ static void do_cycle(color_ostream &out) {
     std::unordered_map<df::coord, df::job *> dig_jobs;
     fill_dig_jobs(dig_jobs);
 
+    // only visit the blocks that have tagged tiles
+    vector<df::map_block *> blocks, damp_blocks;
+    World::getPersistentTilemaskBlocks(warm_config, &blocks);
+    World::getPersistentTilemaskBlocks(damp_config, &damp_blocks);
+    for (auto block : damp_blocks)
+        if (!World::getPersistentTilemask(warm_config, block))
+            blocks.push_back(block);
+
     bool has_assignment = false;
     uint32_t scrubbed = 0;
-    for (auto & block : world->map.map_blocks) {
+    for (auto & block : blocks) {
         auto warm_mask = World::getPersistentTilemask(warm_config, block);
         auto damp_mask = World::getPersistentTilemask(damp_config, block);
         if (!warm_mask && !damp_mask)
@@ -1185,56 +1192,110 @@ enum explo_what
     EXPLO_DESIGNATED,
 };
 
+// One bit per tile of a map block, in the same order as the block's tile
+// arrays (x * 16 + y). Patterns, filters, and bounds are combined as whole
+// masks and then applied to the block in a single pass.
+typedef std::bitset<256> tilemask;
+
+static inline size_t tile_index(int x, int y)
+{
+    return x * 16 + y;
+}
+
+// digmask tables are written row by row, i.e. indexed as [y][x]
+static tilemask to_tilemask(const digmask & dm)
+{
+    tilemask mask;
+    for(int x = 0; x < 16; x++)
+        for(int y = 0; y < 16; y++)
+            if(dm[y][x])
+                mask.set(tile_index(x, y));
+    return mask;
+}
+
+// all tiles of the block except the ones on the edge of the map
+static tilemask interior_mask(uint32_t bx, uint32_t by, int x_max, int y_max)
+{
+    tilemask mask;
+    mask.set();
+    for(int i = 0; i < 16; i++)
+    {
+        if(bx == 0)
+            mask.reset(tile_index(0, i));
+        if(int(bx) == x_max - 1)
+            mask.reset(tile_index(15, i));
+        if(by == 0)
+            mask.reset(tile_index(i, 0));
+        if(int(by) == y_max - 1)
+            mask.reset(tile_index(i, 15));
+    }
+    return mask;
+}
+
+template<typename Pred>
+static tilemask block_mask(df::map_block * bl, Pred pred)
+{
+    const df::tiletype * tt = &bl->tiletype[0][0];
+    const df::tile_designation * des = &bl->designation[0][0];
+    tilemask mask;
+    for(size_t i = 0; i < 256; i++)
+        if(pred(tt[i], des[i]))
+            mask.set(i);
+    return mask;
+}
+
+// tiles that exploratory mining may designate: anything hidden, and visible
+// natural walls
+static tilemask explorable_mask(df::map_block * bl)
+{
+    return block_mask(bl, [](df::tiletype tt, df::tile_designation des) {
+        return des.bits.hidden
+            || (isWallTerrain(tt) && tileMaterial(tt) != tiletype_material::CONSTRUCTION);
+    });
+}
+
+static bool set_dig(df::map_block * bl, const tilemask & mask, df::tile_dig_designation dig)
+{
+    if(mask.none())
+        return false;
+    df::tile_designation * des = &bl->designation[0][0];
+    for(size_t i = 0; i < 256; i++)
+        if(mask.test(i))
+            des[i].bits.dig = dig;
+    return true;
+}
+
 bool stamp_pattern (uint32_t bx, uint32_t by, int z_level,
-    digmask & dm, explo_how how, explo_what what,
+    const tilemask & pattern, explo_how how, explo_what what,
     int x_max, int y_max
     )
 {
     df::map_block * bl = Maps::getBlock(bx,by,z_level);
     if(!bl)
         return false;
-    int x = 0,mx = 16;
-    if(bx == 0)
-        x = 1;
-    if(int(bx) == x_max - 1)
-        mx = 15;
-    for(; x < mx; x++)
+    tilemask explorable = interior_mask(bx, by, x_max, y_max) & explorable_mask(bl);
+    bool changed = false;
+    if(how == EXPLO_CLEAR)
     {
-        int y = 0,my = 16;
-        if(by == 0)
-            y = 1;
-        if(int(by) == y_max - 1)
-            my = 15;
-        for(; y < my; y++)
-        {
-            df::tile_designation & des = bl->designation[x][y];
-            df::tiletype tt = bl->tiletype[x][y];
-            // could be potentially used to locate hidden constructions?
-            if(tileMaterial(tt) == tiletype_material::CONSTRUCTION && !des.bits.hidden)
-                continue;
-            if(!isWallTerrain(tt) && !des.bits.hidden)
-                continue;
-            if(how == EXPLO_CLEAR)
-            {
-                des.bits.dig = tile_dig_designation::No;
-                continue;
-            }
-            if(dm[y][x])
-            {
-                if(what == EXPLO_ALL
-                    || (des.bits.dig == tile_dig_designation::Default && what == EXPLO_DESIGNATED)
-                    || (des.bits.hidden && what == EXPLO_HIDDEN))
-                {
-                    des.bits.dig = tile_dig_designation::Default;
-                }
-            }
-            else if(what == EXPLO_DESIGNATED)
-            {
-                des.bits.dig = tile_dig_designation::No;
-            }
-        }
+        changed = set_dig(bl, explorable, tile_dig_designation::No);
+    }
+    else if(what == EXPLO_DESIGNATED)
+    {
+        // keep the existing designations that fall on the pattern
+        changed = set_dig(bl, explorable & ~pattern, tile_dig_designation::No);
+    }
+    else
+    {
+        tilemask target = explorable & pattern;
+        if(what == EXPLO_HIDDEN)
+            target &= block_mask(bl, [](df::tiletype, df::tile_designation des) {
+                return des.bits.hidden;
+            });
+        changed = set_dig(bl, target, tile_dig_designation::Default);
     }
     bl->flags.bits.designated = true;
+    if(changed)
+        Maps::markBlockChanged(bl);
     return true;
 };
 
@@ -1328,52 +1389,64 @@ command_result digexp (color_ostream &out, vector <string> & parameters)
     }
     if(how == EXPLO_DIAG5)
     {
+        tilemask masks[5];
+        for(int i = 0; i < 5; i++)
+            masks[i] = to_tilemask(diag5[i]);
         int which;
         for(uint32_t x = 0; x < x_max; x++)
         {
             for(uint32_t y = 0 ; y < y_max; y++)
             {
                 which = (4*x + y) % 5;
-                stamp_pattern(x,y_max - 1 - y, z_level, diag5[which],
+                stamp_pattern(x,y_max - 1 - y, z_level, masks[which],
                     how, what, x_max, y_max);
             }
         }
     }
     else if(how == EXPLO_DIAG5R)
     {
+        tilemask masks[5];
+        for(int i = 0; i < 5; i++)
+            masks[i] = to_tilemask(diag5r[i]);
         int which;
         for(uint32_t x = 0; x < x_max; x++)
         {
             for(uint32_t y = 0 ; y < y_max; y++)
             {
                 which = (4*x + 1000-y) % 5;
-                stamp_pattern(x,y_max - 1 - y, z_level, diag5r[which],
+                stamp_pattern(x,y_max - 1 - y, z_level, masks[which],
                     how, what, x_max, y_max);
             }
         }
     }
     else if(how == EXPLO_LADDER)
     {
+        tilemask masks[3];
+        for(int i = 0; i < 3; i++)
+            masks[i] = to_tilemask(ladder[i]);
         int which;
         for(uint32_t x = 0; x < x_max; x++)
         {
             which = x % 3;
             for(uint32_t y = 0 ; y < y_max; y++)
             {
-                stamp_pattern(x, y, z_level, ladder[which],
+                stamp_pattern(x, y, z_level, masks[which],
                     how, what, x_max, y_max);
             }
         }
     }
     else if(how == EXPLO_LADDERR)
     {
+        tilemask masks[3];
+        for(int i = 0; i < 3; i++)
+            masks[i] = to_tilemask(ladderr[i]);
         int which;
         for(uint32_t y = 0 ; y < y_max; y++)
         {
             which = y % 3;
             for(uint32_t x = 0; x < x_max; x++)
             {
-                stamp_pattern(x, y, z_level, ladderr[which],
+                stamp_pattern(x, y, z_level, masks[which],
                     how, what, x_max, y_max);
             }
         }
@@ -1404,13 +1477,13 @@ command_result digexp (color_ostream &out, vector <string> & parameters)
             }
         mx.WriteAll();
     }
-    else for(uint32_t x = 0; x < x_max; x++)
+    else
     {
-        for(uint32_t y = 0 ; y < y_max; y++)
-        {
-            stamp_pattern(x, y, z_level, all_tiles,
-                how, what, x_max, y_max);
-        }
+        tilemask mask = to_tilemask(all_tiles);
+        for(uint32_t x = 0; x < x_max; x++)
+            for(uint32_t y = 0 ; y < y_max; y++)
+                stamp_pattern(x, y, z_level, mask,
+                    how, what, x_max, y_max);
     }
     return CR_OK;
 }
@@ -1847,8 +1920,6 @@ command_result digtype (color_ostream &out, vector <string> & parameters)
     }
 
     int32_t cx, cy, cz;
-    uint32_t tileXMax = xMax * 16;
-    uint32_t tileYMax = yMax * 16;
     Gui::getCursorCoords(cx,cy,cz);
     if (cx == -30000)
     {
@@ -1893,36 +1964,51 @@ command_result digtype (color_ostream &out, vector <string> & parameters)
 
     for( uint32_t z = zMin; z < zMax; z++ )
     {
-        for( uint32_t x = 1; x < tileXMax-1; x++ )
+        for( uint32_t bx = 0; bx < xMax; bx++ )
         {
-            for( uint32_t y = 1; y < tileYMax-1; y++ )
+            for( uint32_t by = 0; by < yMax; by++ )
             {
-                DFHack::DFCoord current(x,y,z);
-                int16_t vmat2 = mCache->veinMaterialAt(current);
-                if ( vmat2 != veinmat )
-                    continue;
-                tt = mCache->tiletypeAt(current);
-                if (!DFHack::isWallTerrain(tt))
+                df::map_block * bl = Maps::getBlock(bx, by, z);
+                if (!bl)
                     continue;
-                if (tileMaterial(tt) != df::enums::tiletype_material::MINERAL)
+
+                // screen with the raw block first so that blocks without
+                // vein walls never need their materials decoded
+                tilemask target = interior_mask(bx, by, xMax, yMax)
+                    & block_mask(bl, [&](df::tiletype tt, df::tile_designation des) {
+                        return isWallTerrain(tt)
+                            && tileMaterial(tt) == df::enums::tiletype_material::MINERAL
+                            && (hidden || !des.bits.hidden);
+                    });
+                if (target.none())
                     continue;
 
-                //designate it for digging
-                if ( !mCache->testCoord(current) )
+                MapExtras::Block * b = mCache->BlockAt(df::coord(bx, by, z));
+                if (!b || !b->is_valid())
                 {
-                    out.printerr("testCoord failed at ({},{},{})\n", x, y, z);
+                    out.printerr("invalid map block at ({},{},{})\n", bx, by, z);
                     return CR_FAILURE;
                 }
 
-                df::tile_designation designation = mCache->designationAt(current);
-
-                if (designation.bits.hidden && !hidden) continue;
-
-                df::tile_occupancy occupancy = mCache->occupancyAt(current);
-                designation.bits.dig = baseDes.bits.dig;
-                occupancy.bits.dig_auto = baseOcc.bits.dig_auto;
-                mCache->setDesignationAt(current, designation, priority);
-                mCache->setOccupancyAt(current, occupancy);
+                for (int x = 0; x < 16; x++)
+                {
+                    for (int y = 0; y < 16; y++)
+                    {
+                        if (!target.test(tile_index(x, y)))
+                            continue;
+                        df::coord2d pos(x, y);
+                        if (b->veinMaterialAt(pos) != veinmat)
+                            continue;
+
+                        //designate it for digging
+                        df::tile_designation designation = b->DesignationAt(pos);
+                        df::tile_occupancy occupancy = b->OccupancyAt(pos);
+                        designation.bits.dig = baseDes.bits.dig;
+                        occupancy.bits.dig_auto = baseOcc.bits.dig_auto;
+                        b->setDesignationAt(pos, designation, priority);
+                        b->setOccupancyAt(pos, occupancy);
+                    }
+                }
             }
         }
     }
@@ -55,6 +55,7 @@ enum ConfigValues {
 
 static const int32_t CYCLE_TICKS = 2459; // a prime number that's around 2 days
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 5);
 
 static command_result do_command(color_ostream &out, vector<string> &parameters);
 static void dwarfvet_cycle(color_ostream &out);
@@ -74,9 +74,12 @@ static void remove_elem_config(color_ostream &out, int id) {
 // numbers: https://www-users.york.ac.uk/~ss44/cyc/p/prime100.htm
 // Do a search in the codebase for CYCLE_TICKS and try to choose a number that
 // isn't there yet. This will help prevent too many tools from running on the
-// same tick and causing noticeable FPS stuttering.
+// same tick and causing noticeable FPS stuttering. Declaring the cadence lets
+// the core skip calling plugin_onupdate until the next cycle is due; the last
+// argument is the time budget in ms that a cycle is expected to stay under.
 static const int32_t CYCLE_TICKS = 1217; // about one day
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 5);
 
 static command_result do_command(color_ostream &out, vector<string> &parameters);
 static void do_cycle(color_ostream &out);
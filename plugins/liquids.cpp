@@ -453,176 +453,161 @@ command_result df_liquids_execute(color_ostream &out, OperationMode &cur_mode, d
     switch (cur_mode.paint)
     {
     case P_OBSIDIAN:
+        forEachBrushBlock(mcache, all_tiles, [&](Block *block, const std::vector<df::coord2d> &offsets)
         {
-            coord_vec::iterator iter = all_tiles.begin();
-            while (iter != all_tiles.end())
+            for (auto &p : offsets)
             {
-                mcache.setTiletypeAt(*iter, tiletype::LavaWall);
-                mcache.setTemp1At(*iter,10015);
-                mcache.setTemp2At(*iter,10015);
-                df::tile_designation des = mcache.designationAt(*iter);
+                block->setTiletypeAt(p, tiletype::LavaWall);
+                block->setTemp1At(p,10015);
+                block->setTemp2At(p,10015);
+                df::tile_designation des = block->DesignationAt(p);
                 des.bits.flow_size = 0;
                 des.bits.flow_forbid = false;
-                mcache.setDesignationAt(*iter, des);
-                iter ++;
+                block->setDesignationAt(p, des);
             }
-            break;
-        }
+        });
+        break;
     case P_OBSIDIAN_FLOOR:
+        forEachBrushBlock(mcache, all_tiles, [&](Block *block, const std::vector<df::coord2d> &offsets)
         {
-            coord_vec::iterator iter = all_tiles.begin();
-            while (iter != all_tiles.end())
-            {
-                mcache.setTiletypeAt(*iter, findRandomVariant(tiletype::LavaFloor1));
-                iter ++;
-            }
-            break;
-        }
+            for (auto &p : offsets)
+                block->setTiletypeAt(p, findRandomVariant(tiletype::LavaFloor1));
+        });
+        break;
     case P_RIVER_SOURCE:
+        forEachBrushBlock(mcache, all_tiles, [&](Block *block, const std::vector<df::coord2d> &offsets)
         {
-            coord_vec::iterator iter = all_tiles.begin();
-            while (iter != all_tiles.end())
+            for (auto &p : offsets)
             {
-                mcache.setTiletypeAt(*iter, tiletype::RiverSource);
+                block->setTiletypeAt(p, tiletype::RiverSource);
 
-                df::tile_designation a = mcache.designationAt(*iter);
+                df::tile_designation a = block->DesignationAt(p);
                 a.bits.liquid_type = tile_liquid::Water;
                 a.bits.liquid_static = false;
                 a.bits.flow_size = 7;
-                mcache.setTemp1At(*iter,10015);
-                mcache.setTemp2At(*iter,10015);
-                mcache.setDesignationAt(*iter,a);
-
-                Block * b = mcache.BlockAt((*iter)/16);
-                b->enableBlockUpdates(true);
-
-                iter++;
+                block->setTemp1At(p,10015);
+                block->setTemp2At(p,10015);
+                block->setDesignationAt(p,a);
             }
-            break;
-        }
+            block->enableBlockUpdates(true);
+        });
+        break;
     case P_WCLEAN:
+        forEachBrushBlock(mcache, all_tiles, [&](Block *block, const std::vector<df::coord2d> &offsets)
         {
-            coord_vec::iterator iter = all_tiles.begin();
-            while (iter != all_tiles.end())
+            for (auto &p : offsets)
             {
-                DFHack::DFCoord current = *iter;
-                df::tile_designation des = mcache.designationAt(current);
+                df::tile_designation des = block->DesignationAt(p);
                 des.bits.water_salt = false;
                 des.bits.water_stagnant = false;
-                mcache.setDesignationAt(current,des);
-                iter++;
+                block->setDesignationAt(p,des);
             }
-            break;
-        }
+        });
+        break;
     case P_MAGMA:
     case P_WATER:
     case P_FLOW_BITS:
         {
-            set <Block *> seen_blocks;
-            coord_vec::iterator iter = all_tiles.begin();
-            while (iter != all_tiles.end())
+            vector <Block *> seen_blocks;
+            forEachBrushBlock(mcache, all_tiles, [&](Block *block, const std::vector<df::coord2d> &offsets)
             {
-                DFHack::DFCoord current = *iter; // current tile coord
-                DFHack::DFCoord curblock = current /16; // current block coord
-                // check if the block is actually there
-                auto block = mcache.BlockAt(curblock);
-                if(!block)
-                {
-                    iter ++;
-                    continue;
-                }
                 auto raw_block = block->getRaw();
-                df::tile_designation des = mcache.designationAt(current);
-                df::tiletype tt = mcache.tiletypeAt(current);
-                // don't put liquids into places where they don't belong...
-                if(!DFHack::FlowPassable(tt))
-                {
-                    iter++;
-                    continue;
-                }
-                if(cur_mode.paint != P_FLOW_BITS)
+                bool seen = false;
+                bool amount_changed = false;
+                bool liquid_changed = false;
+                for (auto &p : offsets)
                 {
-                    unsigned old_amount = des.bits.flow_size;
-                    unsigned new_amount = old_amount;
-                    df::tile_liquid old_liquid = des.bits.liquid_type;
-                    df::tile_liquid new_liquid = old_liquid;
-                    // Compute new liquid type and amount
-                    switch (cur_mode.setmode)
-                    {
-                    case M_KEEP:
-                        new_amount = cur_mode.amount;
-                        break;
-                    case M_INC:
-                        if(old_amount < cur_mode.amount)
-                            new_amount = cur_mode.amount;
-                        break;
-                    case M_DEC:
-                        if (old_amount > cur_mode.amount)
-                            new_amount = cur_mode.amount;
-                    }
-                    if (cur_mode.paint == P_MAGMA)
-                        new_liquid = tile_liquid::Magma;
-                    else if (cur_mode.paint == P_WATER)
-                        new_liquid = tile_liquid::Water;
-                    // Store new amount and type
-                    des.bits.flow_size = new_amount;
-                    des.bits.liquid_type = new_liquid;
-                    // Compute temperature
-                    if (!old_amount)
-                        old_liquid = tile_liquid::Water;
-                    if (!new_amount)
-                        new_liquid = tile_liquid::Water;
-                    if (old_liquid != new_liquid)
+                    df::tile_designation des = block->DesignationAt(p);
+                    df::tiletype tt = block->tiletypeAt(p);
+                    // don't put liquids into places where they don't belong...
+                    if(!DFHack::FlowPassable(tt))
+                        continue;
+                    if(cur_mode.paint != P_FLOW_BITS)
                     {
-                        if (new_liquid == tile_liquid::Water)
+                        unsigned old_amount = des.bits.flow_size;
+                        unsigned new_amount = old_amount;
+                        df::tile_liquid old_liquid = des.bits.liquid_type;
+                        df::tile_liquid new_liquid = old_liquid;
+                        // Compute new liquid type and amount
+                        switch (cur_mode.setmode)
                         {
-                            mcache.setTemp1At(current,10015);
-                            mcache.setTemp2At(current,10015);
+                        case M_KEEP:
+                            new_amount = cur_mode.amount;
+                            break;
+                        case M_INC:
+                            if(old_amount < cur_mode.amount)
+                                new_amount = cur_mode.amount;
+                            break;
+                        case M_DEC:
+                            if (old_amount > cur_mode.amount)
+                                new_amount = cur_mode.amount;
                         }
-                        else
+                        if (cur_mode.paint == P_MAGMA)
+                            new_liquid = tile_liquid::Magma;
+                        else if (cur_mode.paint == P_WATER)
+                            new_liquid = tile_liquid::Water;
+                        // Store new amount and type
+                        des.bits.flow_size = new_amount;
+                        des.bits.liquid_type = new_liquid;
+                        // Compute temperature
+                        if (!old_amount)
+                            old_liquid = tile_liquid::Water;
+                        if (!new_amount)
+                            new_liquid = tile_liquid::Water;
+                        if (old_liquid != new_liquid)
                         {
-                            mcache.setTemp1At(current,12000);
-                            mcache.setTemp2At(current,12000);
+                            if (new_liquid == tile_liquid::Water)
+                            {
+                                block->setTemp1At(p,10015);
+                                block->setTemp2At(p,10015);
+                            }
+                            else
+                            {
+                                block->setTemp1At(p,12000);
+                                block->setTemp2At(p,12000);
+                            }
                         }
+                        // mark the tile passable or impassable like the game does
+                        des.bits.flow_forbid = (new_liquid == tile_liquid::Magma || new_amount > 3);
+                        block->setDesignationAt(p,des);
+                        amount_changed |= new_amount != old_amount;
+                        liquid_changed |= new_liquid != old_liquid;
                     }
-                    // mark the tile passable or impassable like the game does
-                    des.bits.flow_forbid = (new_liquid == tile_liquid::Magma || new_amount > 3);
-                    mcache.setDesignationAt(current,des);
-                    // request flow engine updates
-                    block->enableBlockUpdates(new_amount != old_amount, new_liquid != old_liquid);
-                }
-                if (cur_mode.permaflow != PF_KEEP && raw_block)
-                {
-                    auto &flow = raw_block->liquid_flow[current.x&15][current.y&15];
-                    flow.bits.perm_flow_dir = permaflow_id[cur_mode.permaflow];
-                    flow.bits.temp_flow_timer = 0;
+                    if (cur_mode.permaflow != PF_KEEP && raw_block)
+                    {
+                        auto &flow = raw_block->liquid_flow[p.x][p.y];
+                        flow.bits.perm_flow_dir = permaflow_id[cur_mode.permaflow];
+                        flow.bits.temp_flow_timer = 0;
+                    }
+                    seen = true;
                 }
-                seen_blocks.insert(block);
-                iter++;
-            }
-            set <Block *>::iterator biter = seen_blocks.begin();
-            while (biter != seen_blocks.end())
+                // request flow engine updates
+                if (amount_changed || liquid_changed)
+                    block->enableBlockUpdates(amount_changed, liquid_changed);
+                if (seen)
+                    seen_blocks.push_back(block);
+            });
+            for (auto block : seen_blocks)
             {
                 switch (cur_mode.flowmode)
                 {
                 case M_INC:
-                    (*biter)->enableBlockUpdates(true);
+                    block->enableBlockUpdates(true);
                     break;
                 case M_DEC:
-                    if (auto block = (*biter)->getRaw())
+                    if (auto raw = block->getRaw())
                     {
-                        block->flags.bits.update_liquid = false;
-                        block->flags.bits.update_liquid_twice = false;
+                        raw->flags.bits.update_liquid = false;
+                        raw->flags.bits.update_liquid_twice = false;
                     }
                     break;
                 case M_KEEP:
                     {
-                        auto bflags = (*biter)->BlockFlags();
+                        auto bflags = block->BlockFlags();
                         out << "flow bit 1 = " << bflags.bits.update_liquid << endl;
                         out << "flow bit 2 = " << bflags.bits.update_liquid_twice << endl;
                     }
                 }
-                biter ++;
             }
             break;
         }
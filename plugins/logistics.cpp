@@ -96,12 +96,10 @@ static void remove_stockpile_config(color_ostream& out, int stockpile_number) {
 
 static const int32_t CYCLE_TICKS = 601;
 static int32_t cycle_timestamp = 0; // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 20);
 
 static command_result do_command(color_ostream &out, vector<string> &parameters);
-static void do_cycle(color_ostream& out,
-        int32_t& melt_count, int32_t& trade_count,
-        int32_t& dump_count, int32_t& train_count,
-        int32_t& forbid_count, int32_t& claim_count);
+static void start_cycle(color_ostream &out);
 static void logistics_cycle(color_ostream &out, bool quiet);
 
 DFhackCExport command_result plugin_init(color_ostream &out, vector<PluginCommand> &commands) {
@@ -198,7 +196,7 @@ DFhackCExport command_result plugin_onupdate(color_ostream &out) {
     if (!Core::getInstance().isMapLoaded() || !World::isFortressMode())
         return CR_OK;
     if (world->frame_counter - cycle_timestamp >= CYCLE_TICKS) {
-        logistics_cycle(out, true);
+        start_cycle(out);
     }
     return CR_OK;
 }
@@ -545,21 +543,41 @@ static void train_partials(color_ostream& out, int32_t& train_count) {
     }
 }
 
-static void do_cycle(color_ostream& out,
-        int32_t& melt_count, int32_t& trade_count,
-        int32_t& dump_count, int32_t& train_count,
-        int32_t& forbid_count, int32_t& claim_count) {
-    DEBUG(cycle,out).print("running {} cycle\n", plugin_name);
-    cycle_timestamp = world->frame_counter;
+// A cycle scans one monitored stockpile per step, so the periodic cycle is
+// spread over several frames by the core; commands run it to completion.
+class LogisticsCycle : public PluginTask {
+public:
+    LogisticsCycle() : PluginTask("logistics", 1000) {}
 
-    ProcessorStats melt_stats, trade_stats, dump_stats, train_stats, forbid_stats, claim_stats;
-    unordered_map<df::building_stockpilest *, PersistentDataItem> cache;
-    validate_stockpile_configs(out, cache);
+    bool quiet = true;
 
-    for (auto &entry : cache) {
-        df::building_stockpilest *bld = entry.first;
-        PersistentDataItem &c = entry.second;
-        int32_t stockpile_number = bld->stockpile_number;
+protected:
+    void begin(color_ostream &out) override {
+        DEBUG(cycle,out).print("running {} cycle\n", plugin_name);
+        cycle_timestamp = world->frame_counter;
+
+        melt_stats = trade_stats = dump_stats = ProcessorStats();
+        train_stats = forbid_stats = claim_stats = ProcessorStats();
+
+        unordered_map<df::building_stockpilest *, PersistentDataItem> cache;
+        validate_stockpile_configs(out, cache);
+        stockpile_numbers.clear();
+        for (auto &entry : cache)
+            stockpile_numbers.push_back(entry.first->stockpile_number);
+        next_stockpile = 0;
+    }
+
+    bool step(color_ostream &out) override {
+        if (next_stockpile >= stockpile_numbers.size())
+            return false;
+
+        // the stockpile or its config may have been removed since the cycle started
+        int32_t stockpile_number = stockpile_numbers[next_stockpile++];
+        auto bld = find_stockpile(stockpile_number);
+        auto it = watched_stockpiles.find(stockpile_number);
+        if (!bld || it == watched_stockpiles.end())
+            return true;
+        PersistentDataItem &c = it->second;
 
         bool melt = c.get_bool(STOCKPILE_CONFIG_MELT);
         bool melt_masterworks = c.get_bool(STOCKPILE_CONFIG_MELT_MASTERWORKS);
@@ -580,20 +598,48 @@ static void do_cycle(color_ostream& out,
                 melt_stock_processor, trade_stock_processor,
                 dump_stock_processor, train_stock_processor,
                 forbid_stock_processor, claim_stock_processor);
+        return true;
     }
 
-    melt_count = melt_stats.newly_designated;
-    trade_count = trade_stats.newly_designated;
-    dump_count = dump_stats.newly_designated;
-    train_count = train_stats.newly_designated;
-    forbid_count = forbid_stats.newly_designated;
-    claim_count = claim_stats.newly_designated;
+    void end(color_ostream &out) override {
+        int32_t melt_count = melt_stats.newly_designated;
+        int32_t trade_count = trade_stats.newly_designated;
+        int32_t dump_count = dump_stats.newly_designated;
+        int32_t train_count = train_stats.newly_designated;
+        int32_t forbid_count = forbid_stats.newly_designated;
+        int32_t claim_count = claim_stats.newly_designated;
+
+        if (config.get_bool(CONFIG_TRAIN_PARTIAL)) {
+            train_partials(out, train_count);
+        }
+
+        TRACE(cycle,out).print("exit {} cycle\n", plugin_name);
 
-    if (config.get_bool(CONFIG_TRAIN_PARTIAL)) {
-        train_partials(out, train_count);
+        if (0 < melt_count || !quiet)
+            out.print("logistics: designated {} item{} for melting\n", melt_count, (melt_count == 1) ? "" : "s");
+        if (0 < trade_count || !quiet)
+            out.print("logistics: designated {} item{} for trading\n", trade_count, (trade_count == 1) ? "" : "s");
+        if (0 < dump_count || !quiet)
+            out.print("logistics: designated {} item{} for dumping\n", dump_count, (dump_count == 1) ? "" : "s");
+        if (0 < train_count || !quiet)
+            out.print("logistics: designated {} animal{} for training\n", train_count, (train_count == 1) ? "" : "s");
+        if (0 < forbid_count || !quiet)
+            out.print("logistics: designated {} item{} forbidden\n", forbid_count, (forbid_count == 1) ? "" : "s");
+        if (0 < claim_count || !quiet)
+            out.print("logistics: claimed {} forbidden item{} \n", claim_count, (claim_count == 1) ? "" : "s");
     }
 
-    TRACE(cycle,out).print("exit {} do_cycle\n", plugin_name);
+private:
+    vector<int32_t> stockpile_numbers;
+    size_t next_stockpile = 0;
+    ProcessorStats melt_stats, trade_stats, dump_stats, train_stats, forbid_stats, claim_stats;
+};
+
+static LogisticsCycle cycle_task;
+
+static void start_cycle(color_ostream &out) {
+    cycle_task.quiet = true;
+    cycle_task.start(out, plugin_self);
 }
 
 /////////////////////////////////////////////////////
@@ -674,20 +720,11 @@ static int logistics_getStockpileData(lua_State *L) {
 
 static void logistics_cycle(color_ostream &out, bool quiet = false) {
     DEBUG(control, out).print("entering logistics_cycle{}\n", quiet ? " (quiet)" : "");
-    int32_t melt_count = 0, trade_count = 0, dump_count = 0, train_count = 0, forbid_count = 0, claim_count = 0;
-    do_cycle(out, melt_count, trade_count, dump_count, train_count, forbid_count, claim_count);
-    if (0 < melt_count || !quiet)
-        out.print("logistics: designated {} item{} for melting\n", melt_count, (melt_count == 1) ? "" : "s");
-    if (0 < trade_count || !quiet)
-        out.print("logistics: designated {} item{} for trading\n", trade_count, (trade_count == 1) ? "" : "s");
-    if (0 < dump_count || !quiet)
-        out.print("logistics: designated {} item{} for dumping\n", dump_count, (dump_count == 1) ? "" : "s");
-    if (0 < train_count || !quiet)
-        out.print("logistics: designated {} animal{} for training\n", train_count, (train_count == 1) ? "" : "s");
-    if (0 < forbid_count || !quiet)
-        out.print("logistics: designated {} item{} forbidden\n", forbid_count, (forbid_count == 1) ? "" : "s");
-    if (0 < claim_count || !quiet)
-        out.print("logistics: claimed {} forbidden item{} \n", claim_count, (claim_count == 1) ? "" : "s");
+    // restart any cycle in progress so that it reports with the requested verbosity
+    cycle_task.cancel();
+    cycle_task.quiet = quiet;
+    cycle_task.start(out, plugin_self);
+    cycle_task.finish(out);
 }
 
 static void find_stockpiles(lua_State *L, int idx,
@@ -7,6 +7,14 @@ for k,v in pairs(_ENV) do
     end
 end
 
+-- clients with a receive callback, by server id (0 for free clients) and
+-- client id
+local watched={}
+
+local function watch_key(server_id)
+    return math.max(server_id,0)
+end
+
 local socket=defclass(socket)
 socket.ATTRS={
     server_id=-1,
@@ -16,7 +24,12 @@ socket.ATTRS={
 function socket:close(  )
     if self.client_id==-1 then
         _funcs.lua_server_close(self.server_id)
+        watched[self.server_id]=nil
     else
+        local by_server=watched[watch_key(self.server_id)]
+        if by_server then
+            by_server[self.client_id]=nil
+        end
         _funcs.lua_client_close(self.server_id,self.client_id)
     end
 end
@@ -61,6 +74,39 @@ end
 function client:send( data )
     _funcs.lua_client_send(self.server_id,self.client_id,data)
 end
+function client:setReceiveCallback( callback,pattern )
+    local key=watch_key(self.server_id)
+    if not callback then
+        if watched[key] then
+            watched[key][self.client_id]=nil
+        end
+        _funcs.lua_client_watch(self.server_id,self.client_id,false)
+        return
+    end
+    local bytes=-1
+    pattern=pattern or "*l"
+    if type(pattern)=='number' then
+        bytes=pattern
+    end
+    watched[key]=watched[key] or {}
+    watched[key][self.client_id]={client=self,callback=callback,bytes=bytes,pattern=pattern}
+    _funcs.lua_client_watch(self.server_id,self.client_id,true)
+end
+
+onClientData._library=function(server_id,client_id,closed)
+    local by_server=watched[server_id]
+    local watch=by_server and by_server[client_id]
+    if not watch then return end
+    while by_server[client_id]==watch do
+        local data=_funcs.lua_client_receive_buffered(server_id,client_id,watch.bytes,tostring(watch.pattern))
+        if data==nil then break end
+        watch.callback(watch.client,data)
+    end
+    if closed and by_server[client_id]==watch then
+        by_server[client_id]=nil
+        watch.callback(watch.client,nil)
+    end
+end
 
 
 local server=defclass(server,socket)
@@ -9,24 +9,48 @@ local VALID_SHOW_VALUES = utils.invert{
 }
 
 function parse_commandline(opts, args)
-    local show = {}
+    local show, zrange = {}, nil
     local positionals = argparse.processArgsGetopt(args, {
             {'h', 'help', handler=function() opts.help = true end},
             {'s', 'show', hasArg=true, handler=function(optarg)
                     show = argparse.stringList(optarg) end},
             {'v', 'values', handler=function() opts.value = true end},
+            {'z', 'zrange', hasArg=true, handler=function(optarg)
+                    zrange = argparse.numberList(optarg, 'zrange') end},
+            {nil, 'rescan', handler=function() opts.rescan = true end},
         })
 
+    local pos1, pos2
     for _,p in ipairs(positionals) do
         if p == 'all' then opts.hidden = true
         elseif p == 'hell' then
             opts.hidden = true
             opts.tube = true
+        elseif not pos1 then
+            pos1 = argparse.coords(p, 'pos')
+        elseif not pos2 then
+            pos2 = argparse.coords(p, 'pos')
         else
             qerror(('unknown keyword: "%s"'):format(p))
         end
     end
 
+    if pos1 then
+        pos2 = pos2 or pos1
+        opts.min_x, opts.max_x = math.min(pos1.x, pos2.x), math.max(pos1.x, pos2.x)
+        opts.min_y, opts.max_y = math.min(pos1.y, pos2.y), math.max(pos1.y, pos2.y)
+        opts.min_z, opts.max_z = math.min(pos1.z, pos2.z), math.max(pos1.z, pos2.z)
+    end
+
+    if zrange then
+        if #zrange < 1 or #zrange > 2 then
+            qerror('zrange must be a single z-level or a range like 10,20')
+        end
+        local zmin, zmax = zrange[1], zrange[2] or zrange[1]
+        opts.min_z = math.max(opts.min_z, math.min(zmin, zmax))
+        opts.max_z = math.min(opts.max_z, math.max(zmin, zmax))
+    end
+
     if #show > 0 then
         for s in pairs(VALID_SHOW_VALUES) do
             opts[s] = false
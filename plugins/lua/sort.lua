@@ -23,10 +23,31 @@ local function get_name(unit)
     return unit and dfhack.toSearchNormalized(dfhack.translation.translateName(dfhack.units.getVisibleName(unit)))
 end
 
-local function sort_by_name_desc(unit1, unit2)
-    local name1 = get_name(unit1)
-    local name2 = get_name(unit2)
-    return utils.compare_name(name1, name2)
+-- Sort keys are lists of numbers and strings that the plugin compares element
+-- by element, smallest first. Keys are computed once per unit, so sorting does
+-- not have to call back into Lua for every comparison. Each key function
+-- appends its criteria to the given key (or a new one) and returns it, so
+-- tie-breakers can be chained.
+
+local function name_key(unit, key)
+    key = key or {}
+    local name = get_name(unit)
+    -- empty names sort last
+    table.insert(key, name == '' and 1 or 0)
+    table.insert(key, name)
+    return key
+end
+
+-- values that are missing sort last when descending and first when ascending
+local function add_optional_key(key, val, ascending)
+    if val == nil then
+        table.insert(key, ascending and 0 or 1)
+        table.insert(key, 0)
+    else
+        table.insert(key, ascending and 1 or 0)
+        table.insert(key, ascending and val or -val)
+    end
+    return key
 end
 
 local active_units = df.global.world.units.active
@@ -81,18 +102,21 @@ local function get_arrival_rating(unit)
     return rating, COLOR_YELLOW
 end
 
-local function sort_by_arrival_desc(unit1, unit2)
-    local cache = get_active_idx_cache()
-    if not cache[unit1.id] then return -1 end
-    if not cache[unit2.id] then return 1 end
-    return utils.compare(cache[unit2.id], cache[unit1.id])
+-- units that are no longer active sort first in either direction
+local function arrival_key_desc(unit, key)
+    key = key or {}
+    local idx = get_active_idx_cache()[unit.id]
+    table.insert(key, idx and 1 or 0)
+    table.insert(key, idx and -idx or 0)
+    return key
 end
 
-local function sort_by_arrival_asc(unit1, unit2)
-    local cache = get_active_idx_cache()
-    if not cache[unit1.id] then return -1 end
-    if not cache[unit2.id] then return 1 end
-    return utils.compare(cache[unit1.id], cache[unit2.id])
+local function arrival_key_asc(unit, key)
+    key = key or {}
+    local idx = get_active_idx_cache()[unit.id]
+    table.insert(key, idx and 1 or 0)
+    table.insert(key, idx or 0)
+    return key
 end
 
 local function get_stress(unit)
@@ -105,26 +129,12 @@ local function get_stress_rating(unit)
     return get_rating(dfhack.units.getStressCategory(unit), 0, 100, 4, 3, 2, 1)
 end
 
-local function sort_by_stress_desc(unit1, unit2)
-    local happiness1 = get_stress(unit1)
-    local happiness2 = get_stress(unit2)
-    if happiness1 == happiness2 then
-        return sort_by_name_desc(unit1, unit2)
-    end
-    if not happiness2 then return -1 end
-    if not happiness1 then return 1 end
-    return utils.compare(happiness2, happiness1)
+local function stress_key_desc(unit, key)
+    return name_key(unit, add_optional_key(key or {}, get_stress(unit), false))
 end
 
-local function sort_by_stress_asc(unit1, unit2)
-    local happiness1 = get_stress(unit1)
-    local happiness2 = get_stress(unit2)
-    if happiness1 == happiness2 then
-        return sort_by_name_desc(unit1, unit2)
-    end
-    if not happiness2 then return 1 end
-    if not happiness1 then return -1 end
-    return utils.compare(happiness1, happiness2)
+local function stress_key_asc(unit, key)
+    return name_key(unit, add_optional_key(key or {}, get_stress(unit), true))
 end
 
 local function get_skill(skill, unit)
@@ -179,22 +189,16 @@ local function get_melee_skill_effectiveness_rating(unit)
     return get_rating(melee_skill_effectiveness(unit), 350000, 2750000, 64, 52, 40, 28)
 end
 
-local function make_sort_by_melee_skill_effectiveness_desc()
-    return function(unit1, unit2)
-        local rating1 = melee_skill_effectiveness(unit1)
-        local rating2 = melee_skill_effectiveness(unit2)
-        if rating1 == rating2 then return sort_by_name_desc(unit1, unit2) end
-        return utils.compare(rating2, rating1)
-    end
+local function melee_skill_effectiveness_key_desc(unit, key)
+    key = key or {}
+    table.insert(key, -melee_skill_effectiveness(unit))
+    return name_key(unit, key)
 end
 
-local function make_sort_by_melee_skill_effectiveness_asc()
-    return function(unit1, unit2)
-        local rating1 = melee_skill_effectiveness(unit1)
-        local rating2 = melee_skill_effectiveness(unit2)
-        if rating1 == rating2 then return sort_by_name_desc(unit1, unit2) end
-        return utils.compare(rating1, rating2)
-    end
+local function melee_skill_effectiveness_key_asc(unit, key)
+    key = key or {}
+    table.insert(key, melee_skill_effectiveness(unit))
+    return name_key(unit, key)
 end
 
 local RANGED_WEAPON_SKILLS = {
@@ -229,55 +233,34 @@ local function get_ranged_skill_effectiveness_rating(unit)
     return get_rating(ranged_skill_effectiveness(unit), 0, 800000, 72, 52, 31, 11)
 end
 
-local function make_sort_by_ranged_skill_effectiveness_desc()
-    return function(unit1, unit2)
-        local rating1 = ranged_skill_effectiveness(unit1)
-        local rating2 = ranged_skill_effectiveness(unit2)
-        if rating1 == rating2 then return sort_by_name_desc(unit1, unit2) end
-        return utils.compare(rating2, rating1)
-    end
-end
-
-local function make_sort_by_ranged_skill_effectiveness_asc()
-    return function(unit1, unit2)
-        local rating1 = ranged_skill_effectiveness(unit1)
-        local rating2 = ranged_skill_effectiveness(unit2)
-        if rating1 == rating2 then return sort_by_name_desc(unit1, unit2) end
-        return utils.compare(rating1, rating2)
-    end
+local function ranged_skill_effectiveness_key_desc(unit, key)
+    key = key or {}
+    table.insert(key, -ranged_skill_effectiveness(unit))
+    return name_key(unit, key)
 end
 
-local function make_sort_by_skill_desc(sort_skill)
-    return function(unit1, unit2)
-        local s1 = get_skill(sort_skill, unit1)
-        local s2 = get_skill(sort_skill, unit2)
-        if s1 == s2 then return sort_by_name_desc(unit1, unit2) end
-        if not s2 then return -1 end
-        if not s1 then return 1 end
-        if s1.rating ~= s2.rating then
-            return utils.compare(s2.rating, s1.rating)
-        end
-        if s1.experience ~= s2.experience then
-            return utils.compare(s2.experience, s1.experience)
-        end
-        return sort_by_name_desc(unit1, unit2)
-    end
+local function ranged_skill_effectiveness_key_asc(unit, key)
+    key = key or {}
+    table.insert(key, ranged_skill_effectiveness(unit))
+    return name_key(unit, key)
 end
 
-local function make_sort_by_skill_asc(sort_skill)
-    return function(unit1, unit2)
-        local s1 = get_skill(sort_skill, unit1)
-        local s2 = get_skill(sort_skill, unit2)
-        if s1 == s2 then return sort_by_name_desc(unit1, unit2) end
-        if not s2 then return 1 end
-        if not s1 then return -1 end
-        if s1.rating ~= s2.rating then
-            return utils.compare(s1.rating, s2.rating)
-        end
-        if s1.experience ~= s2.experience then
-            return utils.compare(s1.experience, s2.experience)
+-- units without the skill sort last when descending and first when ascending
+local function make_skill_key(sort_skill, ascending)
+    local sign = ascending and 1 or -1
+    return function(unit, key)
+        key = key or {}
+        local skill = get_skill(sort_skill, unit)
+        if skill then
+            table.insert(key, ascending and 1 or 0)
+            table.insert(key, sign * skill.rating)
+            table.insert(key, sign * skill.experience)
+        else
+            table.insert(key, ascending and 0 or 1)
+            table.insert(key, 0)
+            table.insert(key, 0)
         end
-        return sort_by_name_desc(unit1, unit2)
+        return name_key(unit, key)
     end
 end
 
@@ -322,24 +305,18 @@ local function get_mental_stability(unit)
     return rating
 end
 
-local function sort_by_mental_stability_desc(unit1, unit2)
-    local rating1 = get_mental_stability(unit1)
-    local rating2 = get_mental_stability(unit2)
-    if rating1 == rating2 then
-        -- sorting by stress is opposite
-        -- more mental stable dwarves should have less stress
-        return sort_by_stress_asc(unit1, unit2)
-    end
-    return utils.compare(rating2, rating1)
+local function mental_stability_key_desc(unit, key)
+    key = key or {}
+    table.insert(key, -get_mental_stability(unit))
+    -- sorting by stress is opposite
+    -- more mental stable dwarves should have less stress
+    return stress_key_asc(unit, key)
 end
 
-local function sort_by_mental_stability_asc(unit1, unit2)
-    local rating1 = get_mental_stability(unit1)
-    local rating2 = get_mental_stability(unit2)
-    if rating1 == rating2 then
-        return sort_by_stress_desc(unit1, unit2)
-    end
-    return utils.compare(rating1, rating2)
+local function mental_stability_key_asc(unit, key)
+    key = key or {}
+    table.insert(key, get_mental_stability(unit))
+    return stress_key_desc(unit, key)
 end
 
 -- Statistical rating that is higher for more potent dwarves in long run melee military training
@@ -373,22 +350,16 @@ local function get_melee_combat_potential_rating(unit)
     return get_rating(get_melee_combat_potential(unit), 350000, 2750000, 64, 52, 40, 28)
 end
 
-local function sort_by_melee_combat_potential_desc(unit1, unit2)
-    local rating1 = get_melee_combat_potential(unit1)
-    local rating2 = get_melee_combat_potential(unit2)
-    if rating1 == rating2 then
-        return sort_by_mental_stability_desc(unit1, unit2)
-    end
-    return utils.compare(rating2, rating1)
+local function melee_combat_potential_key_desc(unit, key)
+    key = key or {}
+    table.insert(key, -get_melee_combat_potential(unit))
+    return mental_stability_key_desc(unit, key)
 end
 
-local function sort_by_melee_combat_potential_asc(unit1, unit2)
-    local rating1 = get_melee_combat_potential(unit1)
-    local rating2 = get_melee_combat_potential(unit2)
-    if rating1 == rating2 then
-        return sort_by_mental_stability_asc(unit1, unit2)
-    end
-    return utils.compare(rating1, rating2)
+local function melee_combat_potential_key_asc(unit, key)
+    key = key or {}
+    table.insert(key, get_melee_combat_potential(unit))
+    return mental_stability_key_asc(unit, key)
 end
 
 -- Statistical rating that is higher for more potent dwarves in long run ranged military training
@@ -416,22 +387,16 @@ local function get_ranged_combat_potential_rating(unit)
     return get_rating(get_ranged_combat_potential(unit), 0, 800000, 72, 52, 31, 11)
 end
 
-local function sort_by_ranged_combat_potential_desc(unit1, unit2)
-    local rating1 = get_ranged_combat_potential(unit1)
-    local rating2 = get_ranged_combat_potential(unit2)
-    if rating1 == rating2 then
-        return sort_by_mental_stability_desc(unit1, unit2)
-    end
-    return utils.compare(rating2, rating1)
+local function ranged_combat_potential_key_desc(unit, key)
+    key = key or {}
+    table.insert(key, -get_ranged_combat_potential(unit))
+    return mental_stability_key_desc(unit, key)
 end
 
-local function sort_by_ranged_combat_potential_asc(unit1, unit2)
-    local rating1 = get_ranged_combat_potential(unit1)
-    local rating2 = get_ranged_combat_potential(unit2)
-    if rating1 == rating2 then
-        return sort_by_mental_stability_asc(unit1, unit2)
-    end
-    return utils.compare(rating1, rating2)
+local function ranged_combat_potential_key_asc(unit, key)
+    key = key or {}
+    table.insert(key, get_ranged_combat_potential(unit))
+    return mental_stability_key_asc(unit, key)
 end
 
 local function get_need(unit)
@@ -454,71 +419,53 @@ local function get_need_rating(unit)
     return 6
 end
 
-local function sort_by_need_desc(unit1, unit2)
-    local rating1 = get_need(unit1)
-    local rating2 = get_need(unit2)
-    if rating1 == rating2 then
-        return sort_by_stress_desc(unit1, unit2)
-    end
-    if not rating2 then return -1 end
-    if not rating1 then return 1 end
-    return utils.compare(rating2, rating1)
+local function need_key_desc(unit, key)
+    return stress_key_desc(unit, add_optional_key(key or {}, get_need(unit), false))
 end
 
-local function sort_by_need_asc(unit1, unit2)
-    local rating1 = get_need(unit1)
-    local rating2 = get_need(unit2)
-    if rating1 == rating2 then
-        return sort_by_stress_asc(unit1, unit2)
-    end
-    if not rating2 then return 1 end
-    if not rating1 then return -1 end
-    return utils.compare(rating1, rating2)
-end
-
-local sort_by_any_melee_desc=make_sort_by_melee_skill_effectiveness_desc()
-local sort_by_any_melee_asc=make_sort_by_melee_skill_effectiveness_asc()
-local sort_by_any_ranged_desc=make_sort_by_ranged_skill_effectiveness_desc()
-local sort_by_any_ranged_asc=make_sort_by_ranged_skill_effectiveness_asc()
-local sort_by_teacher_desc=make_sort_by_skill_desc(df.job_skill.TEACHING)
-local sort_by_teacher_asc=make_sort_by_skill_asc(df.job_skill.TEACHING)
-local sort_by_tactics_desc=make_sort_by_skill_desc(df.job_skill.MILITARY_TACTICS)
-local sort_by_tactics_asc=make_sort_by_skill_asc(df.job_skill.MILITARY_TACTICS)
-local sort_by_ambusher_desc=make_sort_by_skill_desc(df.job_skill.SNEAK)
-local sort_by_ambusher_asc=make_sort_by_skill_asc(df.job_skill.SNEAK)
-local sort_by_pick_desc=make_sort_by_skill_desc(df.job_skill.MINING)
-local sort_by_pick_asc=make_sort_by_skill_asc(df.job_skill.MINING)
-local sort_by_axe_desc=make_sort_by_skill_desc(df.job_skill.AXE)
-local sort_by_axe_asc=make_sort_by_skill_asc(df.job_skill.AXE)
-local sort_by_sword_desc=make_sort_by_skill_desc(df.job_skill.SWORD)
-local sort_by_sword_asc=make_sort_by_skill_asc(df.job_skill.SWORD)
-local sort_by_mace_desc=make_sort_by_skill_desc(df.job_skill.MACE)
-local sort_by_mace_asc=make_sort_by_skill_asc(df.job_skill.MACE)
-local sort_by_hammer_desc=make_sort_by_skill_desc(df.job_skill.HAMMER)
-local sort_by_hammer_asc=make_sort_by_skill_asc(df.job_skill.HAMMER)
-local sort_by_spear_desc=make_sort_by_skill_desc(df.job_skill.SPEAR)
-local sort_by_spear_asc=make_sort_by_skill_asc(df.job_skill.SPEAR)
-local sort_by_crossbow_desc=make_sort_by_skill_desc(df.job_skill.CROSSBOW)
-local sort_by_crossbow_asc=make_sort_by_skill_asc(df.job_skill.CROSSBOW)
+local function need_key_asc(unit, key)
+    return stress_key_asc(unit, add_optional_key(key or {}, get_need(unit), true))
+end
+
+local teacher_key_desc=make_skill_key(df.job_skill.TEACHING, false)
+local teacher_key_asc=make_skill_key(df.job_skill.TEACHING, true)
+local tactics_key_desc=make_skill_key(df.job_skill.MILITARY_TACTICS, false)
+local tactics_key_asc=make_skill_key(df.job_skill.MILITARY_TACTICS, true)
+local ambusher_key_desc=make_skill_key(df.job_skill.SNEAK, false)
+local ambusher_key_asc=make_skill_key(df.job_skill.SNEAK, true)
+local pick_key_desc=make_skill_key(df.job_skill.MINING, false)
+local pick_key_asc=make_skill_key(df.job_skill.MINING, true)
+local axe_key_desc=make_skill_key(df.job_skill.AXE, false)
+local axe_key_asc=make_skill_key(df.job_skill.AXE, true)
+local sword_key_desc=make_skill_key(df.job_skill.SWORD, false)
+local sword_key_asc=make_skill_key(df.job_skill.SWORD, true)
+local mace_key_desc=make_skill_key(df.job_skill.MACE, false)
+local mace_key_asc=make_skill_key(df.job_skill.MACE, true)
+local hammer_key_desc=make_skill_key(df.job_skill.HAMMER, false)
+local hammer_key_asc=make_skill_key(df.job_skill.HAMMER, true)
+local spear_key_desc=make_skill_key(df.job_skill.SPEAR, false)
+local spear_key_asc=make_skill_key(df.job_skill.SPEAR, true)
+local crossbow_key_desc=make_skill_key(df.job_skill.CROSSBOW, false)
+local crossbow_key_asc=make_skill_key(df.job_skill.CROSSBOW, true)
 
 local SORT_LIBRARY = {
-    {label='melee effectiveness', widget='sort_any_melee', desc_fn=sort_by_any_melee_desc, asc_fn=sort_by_any_melee_asc, rating_fn=get_melee_skill_effectiveness_rating},
-    {label='ranged effectiveness', widget='sort_any_ranged', desc_fn=sort_by_any_ranged_desc, asc_fn=sort_by_any_ranged_asc, rating_fn=get_ranged_skill_effectiveness_rating},
-    {label='teacher skill', widget='sort_teacher', desc_fn=sort_by_teacher_desc, asc_fn=sort_by_teacher_asc, rating_fn=curry(get_skill_rating, df.job_skill.TEACHING)},
-    {label='stress level', widget='sort_stress', desc_fn=sort_by_stress_desc, asc_fn=sort_by_stress_asc, rating_fn=get_stress_rating, use_stress_faces=true},
-    {label='arrival order', widget='sort_arrival', desc_fn=sort_by_arrival_desc, asc_fn=sort_by_arrival_asc, rating_fn=get_arrival_rating},
-    {label='tactics skill', widget='sort_tactics', desc_fn=sort_by_tactics_desc, asc_fn=sort_by_tactics_asc, rating_fn=curry(get_skill_rating, df.job_skill.MILITARY_TACTICS)},
-    {label='ambusher skill', widget='sort_ambusher', desc_fn=sort_by_ambusher_desc, asc_fn=sort_by_ambusher_asc, rating_fn=curry(get_skill_rating, df.job_skill.SNEAK)},
-    {label='need for training', widget='sort_need', desc_fn=sort_by_need_desc, asc_fn=sort_by_need_asc, rating_fn=get_need_rating, use_stress_faces=true},
-    {label='pick (mining) skill', widget='sort_pick', desc_fn=sort_by_pick_desc, asc_fn=sort_by_pick_asc, rating_fn=curry(get_skill_rating, df.job_skill.MINING)},
-    {label='axe skill', widget='sort_axe', desc_fn=sort_by_axe_desc, asc_fn=sort_by_axe_asc, rating_fn=curry(get_skill_rating, df.job_skill.AXE)},
-    {label='sword skill', widget='sort_sword', desc_fn=sort_by_sword_desc, asc_fn=sort_by_sword_asc, rating_fn=curry(get_skill_rating, df.job_skill.SWORD)},
-    {label='mace skill', widget='sort_mace', desc_fn=sort_by_mace_desc, asc_fn=sort_by_mace_asc, rating_fn=curry(get_skill_rating, df.job_skill.MACE)},
-    {label='hammer skill', widget='sort_hammer', desc_fn=sort_by_hammer_desc, asc_fn=sort_by_hammer_asc, rating_fn=curry(get_skill_rating, df.job_skill.HAMMER)},
-    {label='spear skill', widget='sort_spear', desc_fn=sort_by_spear_desc, asc_fn=sort_by_spear_asc, rating_fn=curry(get_skill_rating, df.job_skill.SPEAR)},
-    {label='crossbow skill', widget='sort_crossbow', desc_fn=sort_by_crossbow_desc, asc_fn=sort_by_crossbow_asc, rating_fn=curry(get_skill_rating, df.job_skill.CROSSBOW)},
-    {label='melee potential', widget='sort_melee_combat_potential', desc_fn=sort_by_melee_combat_potential_desc, asc_fn=sort_by_melee_combat_potential_asc, rating_fn=get_melee_combat_potential_rating},
-    {label='ranged potential', widget='sort_ranged_combat_potential', desc_fn=sort_by_ranged_combat_potential_desc, asc_fn=sort_by_ranged_combat_potential_asc, rating_fn=get_ranged_combat_potential_rating},
+    {label='melee effectiveness', widget='sort_any_melee', desc_key=melee_skill_effectiveness_key_desc, asc_key=melee_skill_effectiveness_key_asc, rating_fn=get_melee_skill_effectiveness_rating},
+    {label='ranged effectiveness', widget='sort_any_ranged', desc_key=ranged_skill_effectiveness_key_desc, asc_key=ranged_skill_effectiveness_key_asc, rating_fn=get_ranged_skill_effectiveness_rating},
+    {label='teacher skill', widget='sort_teacher', desc_key=teacher_key_desc, asc_key=teacher_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.TEACHING)},
+    {label='stress level', widget='sort_stress', desc_key=stress_key_desc, asc_key=stress_key_asc, rating_fn=get_stress_rating, use_stress_faces=true},
+    {label='arrival order', widget='sort_arrival', desc_key=arrival_key_desc, asc_key=arrival_key_asc, rating_fn=get_arrival_rating},
+    {label='tactics skill', widget='sort_tactics', desc_key=tactics_key_desc, asc_key=tactics_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.MILITARY_TACTICS)},
+    {label='ambusher skill', widget='sort_ambusher', desc_key=ambusher_key_desc, asc_key=ambusher_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.SNEAK)},
+    {label='need for training', widget='sort_need', desc_key=need_key_desc, asc_key=need_key_asc, rating_fn=get_need_rating, use_stress_faces=true},
+    {label='pick (mining) skill', widget='sort_pick', desc_key=pick_key_desc, asc_key=pick_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.MINING)},
+    {label='axe skill', widget='sort_axe', desc_key=axe_key_desc, asc_key=axe_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.AXE)},
+    {label='sword skill', widget='sort_sword', desc_key=sword_key_desc, asc_key=sword_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.SWORD)},
+    {label='mace skill', widget='sort_mace', desc_key=mace_key_desc, asc_key=mace_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.MACE)},
+    {label='hammer skill', widget='sort_hammer', desc_key=hammer_key_desc, asc_key=hammer_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.HAMMER)},
+    {label='spear skill', widget='sort_spear', desc_key=spear_key_desc, asc_key=spear_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.SPEAR)},
+    {label='crossbow skill', widget='sort_crossbow', desc_key=crossbow_key_desc, asc_key=crossbow_key_asc, rating_fn=curry(get_skill_rating, df.job_skill.CROSSBOW)},
+    {label='melee potential', widget='sort_melee_combat_potential', desc_key=melee_combat_potential_key_desc, asc_key=melee_combat_potential_key_asc, rating_fn=get_melee_combat_potential_rating},
+    {label='ranged potential', widget='sort_ranged_combat_potential', desc_key=ranged_combat_potential_key_desc, asc_key=ranged_combat_potential_key_asc, rating_fn=get_ranged_combat_potential_rating},
 }
 for _, v in ipairs(SORT_LIBRARY) do
     SORT_LIBRARY[v.widget] = v
@@ -941,11 +888,11 @@ function SquadAnnotationOverlay:sync_widgets(sort_widget, sort_id)
     self.dirty = true
 end
 
-function do_sort(a, b)
+function get_sort_key(unit)
     local self = annotation_instance
     local opt = SORT_LIBRARY[self.subviews.sort:getOptionValue()]
-    local fn = self.subviews.sort_button.ascending and opt.asc_fn or opt.desc_fn
-    return fn(a, b) < 0
+    local fn = self.subviews.sort_button.ascending and opt.asc_key or opt.desc_key
+    return fn(unit)
 end
 
 function SquadAnnotationOverlay:mouse_over_ours()
@@ -8,6 +8,10 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <tuple>
+#ifndef _WIN32
+#include <sys/select.h>
+#endif
 #include <PassiveSocket.h>
 #include <ActiveSocket.h>
 #include "MiscUtils.h"
@@ -17,24 +21,42 @@
 
 using namespace DFHack;
 using namespace df::enums;
+// how much is requested from the socket per read; lines and frames are cut
+// from the connection's buffer instead of being read a byte at a time
+static const int32_t RECV_CHUNK=4096;
+struct connection
+{
+    CActiveSocket *socket;
+    std::string buffer; //received data, starting at head
+    size_t head=0;
+    bool closed=false; //the peer has closed the connection
+    bool watched=false; //polled every frame, see plugin_onupdate
+    connection(CActiveSocket *socket=NULL):socket(socket){}
+};
+typedef std::map<int,connection> clients_map;
 struct server
 {
     CPassiveSocket *socket;
-    std::map<int,CActiveSocket*> clients;
+    clients_map clients;
     int last_client_id;
     void close();
 };
 std::map<int,server> servers;
-typedef std::map<int,CActiveSocket*> clients_map;
 clients_map clients; //free clients, i.e. non-server spawned clients
 DFHACK_PLUGIN("luasocket");
 
+DEFINE_LUA_EVENT_NH_3(onClientData,int,int,bool);
+
+DFHACK_PLUGIN_LUA_EVENTS {
+    DFHACK_LUA_EVENT(onClientData),
+    DFHACK_LUA_END
+};
 
 void server::close()
 {
     for(auto it=clients.begin();it!=clients.end();it++)
     {
-        CActiveSocket* sock=it->second;
+        CActiveSocket* sock=it->second.socket;
         sock->Close();
         delete sock;
     }
@@ -42,9 +64,9 @@ void server::close()
     socket->Close();
     delete socket;
 }
-std::pair<CActiveSocket*,clients_map*> get_client(int server_id,int client_id)
+std::pair<connection*,clients_map*> get_client(int server_id,int client_id)
 {
-    std::map<int,CActiveSocket*>* target=&clients;
+    clients_map* target=&clients;
     if(server_id>0)
     {
         if(servers.count(server_id)==0)
@@ -59,8 +81,7 @@ std::pair<CActiveSocket*,clients_map*> get_client(int server_id,int client_id)
     {
         throw std::runtime_error("Client does with this id not exist");
     }
-    CActiveSocket *sock=(*target)[client_id];
-    return std::make_pair(sock,target);
+    return std::make_pair(&(*target)[client_id],target);
 }
 void handle_error(CSimpleSocket::CSocketError err,bool skip_timeout=true)
 {
@@ -109,7 +130,7 @@ static int lua_server_accept(int id,bool fail_on_timeout)
     else
     {
         cur_server.last_client_id++;
-        cur_server.clients[cur_server.last_client_id]=sock;
+        cur_server.clients[cur_server.last_client_id]=connection(sock);
         return cur_server.last_client_id;
     }
 }
@@ -117,8 +138,8 @@ static void lua_client_close(int server_id,int client_id)
 {
     auto info=get_client(server_id,client_id);
 
-    CActiveSocket *sock=info.first;
-    std::map<int,CActiveSocket*>* target=info.second;
+    CActiveSocket *sock=info.first->socket;
+    clients_map* target=info.second;
 
     target->erase(client_id);
     CSimpleSocket::CSocketError err=CSimpleSocket::SocketSuccess;
@@ -146,83 +167,167 @@ static void lua_server_close(int server_id)
         throw;
     }
 }
-static std::string lua_client_receive(int server_id,int client_id,int bytes,std::string pattern,bool fail_on_timeout)
+// reads whatever the socket has ready, up to RECV_CHUNK bytes, into the
+// buffer. returns the Receive() result: 0 means the peer closed the
+// connection, -1 an error or timeout. errors other than a timeout or a
+// would-block (e.g. a reset connection) also mark the connection closed.
+static int32_t fill_buffer(connection &conn)
 {
-    auto info=get_client(server_id,client_id);
-    CActiveSocket *sock=info.first;
+    int32_t received=conn.socket->Receive(RECV_CHUNK);
+    if(received>0)
+    {
+        conn.buffer.append((const char*)conn.socket->GetData(),received);
+    }
+    else if(received==0)
+    {
+        conn.closed=true;
+    }
+    else
+    {
+        CSimpleSocket::CSocketError err=conn.socket->GetSocketError();
+        if(err!=CSimpleSocket::SocketEwouldblock && err!=CSimpleSocket::SocketTimedout
+                && err!=CSimpleSocket::SocketInterrupted)
+            conn.closed=true;
+    }
+    return received;
+}
+static std::string take(connection &conn,size_t count)
+{
+    std::string ret=conn.buffer.substr(conn.head,count);
+    conn.head+=ret.size();
+    // drop consumed data once it makes up most of the buffer
+    if(conn.head==conn.buffer.size())
+    {
+        conn.buffer.clear();
+        conn.head=0;
+    }
+    else if(conn.head>RECV_CHUNK && conn.head*2>conn.buffer.size())
+    {
+        conn.buffer.erase(0,conn.head);
+        conn.head=0;
+    }
+    return ret;
+}
+// cuts the next piece matching the pattern out of the buffer, without
+// touching the socket. once the peer has closed the connection, whatever
+// is left is returned as the last piece.
+static bool take_buffered(connection &conn,int bytes,const std::string &pattern,std::string &ret)
+{
+    size_t avail=conn.buffer.size()-conn.head;
     if(bytes>0)
     {
-        if(sock->Receive(bytes)<=0)
+        if(avail>=size_t(bytes))
         {
-            throw std::runtime_error(sock->DescribeError());
+            ret=take(conn,bytes);
+            return true;
         }
-        return std::string((char*)sock->GetData(),bytes);
     }
-    else
+    else if(pattern=="" || pattern=="*l")
     {
-        std::string ret;
-        if(pattern=="*a") //??
+        size_t eol=conn.buffer.find('\n',conn.head);
+        if(eol!=std::string::npos)
         {
-            while(true)
-            {
-                int received=sock->Receive(1);
-                if(received<0)
-                {
-                    handle_error(sock->GetSocketError(),!fail_on_timeout);
-                    return "";//maybe return partial string?
-                }
-                else if(received==0)
-                {
-                    break;
-                }
-                ret+=(char)*sock->GetData();
-
-            }
-            return ret;
+            ret=take(conn,eol-conn.head);
+            take(conn,1);
+            return true;
         }
-        else if (pattern=="" || pattern=="*l")
+    }
+    else if(pattern!="*a")
+    {
+        throw std::runtime_error("Unsupported receive pattern");
+    }
+    if(conn.closed && avail>0)
+    {
+        ret=take(conn,avail);
+        return true;
+    }
+    return false;
+}
+static std::string lua_client_receive(int server_id,int client_id,int bytes,std::string pattern,bool fail_on_timeout)
+{
+    auto info=get_client(server_id,client_id);
+    connection &conn=*info.first;
+    std::string ret;
+    while(!take_buffered(conn,bytes,pattern,ret))
+    {
+        // a byte count that can't be satisfied is an error, as it always was
+        if(conn.closed)
         {
-            while(true)
-            {
-
-                if(sock->Receive(1)<=0)
-                {
-                    handle_error(sock->GetSocketError(),!fail_on_timeout);
-                    return "";//maybe return partial string?
-                }
-                char rec=(char)*sock->GetData();
-                if(rec=='\n')
-                    break;
-                ret+=rec;
-            }
-            return ret;
+            if(bytes>0)
+                throw std::runtime_error("Connection closed");
+            return "";
         }
-        else
+        if(fill_buffer(conn)<0)
         {
-            throw std::runtime_error("Unsupported receive pattern");
+            // the partial data stays buffered for the next call
+            if(bytes>0)
+                throw std::runtime_error(conn.socket->DescribeError());
+            handle_error(conn.socket->GetSocketError(),!fail_on_timeout);
+            return "";
         }
     }
+    return ret;
 }
-static void lua_client_send(int server_id,int client_id,std::string data)
+// like lua_client_receive, but only returns data that was already received.
+// returns nil if there is not enough buffered data for the pattern.
+static int lua_client_receive_buffered(lua_State *L)
 {
-    if(data.size()==0)
-        return;
-    std::map<int,CActiveSocket*>* target=&clients;
-    if(server_id>0)
+    int server_id=luaL_checkint(L,1);
+    int client_id=luaL_checkint(L,2);
+    int bytes=luaL_checkint(L,3);
+    std::string pattern=luaL_optstring(L,4,"*l");
+    std::string ret;
+    bool found;
+    try
     {
-        if(servers.count(server_id)==0)
-        {
-            throw std::runtime_error("Server with this id does not exist");
-        }
-        server &cur_server=servers[server_id];
-        target=&cur_server.clients;
+        found=take_buffered(*get_client(server_id,client_id).first,bytes,pattern,ret);
     }
-
-    if(target->count(client_id)==0)
+    catch(std::exception &e)
     {
-        throw std::runtime_error("Client does with this id not exist");
+        luaL_error(L,"%s",e.what());
+        return 0;
     }
-    CActiveSocket *sock=(*target)[client_id];
+    if(!found)
+        return 0;
+    Lua::Push(L,ret);
+    return 1;
+}
+#ifdef _WIN32
+static size_t count_watched()
+{
+    size_t count=0;
+    for(auto &it : clients)
+        count+=it.second.watched;
+    for(auto &srv : servers)
+        for(auto &it : srv.second.clients)
+            count+=it.second.watched;
+    return count;
+}
+#endif
+static void lua_client_watch(int server_id,int client_id,bool value)
+{
+    connection &conn=*get_client(server_id,client_id).first;
+    // select() only handles descriptors below FD_SETSIZE (on Windows, at most
+    // FD_SETSIZE sockets)
+#ifdef _WIN32
+    if(value && !conn.watched && count_watched()>=FD_SETSIZE)
+#else
+    if(value && conn.socket->GetSocketDescriptor()>=FD_SETSIZE)
+#endif
+    {
+        throw std::runtime_error("Too many sockets to watch");
+    }
+    if(value && !conn.socket->SetNonblocking())
+    {
+        throw std::runtime_error(CSimpleSocket::DescribeError(conn.socket->GetSocketError()));
+    }
+    conn.watched=value;
+}
+static void lua_client_send(int server_id,int client_id,std::string data)
+{
+    if(data.size()==0)
+        return;
+    CActiveSocket *sock=get_client(server_id,client_id).first->socket;
     if(size_t(sock->Send((const uint8_t*)data.c_str(),data.size()))!=data.size())
     {
         throw std::runtime_error(sock->DescribeError());
@@ -246,12 +351,12 @@ static int lua_socket_connect(std::string ip,int port)
     }
     sock->SetNonblocking();
     last_client_id++;
-    clients[last_client_id]=sock;
+    clients[last_client_id]=connection(sock);
     return last_client_id;
 }
 CSimpleSocket* get_socket(int server_id, int client_id)
 {
-    std::map<int, CActiveSocket*>* target = &clients;
+    clients_map* target = &clients;
     if (server_id>0)
     {
         if (servers.count(server_id) == 0)
@@ -270,8 +375,7 @@ CSimpleSocket* get_socket(int server_id, int client_id)
     {
         throw std::runtime_error("Client does with this id not exist");
     }
-    CActiveSocket *sock = (*target)[client_id];
-    return sock;
+    return (*target)[client_id].socket;
 }
 static void lua_socket_set_timeout(int server_id,int client_id,int32_t sec,int32_t msec)
 {
@@ -324,6 +428,11 @@ DFHACK_PLUGIN_LUA_FUNCTIONS {
     DFHACK_LUA_FUNCTION(lua_client_close),
     DFHACK_LUA_FUNCTION(lua_client_send),
     DFHACK_LUA_FUNCTION(lua_client_receive),
+    DFHACK_LUA_FUNCTION(lua_client_watch),
+    DFHACK_LUA_END
+};
+DFHACK_PLUGIN_LUA_COMMANDS {
+    DFHACK_LUA_COMMAND(lua_client_receive_buffered),
     DFHACK_LUA_END
 };
 DFhackCExport command_result plugin_init ( color_ostream &out, std::vector <PluginCommand> &commands)
@@ -331,11 +440,61 @@ DFhackCExport command_result plugin_init ( color_ostream &out, std::vector <Plug
 
     return CR_OK;
 }
+// services all watched connections with a single select() per frame, then
+// lets Lua know which of them have new data
+DFhackCExport command_result plugin_onupdate ( color_ostream &out )
+{
+    struct watched_client
+    {
+        int server_id;
+        int client_id;
+        connection *conn;
+    };
+    std::vector<watched_client> watched;
+    for(auto &it : clients)
+        if(it.second.watched)
+            watched.push_back({0,it.first,&it.second});
+    for(auto &srv : servers)
+        for(auto &it : srv.second.clients)
+            if(it.second.watched)
+                watched.push_back({srv.first,it.first,&it.second});
+    if(watched.empty())
+        return CR_OK;
+
+    fd_set readable;
+    FD_ZERO(&readable);
+    SOCKET max_fd=0;
+    for(auto &w : watched)
+    {
+        SOCKET fd=w.conn->socket->GetSocketDescriptor();
+        FD_SET(fd,&readable);
+        if(fd>max_fd)
+            max_fd=fd;
+    }
+    timeval timeout={0,0};
+    if(select(max_fd+1,&readable,NULL,NULL,&timeout)<=0)
+        return CR_OK;
+
+    // read everything first; the Lua handlers may close connections
+    std::vector<std::tuple<int,int,bool>> ready;
+    for(auto &w : watched)
+    {
+        if(!FD_ISSET(w.conn->socket->GetSocketDescriptor(),&readable))
+            continue;
+        while(fill_buffer(*w.conn)>0);
+        if(w.conn->closed)
+            w.conn->watched=false;
+        ready.emplace_back(w.server_id,w.client_id,w.conn->closed);
+    }
+    for(auto &[server_id,client_id,closed] : ready)
+        onClientData(out,server_id,client_id,closed);
+    return CR_OK;
+}
 DFhackCExport command_result plugin_shutdown ( color_ostream &out )
 {
     for(auto it=clients.begin();it!=clients.end();it++)
     {
-        CActiveSocket* sock=it->second;
+        CActiveSocket* sock=it->second.socket;
         sock->Close();
         delete sock;
     }
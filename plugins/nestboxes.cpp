@@ -41,6 +41,7 @@ enum ConfigValues {
 
 static const int32_t CYCLE_TICKS = 7; // need to react quickly when eggs are laid/unforbidden
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 2);
 
 static void do_cycle(color_ostream &out);
 
@@ -5,6 +5,7 @@
 
 #include "modules/Filesystem.h"
 #include "modules/Materials.h"
+#include "modules/Raws.h"
 #include "modules/World.h"
 
 #include "json/json.h"
@@ -807,18 +808,7 @@ static command_result orders_import(color_ostream &out, Json::Value &orders)
                 if (it2.isMember("reaction_id"))
                 {
                     std::string reaction_code = it2["reaction_id"].asString();
-                    df::reaction *reaction = NULL;
-                    int32_t reaction_id = -1;
-                    size_t num_reactions = world->raws.reactions.reactions.size();
-                    for (size_t idx = 0; idx < num_reactions; ++idx)
-                    {
-                        reaction = world->raws.reactions.reactions[idx];
-                        if (reaction->code == reaction_code)
-                        {
-                            reaction_id = idx;
-                            break;
-                        }
-                    }
+                    int32_t reaction_id = Raws::findReaction(reaction_code);
                     if (reaction_id < 0)
                     {
                         delete condition;
@@ -829,6 +819,7 @@ static command_result orders_import(color_ostream &out, Json::Value &orders)
                     }
 
                     condition->reaction_id = reaction_id;
+                    df::reaction *reaction = world->raws.reactions.reactions[reaction_id];
 
                     if (it2.isMember("contains"))
                     {
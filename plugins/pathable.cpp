@@ -1,4 +1,5 @@
 #include <stack>
+#include <vector>
 
 #include "Debug.h"
 #include "Error.h"
@@ -19,6 +20,7 @@
 
 #include "df/building_tradedepotst.h"
 #include "df/init.h"
+#include "df/map_block.h"
 #include "df/plotinfost.h"
 #include "df/world.h"
 
@@ -46,7 +48,16 @@ DFhackCExport command_result plugin_init(color_ostream &out, std::vector<PluginC
     return CR_OK;
 }
 
+static void reset_flood_cache();
+
 DFhackCExport command_result plugin_shutdown(color_ostream &out) {
+    reset_flood_cache();
+    return CR_OK;
+}
+
+DFhackCExport command_result plugin_onstatechange(color_ostream &out, state_change_event event) {
+    if (event == SC_MAP_UNLOADED)
+        reset_flood_cache();
     return CR_OK;
 }
 
@@ -70,7 +81,7 @@ struct PaintCtx {
     }
 };
 
-static void paint_screen(const PaintCtx & ctx, const unordered_set<df::coord> & targets,
+static void paint_screen(const PaintCtx & ctx, std::function<bool(const df::coord & pos)> is_target,
     bool show_hidden, std::function<bool(const df::coord & pos)> get_can_walk)
 {
     auto dims = Gui::getDwarfmodeViewDims().map();
@@ -103,7 +114,7 @@ static void paint_screen(const PaintCtx & ctx, const unordered_set<df::coord> &
                              can_walk ? "" : "not ", x, y);
 
             if (ctx.use_graphics) {
-                if (targets.contains(map_pos)) {
+                if (is_target(map_pos)) {
                     cur_tile.tile = ctx.selected_tile_texpos;
                 } else{
                     cur_tile.tile = can_walk ?
@@ -111,7 +122,7 @@ static void paint_screen(const PaintCtx & ctx, const unordered_set<df::coord> &
                 }
             } else {
                 int color = can_walk ? COLOR_GREEN : COLOR_RED;
-                if (targets.contains(map_pos))
+                if (is_target(map_pos))
                     color = COLOR_CYAN;
                 if (cur_tile.fg && cur_tile.ch != ' ') {
                     cur_tile.fg = color;
@@ -136,27 +147,27 @@ static void paintScreenPathable(df::coord target, bool show_hidden = false) {
     DEBUG(log).print("entering paintScreen\n");
 
     PaintCtx ctx;
-    unordered_set<df::coord> targets;
-    targets.emplace(target);
-    paint_screen(ctx, targets, show_hidden, [&](const df::coord & pos){
+    paint_screen(ctx, [&](const df::coord & pos){
+        return pos == target;
+    }, show_hidden, [&](const df::coord & pos){
         return Maps::canWalkBetween(target, pos);
     });
 }
 
-static bool get_depot_coords(color_ostream &out, unordered_set<df::coord> * depot_coords) {
+static bool get_depot_coords(color_ostream &out, std::vector<df::coord> * depot_coords) {
     CHECK_NULL_POINTER(depot_coords);
 
     depot_coords->clear();
     for (auto bld : world->buildings.other.TRADE_DEPOT){
         DEBUG(log,out).print("found depot at ({}, {}, {})\n", bld->centerx, bld->centery, bld->z);
-        depot_coords->emplace(bld->centerx, bld->centery, bld->z);
+        depot_coords->emplace_back(bld->centerx, bld->centery, bld->z);
     }
 
     return !depot_coords->empty();
 }
 
 static bool get_pathability_groups(color_ostream &out, unordered_set<uint16_t> * depot_pathability_groups,
-    const unordered_set<df::coord> & depot_coords)
+    const std::vector<df::coord> & depot_coords)
 {
     CHECK_NULL_POINTER(depot_pathability_groups);
 
@@ -173,7 +184,7 @@ static bool get_pathability_groups(color_ostream &out, unordered_set<uint16_t> *
 // if entry_tiles is given, it is filled with the surface edge tiles that match one of the given
 // depot pathability groups. If entry_tiles is NULL, just returns true if such a tile is found.
 // returns false if no tiles are found
-static bool get_entry_tiles(unordered_set<df::coord> * entry_tiles, const unordered_set<uint16_t> & depot_pathability_groups) {
+static bool get_entry_tiles(std::vector<df::coord> * entry_tiles, const unordered_set<uint16_t> & depot_pathability_groups) {
     auto & edge = plotinfo->map_edge;
     size_t num_edge_tiles = edge.surface_x.size();
     uint32_t count_x, count_y, count_z;
@@ -191,14 +202,14 @@ static bool get_entry_tiles(unordered_set<df::coord> * entry_tiles, const unorde
             found = true;
             if (!entry_tiles)
                 break;
-            entry_tiles->emplace(pos);
+            entry_tiles->push_back(pos);
         }
     }
     return found;
 }
 
 static bool getDepotAccessibleByAnimals(color_ostream &out) {
-    unordered_set<df::coord> depot_coords;
+    std::vector<df::coord> depot_coords;
     if (!get_depot_coords(out, &depot_coords))
         return false;
     unordered_set<uint16_t> depot_pathability_groups;
@@ -207,17 +218,6 @@ static bool getDepotAccessibleByAnimals(color_ostream &out) {
     return get_entry_tiles(NULL, depot_pathability_groups);
 }
 
-struct FloodCtx {
-    uint16_t wgroup;
-    unordered_set<df::coord> & wagon_path;
-    unordered_set<df::coord> seen; // contains tiles that should not be added to search_edge
-    stack<df::coord> search_edge;  // contains tiles that can be successfully moved into
-    const unordered_set<df::coord> & entry_tiles;
-
-    FloodCtx(uint16_t wgroup, unordered_set<df::coord> & wagon_path, const unordered_set<df::coord> & entry_tiles)
-        : wgroup(wgroup), wagon_path(wagon_path), entry_tiles(entry_tiles) {}
-};
-
 static bool is_wagon_dynamic_traversible(df::tiletype_shape shape, const df::coord & pos) {
     auto bld = Buildings::findAtTile(pos);
     if (!bld) return false;
@@ -270,17 +270,12 @@ static bool is_wagon_tile_traversible(df::tiletype tt) {
     return true;
 }
 
-static bool is_wagon_traversible(FloodCtx & ctx, const df::coord & pos, const df::coord & prev_pos) {
-    auto tt = Maps::getTileType(pos);
-    if (!tt)
-        return false;
-
-    auto shape = tileShape(*tt);
-    auto occp = Maps::getTileOccupancy(pos);
-    if (!occp)
-        return false;
-    auto & occ = *occp;
-    switch (occ.bits.building) {
+// returns whether the building and tile type at the given block tile allow a wagon,
+// regardless of walkability groups
+static bool is_wagon_passable(df::map_block *block, int x, int y) {
+    auto tt = block->tiletype[x][y];
+    auto shape = tileShape(tt);
+    switch (block->occupancy[x][y].bits.building) {
         case tile_building_occ::Obstacle: // Statues, windmills (middle tile)
             //FALLTHROUGH
         case tile_building_occ::Well:
@@ -291,9 +286,7 @@ static bool is_wagon_traversible(FloodCtx & ctx, const df::coord & pos, const df
         case tile_building_occ::Dynamic:
             // doors(block), levers (block), traps (block), hatches (OK, but block on down ramp)
             // closed floor grates (OK), closed floor bars (OK)
-            if (is_wagon_dynamic_traversible(shape, pos) == false)
-                return false;
-            break;
+            return is_wagon_dynamic_traversible(shape, block->map_pos + df::coord(x, y, 0));
 
         case tile_building_occ::None: // Not occupied by a building
             //FALLTHROUGH
@@ -304,19 +297,222 @@ static bool is_wagon_traversible(FloodCtx & ctx, const df::coord & pos, const df
             // beds, supports, rollers, armor/weapon stands, cages (not traps),
             // open wall grate/vertical bars, retracted bridges, open floodgates,
             // workshops (tiles with open space are handled by the tile check)
-            if (is_wagon_tile_traversible(*tt) == false)
-                return false;
-            break;
+            return is_wagon_tile_traversible(tt);
+
         case tile_building_occ::Floored:
             // depot, lowered bridges or retractable bridges, forbidden hatches
             break;
     }
+    return true;
+}
+
+// The wagon flood is cached between overlay refreshes. Every block that the
+// flood reads is recorded together with a fingerprint of its tile types,
+// building occupancy, dynamic building state, and walkability groups. While
+// none of those blocks change and the depots and entry tiles stay the same,
+// the previous result is still valid. When something does change, only the
+// changed blocks are reclassified before flooding again.
+struct BlockState {
+    uint32_t checked = 0;       // refresh in which the fingerprint was last compared
+    uint32_t changed = 0;       // refresh in which the fingerprint last changed
+    uint32_t flood = 0;         // flood that last recorded this block as read
+    uint64_t fingerprint = 0;
+    uint16_t passable[16] = {}; // per row, one bit per tile that passes is_wagon_passable
+};
+
+struct FloodCache {
+    int32_t x_blocks = 0, y_blocks = 0, z_levels = 0;
+    std::vector<BlockState> blocks;
+
+    // tile masks: 16 rows per block, one bit per tile
+    std::vector<uint16_t> wagon_path;
+    std::vector<uint16_t> entry_mask;
+    // tiles the current depot flood should not queue again. bits are only set
+    // in blocks listed in deps, so clearing it never walks the whole map.
+    std::vector<uint16_t> seen;
+
+    std::vector<df::coord> depots;
+    std::vector<df::coord> entry_tiles;
+    std::vector<int> deps; // blocks read by the last flood
+    uint32_t refresh = 0;
+    uint32_t flood = 0;
+    bool valid = false;
+    bool found = false;
+
+    int block_index(const df::coord & pos) const {
+        if (pos.x < 0 || pos.y < 0 || pos.z < 0)
+            return -1;
+        int bx = pos.x >> 4, by = pos.y >> 4;
+        if (bx >= x_blocks || by >= y_blocks || pos.z >= z_levels)
+            return -1;
+        return (pos.z * y_blocks + by) * x_blocks + bx;
+    }
+
+    bool test(const std::vector<uint16_t> & mask, const df::coord & pos) const {
+        int idx = block_index(pos);
+        return idx >= 0 && (mask[idx * 16 + (pos.y & 15)] & (1 << (pos.x & 15)));
+    }
+
+    // returns false if the tile is off the map or was already set
+    bool set(std::vector<uint16_t> & mask, const df::coord & pos) const {
+        int idx = block_index(pos);
+        if (idx < 0)
+            return false;
+        uint16_t & row = mask[idx * 16 + (pos.y & 15)];
+        uint16_t bit = 1 << (pos.x & 15);
+        if (row & bit)
+            return false;
+        row |= bit;
+        return true;
+    }
+
+    // starts a new refresh; returns false if there is no map
+    bool begin_refresh() {
+        int32_t x, y, z;
+        Maps::getSize(x, y, z);
+        if (x <= 0 || y <= 0 || z <= 0)
+            return false;
+        if (x != x_blocks || y != y_blocks || z != z_levels || blocks.empty()) {
+            *this = FloodCache();
+            x_blocks = x;
+            y_blocks = y;
+            z_levels = z;
+            blocks.resize(size_t(x) * y * z);
+            wagon_path.resize(blocks.size() * 16);
+            entry_mask.resize(blocks.size() * 16);
+            seen.resize(blocks.size() * 16);
+        }
+        ++refresh;
+        return true;
+    }
+
+    // compares the block against its fingerprint, reclassifying its tiles if it changed
+    BlockState & validate(int idx) {
+        BlockState & state = blocks[idx];
+        if (state.checked == refresh)
+            return state;
+        state.checked = refresh;
+
+        int bx = idx % x_blocks;
+        int by = (idx / x_blocks) % y_blocks;
+        int bz = idx / (x_blocks * y_blocks);
+        auto block = Maps::getBlock(bx, by, bz);
+
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&](uint64_t v) { hash = (hash ^ v) * 1099511628211ULL; };
+        if (block) {
+            for (int x = 0; x < 16; ++x) {
+                for (int y = 0; y < 16; ++y) {
+                    auto tt = block->tiletype[x][y];
+                    auto occ = block->occupancy[x][y].bits.building;
+                    mix(tt);
+                    mix(occ);
+                    mix(block->walkable[x][y]);
+                    // doors, hatches, and floor grates open and close without
+                    // changing the tile occupancy
+                    if (occ == tile_building_occ::Dynamic)
+                        mix(is_wagon_dynamic_traversible(tileShape(tt), block->map_pos + df::coord(x, y, 0)));
+                }
+            }
+        }
+
+        if (state.changed && hash == state.fingerprint)
+            return state;
+
+        state.fingerprint = hash;
+        state.changed = refresh;
+        for (int y = 0; y < 16; ++y) {
+            uint16_t row = 0;
+            if (block) {
+                for (int x = 0; x < 16; ++x) {
+                    if (is_wagon_passable(block, x, y))
+                        row |= 1 << x;
+                }
+            }
+            state.passable[y] = row;
+        }
+        return state;
+    }
+
+    // validates the block containing pos and records it as read by the current flood
+    BlockState * touch(const df::coord & pos) {
+        int idx = block_index(pos);
+        if (idx < 0)
+            return NULL;
+        BlockState & state = validate(idx);
+        if (state.flood != flood) {
+            state.flood = flood;
+            deps.push_back(idx);
+        }
+        return &state;
+    }
+
+    // returns false if the tile is off the map or was already seen
+    bool mark_seen(const df::coord & pos) {
+        return touch(pos) && set(seen, pos);
+    }
+
+    void clear_seen() {
+        for (int idx : deps)
+            std::fill_n(seen.begin() + idx * 16, 16, 0);
+    }
+
+    bool is_current(const std::vector<df::coord> & depot_coords, const std::vector<df::coord> & entries) {
+        if (!valid || depot_coords != depots || entries != entry_tiles)
+            return false;
+        for (int idx : deps) {
+            if (validate(idx).changed == refresh)
+                return false;
+        }
+        return true;
+    }
+
+    void clear_result() {
+        valid = found = false;
+        depots.clear();
+        entry_tiles.clear();
+        clear_seen();
+        deps.clear();
+        std::fill(wagon_path.begin(), wagon_path.end(), 0);
+        std::fill(entry_mask.begin(), entry_mask.end(), 0);
+    }
+
+    void begin_flood(const std::vector<df::coord> & depot_coords, const std::vector<df::coord> & entries) {
+        clear_result();
+        ++flood;
+        depots = depot_coords;
+        entry_tiles = entries;
+        for (auto & pos : entry_tiles)
+            set(entry_mask, pos);
+    }
+};
+
+static FloodCache flood_cache;
+
+static void reset_flood_cache() {
+    flood_cache = FloodCache();
+}
+
+struct FloodCtx {
+    uint16_t wgroup;
+    stack<df::coord> search_edge;  // contains tiles that can be successfully moved into
+
+    FloodCtx(uint16_t wgroup) : wgroup(wgroup) {}
+};
+
+static bool is_wagon_traversible(FloodCtx & ctx, const df::coord & pos, const df::coord & prev_pos) {
+    auto state = flood_cache.touch(pos);
+    if (!state || !(state->passable[pos.y & 15] & (1 << (pos.x & 15))))
+        return false;
+
+    auto shape = tileShape(*Maps::getTileType(pos));
 
     if (ctx.wgroup == Maps::getWalkableGroup(pos))
         return true;
 
     if (shape == df::tiletype_shape::RAMP_TOP ) {
         df::coord pos_below = pos + df::coord(0, 0, -1);
+        flood_cache.touch(pos_below);
         if (Maps::getWalkableGroup(pos_below)) {
             ctx.search_edge.emplace(pos_below);
             return true;
@@ -325,6 +521,7 @@ static bool is_wagon_traversible(FloodCtx & ctx, const df::coord & pos, const df
         auto prev_tt = Maps::getTileType(prev_pos);
         if (prev_tt && tileShape(*prev_tt) == df::tiletype_shape::RAMP) {
             df::coord pos_above = pos + df::coord(0, 0, 1);
+            flood_cache.touch(pos_above);
             if (Maps::getWalkableGroup(pos_above)) {
                 ctx.search_edge.emplace(pos_above);
                 return true;
@@ -336,13 +533,11 @@ static bool is_wagon_traversible(FloodCtx & ctx, const df::coord & pos, const df
 }
 
 static void check_wagon_tile(FloodCtx & ctx, const df::coord & pos) {
-    if (ctx.seen.contains(pos))
+    if (!flood_cache.mark_seen(pos))
         return;
 
-    ctx.seen.emplace(pos);
-
-    if (ctx.entry_tiles.contains(pos)) {
-        ctx.wagon_path.emplace(pos); // Is this needed?
+    if (flood_cache.test(flood_cache.entry_mask, pos)) {
+        flood_cache.set(flood_cache.wagon_path, pos); // Is this needed?
         ctx.search_edge.emplace(pos);
         return;
     }
@@ -357,7 +552,7 @@ static void check_wagon_tile(FloodCtx & ctx, const df::coord & pos) {
         is_wagon_traversible(ctx, pos+df::coord( 0,  1, 0), pos) &&
         is_wagon_traversible(ctx, pos+df::coord( 1,  1, 0), pos))
     {
-        ctx.wagon_path.emplace(pos);
+        flood_cache.set(flood_cache.wagon_path, pos);
         ctx.search_edge.emplace(pos);
     }
 }
@@ -368,18 +563,20 @@ static void check_wagon_tile(FloodCtx & ctx, const df::coord & pos) {
 // - if three adjacent tiles are in the same pathability group, then they are traversible by a wagon
 // - a wagon needs a single ramp to move elevations as long as the adjacent tiles are walkable
 // TODO: cannot traverse doors, up stairs, or up/down stairs
-static bool wagon_flood(color_ostream &out, unordered_set<df::coord> * wagon_path, const df::coord & depot_pos,
-    const unordered_set<df::coord> & entry_tiles)
-{
-    unordered_set<df::coord> temp_wagon_path;
-    FloodCtx ctx(Maps::getWalkableGroup(depot_pos), wagon_path ? *wagon_path : temp_wagon_path, entry_tiles);
+static bool wagon_flood(color_ostream &out, const df::coord & depot_pos) {
+    if (!flood_cache.touch(depot_pos))
+        return false;
+
+    // forget the tiles seen by the previous depot's flood
+    flood_cache.clear_seen();
+    FloodCtx ctx(Maps::getWalkableGroup(depot_pos));
 
     if (!ctx.wgroup)
         return false;
 
     bool found = false;
-    ctx.wagon_path.emplace(depot_pos);
-    ctx.seen.emplace(depot_pos);
+    flood_cache.set(flood_cache.wagon_path, depot_pos);
+    flood_cache.mark_seen(depot_pos);
     ctx.search_edge.emplace(depot_pos);
 
     while (!ctx.search_edge.empty()) {
@@ -389,10 +586,8 @@ static bool wagon_flood(color_ostream &out, unordered_set<df::coord> * wagon_pat
         TRACE(log,out).print("checking tile: ({}, {}, {}); pathability group: {}\n", pos.x, pos.y, pos.z,
             Maps::getWalkableGroup(pos));
 
-        if (entry_tiles.contains(pos)) {
+        if (flood_cache.test(flood_cache.entry_mask, pos)) {
             found = true;
-            if (!wagon_path)
-                break;
             continue;
         }
 
@@ -405,37 +600,45 @@ static bool wagon_flood(color_ostream &out, unordered_set<df::coord> * wagon_pat
     return found;
 }
 
-static unordered_set<df::coord> wagon_path;
-static unordered_set<df::coord> entry_tiles;
-
-static bool getDepotAccessibleByWagons(color_ostream &out, bool cache_scan_for_painting) {
-    if (cache_scan_for_painting) {
-        entry_tiles.clear();
-        wagon_path.clear();
-    }
-    unordered_set<df::coord> depot_coords;
-    if (!get_depot_coords(out, &depot_coords))
+// the full wagon path is always computed and cached, so the result serves both
+// the accessibility check and paintScreenDepotAccess
+static bool getDepotAccessibleByWagons(color_ostream &out, bool /* cache_scan_for_painting */) {
+    if (!flood_cache.begin_refresh())
         return false;
+    std::vector<df::coord> depot_coords;
     unordered_set<uint16_t> depot_pathability_groups;
-    if (!get_pathability_groups(out, &depot_pathability_groups, depot_coords))
-        return false;
-    if (!get_entry_tiles(&entry_tiles, depot_pathability_groups))
+    std::vector<df::coord> entry_tiles;
+    if (!get_depot_coords(out, &depot_coords) ||
+        !get_pathability_groups(out, &depot_pathability_groups, depot_coords) ||
+        !get_entry_tiles(&entry_tiles, depot_pathability_groups))
+    {
+        flood_cache.clear_result();
         return false;
+    }
+
+    if (flood_cache.is_current(depot_coords, entry_tiles)) {
+        TRACE(log,out).print("reusing cached wagon flood\n");
+        return flood_cache.found;
+    }
+
+    DEBUG(log,out).print("recomputing wagon flood\n");
+    flood_cache.begin_flood(depot_coords, entry_tiles);
     bool found_edge = false;
-    for (auto depot_pos : depot_coords) {
-        if (wagon_flood(out, cache_scan_for_painting ? &wagon_path : NULL, depot_pos, entry_tiles)) {
+    for (auto & depot_pos : depot_coords) {
+        if (wagon_flood(out, depot_pos))
             found_edge = true;
-            if (!cache_scan_for_painting)
-                break;
-        }
     }
+    flood_cache.found = found_edge;
+    flood_cache.valid = true;
     return found_edge;
 }
 
 static void paintScreenDepotAccess() {
     PaintCtx ctx;
-    paint_screen(ctx, entry_tiles, false, [&](const df::coord & pos){
-        return wagon_path.contains(pos);
+    paint_screen(ctx, [&](const df::coord & pos){
+        return flood_cache.test(flood_cache.entry_mask, pos);
+    }, false, [&](const df::coord & pos){
+        return flood_cache.test(flood_cache.wagon_path, pos);
     });
 }
 
@@ -22,6 +22,8 @@
 #include "df/plant_tree_tile.h"
 #include "df/world.h"
 
+#include <unordered_set>
+
 using std::string;
 using std::vector;
 using namespace DFHack;
@@ -293,6 +295,22 @@ static bool plant_in_cuboid(const df::plant *plant, const cuboid &bounds)
     return false;
 }
 
+static df::map_block_column *get_plant_column(int x, int y)
+{   // Plants are listed in the column at the northwest block of their 48x48 region
+    return Maps::getBlockColumn((x / 48)*3, (y / 48)*3);
+}
+
+static vector<df::plant *> get_plants_near(const cuboid &bounds, int margin = 0)
+{   // Plants listed by the block columns within margin tiles of the cuboid
+    vector<df::plant *> plants;
+    int x_max = bounds.x_max + margin, y_max = bounds.y_max + margin;
+    for (int x = std::max(0, bounds.x_min - margin) / 48 * 48; x <= x_max; x += 48)
+        for (int y = std::max(0, bounds.y_min - margin) / 48 * 48; y <= y_max; y += 48)
+            if (auto col = get_plant_column(x, y))
+                plants.insert(plants.end(), col->plants.begin(), col->plants.end());
+    return plants;
+}
+
 command_result df_grow(color_ostream &out, const cuboid &bounds, const plant_options &options, vector<int32_t> *filter = nullptr)
 {
     if (!bounds.isValid())
@@ -310,7 +328,8 @@ command_result df_grow(color_ostream &out, const cuboid &bounds, const plant_opt
     bool do_trees = age > sapling_to_tree_threshold;
 
     int grown = 0, grown_trees = 0;
-    for (auto plant : world->plants.all)
+    // tree crowns reach well under a region past the trunk
+    for (auto plant : get_plants_near(bounds, 48))
     {
         if (ENUM_ATTR(plant_type, is_shrub, plant->type))
             continue; // Shrub
@@ -356,42 +375,29 @@ command_result df_grow(color_ostream &out, const cuboid &bounds, const plant_opt
     return CR_OK;
 }
 
-static bool uncat_plant(df::plant *plant)
-{   // Remove plant from extra vectors
-    vector<df::plant *> *vec = NULL;
+static void remove_plants(const std::unordered_set<df::plant *> &victims)
+{   // Drop the plants from every vector that lists them, keeping the order of the rest
+    std::unordered_set<df::map_block_column *> cols;
+    for (auto plant : victims)
+        if (auto col = get_plant_column(plant->pos.x, plant->pos.y))
+            cols.insert(col);
 
-    switch (plant->type)
+    auto compact = [&](vector<df::plant *> &vec)
     {
-        case plant_type::DRY_TREE: vec = &world->plants.tree_dry; break;
-        case plant_type::WET_TREE: vec = &world->plants.tree_wet; break;
-        case plant_type::DRY_PLANT: vec = &world->plants.shrub_dry; break;
-        case plant_type::WET_PLANT: vec = &world->plants.shrub_wet; break;
-    }
-
-    for (size_t i = vec->size(); i-- > 0;)
-    {   // Not sorted, but more likely near end
-        if ((*vec)[i] == plant)
-        {
-            vec->erase(vec->begin() + i);
-            break;
-        }
-    }
-
-    auto col = Maps::getBlockColumn((plant->pos.x / 48)*3, (plant->pos.y / 48)*3);
-    if (!col)
-        return false;
-
-    vec = &col->plants;
-    for (size_t i = vec->size(); i-- > 0;)
-    {   // Not sorted, but more likely near end
-        if ((*vec)[i] == plant)
-        {
-            vec->erase(vec->begin() + i);
-            break;
-        }
-    }
-
-    return true;
+        vec.erase(std::remove_if(vec.begin(), vec.end(),
+            [&](df::plant *plant) { return victims.count(plant) > 0; }), vec.end());
+    };
+
+    compact(world->plants.all);
+    compact(world->plants.tree_dry);
+    compact(world->plants.tree_wet);
+    compact(world->plants.shrub_dry);
+    compact(world->plants.shrub_wet);
+    for (auto col : cols)
+        compact(col->plants);
+
+    for (auto plant : victims)
+        delete plant;
 }
 
 static bool has_grass(df::map_block *block, int tx, int ty)
@@ -438,15 +444,17 @@ command_result df_removeplant(color_ostream &out, const cuboid &bounds, const pl
 
 
     int count = 0, count_bad = 0;
-    auto &vec = world->plants.all;
-    for (size_t i = vec.size(); i-- > 0;)
+    // removed plants are collected first and then dropped from all vectors
+    // at once, since erasing them one at a time is quadratic
+    std::unordered_set<df::plant *> victims;
+    for (auto plant_ptr : get_plants_near(bounds))
     {
-        auto &plant = *vec[i];
-        auto tt = Maps::getTileType(plant.pos);
-
+        auto &plant = *plant_ptr;
         if (plant.tree_info) // TODO: handle trees
             continue; // Not implemented
-        else if (by_type)
+
+        auto tt = Maps::getTileType(plant.pos);
+        if (by_type)
         {
             if (options.dead && !plant.damage_flags.bits.dead && tt && tileSpecial(*tt) != tiletype_special::DEAD)
                 continue; // Not removing living
@@ -507,17 +515,16 @@ command_result df_removeplant(color_ostream &out, const cuboid &bounds, const pl
 
         if (!options.dry_run)
         {
-            if (!uncat_plant(&plant))
-                out.printerr("Remove plant: No block column at ({}, {})!\n", plant.pos.x, plant.pos.y);
-
             if (!bad_tt) // TODO: trees
                 set_tt(plant.pos);
 
-            vec.erase(vec.begin() + i);
-            delete &plant;
+            victims.insert(&plant);
         }
     }
 
+    if (!victims.empty())
+        remove_plants(victims);
+
     out.print("Plants{} removed: {} ({} bad)\n", options.dry_run ? " that would be" : "", count, count_bad);
     return CR_OK;
 }
@@ -67,6 +67,7 @@ enum ConfigValues {
 
 static const int32_t CYCLE_TICKS = 109;
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 5);
 
 static command_result do_command(color_ostream &out, vector<string> &parameters);
 static void on_new_active_unit(color_ostream& out, void* data);
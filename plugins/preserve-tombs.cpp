@@ -25,6 +25,7 @@ static PersistentDataItem config;
 
 static int32_t cycle_timestamp;
 static constexpr int32_t CYCLE_TICKS = 107;
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 5);
 
 enum ConfigValues {
     CONFIG_IS_ENABLED = 0,
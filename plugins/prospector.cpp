@@ -27,11 +27,13 @@
 #include "df/viewscreen_choose_start_sitest.h"
 #include "df/plant.h"
 #include "df/plant_raw.h"
+#include "df/block_square_event_mineralst.h"
 
 #include <iostream>
 #include <iomanip>
 #include <map>
 #include <algorithm>
+#include <climits>
 #include <functional>
 #include <vector>
 
@@ -68,6 +70,18 @@ struct prospect_options {
     bool shrubs = true;
     bool trees = true;
 
+    // discard cached block data and rescan the whole requested area
+    bool rescan = false;
+
+    // inclusive bounds of the area to scan, in map tile coordinates.
+    // clipped to the map size.
+    int32_t min_x = 0;
+    int32_t min_y = 0;
+    int32_t min_z = 0;
+    int32_t max_x = INT_MAX;
+    int32_t max_y = INT_MAX;
+    int32_t max_z = INT_MAX;
+
     static struct_identity _identity;
 };
 static const struct_field_info prospect_options_fields[] = {
@@ -84,6 +98,13 @@ static const struct_field_info prospect_options_fields[] = {
     { struct_field_info::PRIMITIVE, "veins",    offsetof(prospect_options, veins),    &df::identity_traits<bool>::identity, 0, 0 },
     { struct_field_info::PRIMITIVE, "shrubs",   offsetof(prospect_options, shrubs),   &df::identity_traits<bool>::identity, 0, 0 },
     { struct_field_info::PRIMITIVE, "trees",    offsetof(prospect_options, trees),    &df::identity_traits<bool>::identity, 0, 0 },
+    { struct_field_info::PRIMITIVE, "rescan",   offsetof(prospect_options, rescan),   &df::identity_traits<bool>::identity, 0, 0 },
+    { struct_field_info::PRIMITIVE, "min_x",    offsetof(prospect_options, min_x),    &df::identity_traits<int32_t>::identity, 0, 0 },
+    { struct_field_info::PRIMITIVE, "min_y",    offsetof(prospect_options, min_y),    &df::identity_traits<int32_t>::identity, 0, 0 },
+    { struct_field_info::PRIMITIVE, "min_z",    offsetof(prospect_options, min_z),    &df::identity_traits<int32_t>::identity, 0, 0 },
+    { struct_field_info::PRIMITIVE, "max_x",    offsetof(prospect_options, max_x),    &df::identity_traits<int32_t>::identity, 0, 0 },
+    { struct_field_info::PRIMITIVE, "max_y",    offsetof(prospect_options, max_y),    &df::identity_traits<int32_t>::identity, 0, 0 },
+    { struct_field_info::PRIMITIVE, "max_z",    offsetof(prospect_options, max_z),    &df::identity_traits<int32_t>::identity, 0, 0 },
     { struct_field_info::END }
 };
 struct_identity prospect_options::_identity(sizeof(prospect_options), &df::allocator_fn<prospect_options>, NULL, "prospect_options", NULL, prospect_options_fields);
@@ -269,8 +290,18 @@ DFhackCExport command_result plugin_init ( color_ostream &out, std::vector <Plug
     return CR_OK;
 }
 
+static void clear_block_cache();
+
 DFhackCExport command_result plugin_shutdown ( color_ostream &out )
 {
+    clear_block_cache();
+    return CR_OK;
+}
+
+DFhackCExport command_result plugin_onstatechange(color_ostream &out, state_change_event event)
+{
+    if (event == SC_MAP_UNLOADED)
+        clear_block_cache();
     return CR_OK;
 }
 
@@ -623,6 +654,232 @@ static command_result embark_prospector(color_ostream &out,
     return CR_OK;
 }
 
+// Per-block material histogram. Each map block covers a single z-level, so
+// counts are kept without elevation info and the z is applied when merging.
+typedef std::map<int16_t, uint32_t> MatCounts;
+
+struct BlockStats
+{
+    MatCounts baseMats;
+    MatCounts layerMats;
+    MatCounts veinMats;
+    uint32_t liquidWater = 0;
+    uint32_t liquidMagma = 0;
+    uint32_t aquiferTiles = 0;
+    uint32_t tubeTiles = 0;
+    bool hasDemonTemple = false;
+    bool hasLair = false;
+};
+
+struct CachedBlock
+{
+    bool valid = false;
+    uint64_t fingerprint = 0;
+    // stats for every tile and for only the unhidden tiles
+    BlockStats all;
+    BlockStats visible;
+};
+
+// Indexed by block position; reset when the map is unloaded or changes size.
+static std::vector<CachedBlock> block_cache;
+static df::map_block ****cached_block_index = NULL;
+static uint32_t cached_x_max = 0, cached_y_max = 0, cached_z_max = 0;
+
+static void clear_block_cache()
+{
+    block_cache.clear();
+    block_cache.shrink_to_fit();
+    cached_block_index = NULL;
+}
+
+static size_t block_cache_idx(uint32_t b_x, uint32_t b_y, uint32_t z)
+{
+    return (size_t(z) * cached_y_max + b_y) * cached_x_max + b_x;
+}
+
+static uint64_t hash_mix(uint64_t h, uint64_t val)
+{
+    h ^= val;
+    h *= 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+}
+
+// Hashes just the block state that the histogram depends on, so unrelated
+// changes (dig designations, units and items moving) don't invalidate it.
+static uint64_t block_fingerprint(df::map_block *block)
+{
+    df::tile_designation des_mask;
+    des_mask.whole = 0;
+    des_mask.bits.hidden = true;
+    des_mask.bits.flow_size = 7;
+    des_mask.bits.liquid_type = true;
+    des_mask.bits.water_table = true;
+    des_mask.bits.feature_local = true;
+    des_mask.bits.feature_global = true;
+
+    uint64_t h = hash_mix(0, block->global_feature);
+    h = hash_mix(h, block->local_feature);
+    for (int x = 0; x < 16; x++)
+    {
+        uint64_t lair_bits = 0;
+        for (int y = 0; y < 16; y++)
+        {
+            h = hash_mix(h, (uint64_t(block->tiletype[x][y]) << 32) | (block->designation[x][y].whole & des_mask.whole));
+            if (block->occupancy[x][y].bits.monster_lair)
+                lair_bits |= 1 << y;
+        }
+        h = hash_mix(h, lair_bits);
+    }
+
+    for (auto ev : block->block_events)
+    {
+        if (ev->getType() != block_square_event_type::mineral)
+            continue;
+        auto mineral = (df::block_square_event_mineralst *)ev;
+        h = hash_mix(h, mineral->inorganic_mat);
+        for (int y = 0; y < 16; y++)
+            h = hash_mix(h, mineral->tile_bitmask.bits[y]);
+    }
+
+    return h;
+}
+
+// Accumulates tile stats for the given (inclusive) tile range of the block.
+static void scan_block(MapExtras::Block *b, int x1, int y1, int x2, int y2,
+                       BlockStats &all, BlockStats &visible)
+{
+    DFHack::t_feature blockFeatureGlobal;
+    DFHack::t_feature blockFeatureLocal;
+
+    // Find features
+    b->GetGlobalFeature(&blockFeatureGlobal);
+    b->GetLocalFeature(&blockFeatureLocal);
+
+    // Iterate over the tiles in the block
+    for(int y = y1; y <= y2; y++)
+    {
+        for(int x = x1; x <= x2; x++)
+        {
+            df::coord2d coord(x, y);
+            df::tile_designation des = b->DesignationAt(coord);
+            df::tile_occupancy occ = b->OccupancyAt(coord);
+
+            // Hidden tiles are only counted in the full stats
+            for (BlockStats *stats : { &all, &visible })
+            {
+                if (stats == &visible && des.bits.hidden)
+                    continue;
+
+                // Check for aquifer
+                if (des.bits.water_table)
+                    stats->aquiferTiles++;
+
+                // Check for lairs
+                if (occ.bits.monster_lair)
+                    stats->hasLair = true;
+
+                // Check for liquid
+                if (des.bits.flow_size)
+                {
+                    if (des.bits.liquid_type == tile_liquid::Magma)
+                        stats->liquidMagma++;
+                    else
+                        stats->liquidWater++;
+                }
+
+                df::tiletype type = b->tiletypeAt(coord);
+                df::tiletype_shape tileshape = tileShape(type);
+                df::tiletype_material tilemat = tileMaterial(type);
+
+                // We only care about these types
+                switch (tileshape)
+                {
+                case tiletype_shape::WALL:
+                case tiletype_shape::FORTIFICATION:
+                    break;
+                case tiletype_shape::EMPTY:
+                    /* A heuristic: tubes inside adamantine have EMPTY:AIR tiles which
+                       still have feature_local set. Also check the unrevealed status,
+                       so as to exclude any holes mined by the player. */
+                    if (tilemat == tiletype_material::AIR &&
+                        des.bits.feature_local && des.bits.hidden &&
+                        blockFeatureLocal.type == feature_type::deep_special_tube)
+                    {
+                        stats->tubeTiles++;
+                    }
+                default:
+                    continue;
+                }
+
+                // Count the material type
+                stats->baseMats[tilemat]++;
+
+                // Find the type of the tile
+                switch (tilemat)
+                {
+                case tiletype_material::SOIL:
+                case tiletype_material::STONE:
+                    stats->layerMats[b->layerMaterialAt(coord)]++;
+                    break;
+                case tiletype_material::MINERAL:
+                    stats->veinMats[b->veinMaterialAt(coord)]++;
+                    break;
+                case tiletype_material::FEATURE:
+                    if (blockFeatureLocal.type != -1 && des.bits.feature_local)
+                    {
+                        if (blockFeatureLocal.type == feature_type::deep_special_tube
+                                && blockFeatureLocal.main_material == 0) // stone
+                        {
+                            stats->veinMats[blockFeatureLocal.sub_material]++;
+                        }
+                        else if (blockFeatureLocal.type == feature_type::deep_surface_portal)
+                        {
+                            stats->hasDemonTemple = true;
+                        }
+                    }
+
+                    if (blockFeatureGlobal.type != -1 && des.bits.feature_global
+                            && blockFeatureGlobal.type == feature_type::underworld_from_layer
+                            && blockFeatureGlobal.main_material == 0) // stone
+                    {
+                        stats->layerMats[blockFeatureGlobal.sub_material]++;
+                    }
+                    break;
+                case tiletype_material::LAVA_STONE:
+                    // TODO ?
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void merge_counts(MatMap &dest, const MatCounts &src, int global_z)
+{
+    for (auto &entry : src)
+        dest[entry.first].add(global_z, entry.second);
+}
+
+static void merge_count(matdata &dest, uint32_t count, int global_z)
+{
+    if (count)
+        dest.add(global_z, count);
+}
+
+// A block that intersects the scan area. Blocks that are fully covered are
+// served from (and stored into) the cache; partially covered blocks are
+// scanned into the local stats each time.
+struct BlockWork
+{
+    uint32_t b_x, b_y, z;
+    int x1, y1, x2, y2;
+    bool full;
+    BlockStats all;
+    BlockStats visible;
+};
+
 static command_result map_prospector(color_ostream &con,
                                      const prospect_options &options) {
     if (!Maps::IsValid())
@@ -633,12 +890,85 @@ static command_result map_prospector(color_ostream &con,
 
     uint32_t x_max = 0, y_max = 0, z_max = 0;
     Maps::getSize(x_max, y_max, z_max);
-    MapExtras::MapCache map;
+
+    if (options.rescan || cached_block_index != world->map.block_index ||
+        cached_x_max != x_max || cached_y_max != y_max || cached_z_max != z_max)
+    {
+        clear_block_cache();
+        cached_block_index = world->map.block_index;
+        cached_x_max = x_max;
+        cached_y_max = y_max;
+        cached_z_max = z_max;
+        block_cache.resize(size_t(x_max) * y_max * z_max);
+    }
+
+    int min_x = std::max(0, options.min_x), max_x = std::min<int>(x_max*16 - 1, options.max_x);
+    int min_y = std::max(0, options.min_y), max_y = std::min<int>(y_max*16 - 1, options.max_y);
+    int min_z = std::max(0, options.min_z), max_z = std::min<int>(z_max - 1, options.max_z);
 
     DFHack::Materials *mats = Core::getInstance().getMaterials();
 
-    DFHack::t_feature blockFeatureGlobal;
-    DFHack::t_feature blockFeatureLocal;
+    // Collect the blocks that intersect the scan area
+    std::vector<BlockWork> work;
+    for (int z = min_z; z <= max_z; z++)
+    {
+        for (int b_y = min_y / 16; b_y <= max_y / 16; b_y++)
+        {
+            for (int b_x = min_x / 16; b_x <= max_x / 16; b_x++)
+            {
+                if (!Maps::getBlock(b_x, b_y, z))
+                    continue;
+                BlockWork &item = work.emplace_back();
+                item.b_x = b_x;
+                item.b_y = b_y;
+                item.z = z;
+                item.x1 = std::max(0, min_x - b_x*16);
+                item.y1 = std::max(0, min_y - b_y*16);
+                item.x2 = std::min(15, max_x - b_x*16);
+                item.y2 = std::min(15, max_y - b_y*16);
+                item.full = item.x1 == 0 && item.y1 == 0 && item.x2 == 15 && item.y2 == 15;
+            }
+        }
+    }
+
+    // Check fingerprints and scan stale blocks in parallel. The core is
+    // suspended for the duration, so the map is only being read. Each chunk
+    // of blocks gets its own MapCache since MapCache is not thread-safe.
+    size_t num_chunks = std::min<size_t>(work.size(), std::max(1u, std::thread::hardware_concurrency()));
+    parallel_for(num_chunks, [&](size_t chunk) {
+        MapExtras::MapCache map;
+        for (size_t i = chunk; i < work.size(); i += num_chunks)
+        {
+            BlockWork &item = work[i];
+            CachedBlock *cached = NULL;
+            if (item.full)
+            {
+                cached = &block_cache[block_cache_idx(item.b_x, item.b_y, item.z)];
+                uint64_t fingerprint = block_fingerprint(Maps::getBlock(item.b_x, item.b_y, item.z));
+                if (cached->valid && cached->fingerprint == fingerprint)
+                    continue;
+                cached->valid = false;
+                cached->fingerprint = fingerprint;
+                cached->all = BlockStats();
+                cached->visible = BlockStats();
+            }
+
+            MapExtras::Block *b = map.BlockAt(DFHack::DFCoord(item.b_x, item.b_y, item.z));
+            if (!b || !b->is_valid())
+                continue;
+
+            if (cached)
+            {
+                scan_block(b, 0, 0, 15, 15, cached->all, cached->visible);
+                cached->valid = true;
+            }
+            else
+                scan_block(b, item.x1, item.y1, item.x2, item.y2, item.all, item.visible);
+
+            // Clean uneeded memory
+            map.trash();
+        }
+    });
 
     bool hasDemonTemple = false;
     bool hasLair = false;
@@ -653,162 +983,67 @@ static command_result map_prospector(color_ostream &con,
     matdata aquiferTiles;
     matdata tubeTiles;
 
-    for(uint32_t z = 0; z < z_max; z++)
+    for (auto &item : work)
     {
+        const BlockStats *stats;
+        if (item.full)
+        {
+            auto &cached = block_cache[block_cache_idx(item.b_x, item.b_y, item.z)];
+            if (!cached.valid)
+                continue;
+            stats = options.hidden ? &cached.all : &cached.visible;
+        }
+        else
+            stats = options.hidden ? &item.all : &item.visible;
+
         // the '- 100' is because DF v50 and later have a 100 offset in reported elevation
-        int global_z = world->map.region_z + z - 100;
+        int global_z = world->map.region_z + item.z - 100;
+
+        merge_counts(baseMats, stats->baseMats, global_z);
+        merge_counts(layerMats, stats->layerMats, global_z);
+        merge_counts(veinMats, stats->veinMats, global_z);
+        merge_count(liquidWater, stats->liquidWater, global_z);
+        merge_count(liquidMagma, stats->liquidMagma, global_z);
+        merge_count(aquiferTiles, stats->aquiferTiles, global_z);
+        merge_count(tubeTiles, stats->tubeTiles, global_z);
+        hasDemonTemple = hasDemonTemple || stats->hasDemonTemple;
+        hasLair = hasLair || stats->hasLair;
+    }
 
-        for(uint32_t b_y = 0; b_y < y_max; b_y++)
+    // Check plants this way, as the other way wasn't getting them all
+    // and we can check visibility more easily here
+    if (options.shrubs || options.trees)
+    {
+        // plants are listed in the column at the northwest block of their
+        // 3x3 block (48x48 tile) region, so visit each of those columns once
+        for (int b_y = (min_y / 48) * 3; b_y <= max_y / 16; b_y += 3)
         {
-            for(uint32_t b_x = 0; b_x < x_max; b_x++)
+            for (int b_x = (min_x / 48) * 3; b_x <= max_x / 16; b_x += 3)
             {
-                // Get the map block
-                df::coord2d blockCoord(b_x, b_y);
-                MapExtras::Block *b = map.BlockAt(DFHack::DFCoord(b_x, b_y, z));
-                if (!b || !b->is_valid())
-                {
+                auto column = Maps::getBlockColumn(b_x, b_y);
+                if (!column)
                     continue;
-                }
-
-                // Find features
-                b->GetGlobalFeature(&blockFeatureGlobal);
-                b->GetLocalFeature(&blockFeatureLocal);
-
-                // Iterate over all the tiles in the block
-                for(uint32_t y = 0; y < 16; y++)
+                for (auto plant : column->plants)
                 {
-                    for(uint32_t x = 0; x < 16; x++)
+                    const df::coord &pos = plant->pos;
+                    if (pos.x < min_x || pos.x > max_x || pos.y < min_y || pos.y > max_y ||
+                            pos.z < min_z || pos.z > max_z)
+                        continue;
+                    if (!options.hidden)
                     {
-                        df::coord2d coord(x, y);
-                        df::tile_designation des = b->DesignationAt(coord);
-                        df::tile_occupancy occ = b->OccupancyAt(coord);
-
-                        // Skip hidden tiles
-                        if (!options.hidden && des.bits.hidden)
-                        {
-                            continue;
-                        }
-
-                        // Check for aquifer
-                        if (des.bits.water_table)
-                        {
-                            aquiferTiles.add(global_z);
-                        }
-
-                        // Check for lairs
-                        if (occ.bits.monster_lair)
-                        {
-                            hasLair = true;
-                        }
-
-                        // Check for liquid
-                        if (des.bits.flow_size)
-                        {
-                            if (des.bits.liquid_type == tile_liquid::Magma)
-                                liquidMagma.add(global_z);
-                            else
-                                liquidWater.add(global_z);
-                        }
-
-                        df::tiletype type = b->tiletypeAt(coord);
-                        df::tiletype_shape tileshape = tileShape(type);
-                        df::tiletype_material tilemat = tileMaterial(type);
-
-                        // We only care about these types
-                        switch (tileshape)
-                        {
-                        case tiletype_shape::WALL:
-                        case tiletype_shape::FORTIFICATION:
-                            break;
-                        case tiletype_shape::EMPTY:
-                            /* A heuristic: tubes inside adamantine have EMPTY:AIR tiles which
-                               still have feature_local set. Also check the unrevealed status,
-                               so as to exclude any holes mined by the player. */
-                            if (tilemat == tiletype_material::AIR &&
-                                des.bits.feature_local && des.bits.hidden &&
-                                blockFeatureLocal.type == feature_type::deep_special_tube)
-                            {
-                                tubeTiles.add(global_z);
-                            }
-                        default:
+                        auto des = Maps::getTileDesignation(pos);
+                        if (!des || des->bits.hidden)
                             continue;
-                        }
-
-                        // Count the material type
-                        baseMats[tilemat].add(global_z);
-
-                        // Find the type of the tile
-                        switch (tilemat)
-                        {
-                        case tiletype_material::SOIL:
-                        case tiletype_material::STONE:
-                            layerMats[b->layerMaterialAt(coord)].add(global_z);
-                            break;
-                        case tiletype_material::MINERAL:
-                            veinMats[b->veinMaterialAt(coord)].add(global_z);
-                            break;
-                        case tiletype_material::FEATURE:
-                            if (blockFeatureLocal.type != -1 && des.bits.feature_local)
-                            {
-                                if (blockFeatureLocal.type == feature_type::deep_special_tube
-                                        && blockFeatureLocal.main_material == 0) // stone
-                                {
-                                    veinMats[blockFeatureLocal.sub_material].add(global_z);
-                                }
-                                else if (blockFeatureLocal.type == feature_type::deep_surface_portal)
-                                {
-                                    hasDemonTemple = true;
-                                }
-                            }
-
-                            if (blockFeatureGlobal.type != -1 && des.bits.feature_global
-                                    && blockFeatureGlobal.type == feature_type::underworld_from_layer
-                                    && blockFeatureGlobal.main_material == 0) // stone
-                            {
-                                layerMats[blockFeatureGlobal.sub_material].add(global_z);
-                            }
-                            break;
-                        case tiletype_material::LAVA_STONE:
-                            // TODO ?
-                            break;
-                        default:
-                            break;
-                        }
-                    }
-                }
-
-                // Check plants this way, as the other way wasn't getting them all
-                // and we can check visibility more easily here
-                if (options.shrubs)
-                {
-                    auto block = Maps::getBlockColumn(b_x,b_y);
-                    vector<df::plant *> *plants = block ? &block->plants : NULL;
-                    if(plants)
-                    {
-                        for (PlantList::const_iterator it = plants->begin(); it != plants->end(); it++)
-                        {
-                            const df::plant & plant = *(*it);
-                            if (uint32_t(plant.pos.z) != z)
-                                continue;
-                            df::coord2d loc(plant.pos.x, plant.pos.y);
-                            loc = loc % 16;
-                            if (options.hidden || !b->DesignationAt(loc).bits.hidden)
-                            {
-                                if (ENUM_ATTR(plant_type, is_shrub, plant.type))
-                                    plantMats[plant.material].add(global_z);
-                                else
-                                    treeMats[plant.material].add(global_z);
-                            }
-                        }
                     }
+                    int global_z = world->map.region_z + pos.z - 100;
+                    if (ENUM_ATTR(plant_type, is_shrub, plant->type))
+                        plantMats[plant->material].add(global_z);
+                    else
+                        treeMats[plant->material].add(global_z);
                 }
-                // Block end
-            } // block x
-
-            // Clean uneeded memory
-            map.trash();
-        } // block y
-    } // z
+            }
+        }
+    }
 
     MatMap::const_iterator it;
 
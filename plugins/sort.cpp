@@ -1,5 +1,6 @@
 #include <variant>
 #include <functional>
+#include <unordered_map>
 
 #include "Debug.h"
 #include "LuaTools.h"
@@ -132,19 +133,66 @@ static df::widget_unit_list * get_work_animal_assignment_unit_list() {
 // sorting logic
 //
 
-static bool sort_proxy(const item_or_unit &a, const item_or_unit &b) {
-    if (std::holds_alternative<df::item*>(a) || std::holds_alternative<df::item*>(b))
-        return true;
+// Sort keys are lists of numbers and strings, compared element by element.
+// Lua computes a key once per unit and the comparator works on the cached
+// keys, so sorting costs one Lua call per unit instead of one per comparison.
+// Cached keys are dropped when the game advances or the sort order changes.
+using sort_key = std::vector<std::variant<double, string>>;
 
-    bool ret = true;
+static std::unordered_map<int32_t, sort_key> sort_key_cache;
+static int32_t sort_key_cache_frame = -1;
+
+static void clear_sort_key_cache() {
+    sort_key_cache.clear();
+    sort_key_cache_frame = -1;
+}
+
+static const sort_key & get_sort_key(df::unit *unit) {
+    if (sort_key_cache_frame != world->frame_counter) {
+        sort_key_cache.clear();
+        sort_key_cache_frame = world->frame_counter;
+    }
+
+    auto it = sort_key_cache.find(unit->id);
+    if (it != sort_key_cache.end())
+        return it->second;
+
+    sort_key &key = sort_key_cache[unit->id];
     color_ostream &out = Core::getInstance().getConsole();
-    Lua::CallLuaModuleFunction(out, "plugins.sort", "do_sort",
-        std::make_tuple(std::get<df::unit*>(a), std::get<df::unit*>(b)),
+    Lua::CallLuaModuleFunction(out, "plugins.sort", "get_sort_key", std::make_tuple(unit),
         1, [&](lua_State *L){
-            ret = lua_toboolean(L, 1);
+            if (!lua_istable(L, -1))
+                return;
+            int len = lua_rawlen(L, -1);
+            key.reserve(len);
+            for (int i = 1; i <= len; ++i) {
+                lua_rawgeti(L, -1, i);
+                if (lua_type(L, -1) == LUA_TSTRING) {
+                    size_t str_len;
+                    const char *str = lua_tolstring(L, -1, &str_len);
+                    key.emplace_back(string(str, str_len));
+                } else {
+                    key.emplace_back(lua_tonumber(L, -1));
+                }
+                lua_pop(L, 1);
+            }
         }
     );
-    return ret;
+    return key;
+}
+
+static bool sort_proxy(const item_or_unit &a, const item_or_unit &b) {
+    if (std::holds_alternative<df::item*>(a) || std::holds_alternative<df::item*>(b))
+        return true;
+
+    auto unit_a = std::get<df::unit*>(a);
+    auto unit_b = std::get<df::unit*>(b);
+    const sort_key &key_a = get_sort_key(unit_a);
+    const sort_key &key_b = get_sort_key(unit_b);
+    if (key_a != key_b)
+        return key_a < key_b;
+    // keep the order stable between refreshes
+    return unit_a->id < unit_b->id;
 }
 
 static sort_entry do_sort{
@@ -187,7 +235,15 @@ static void remove_sort_function(color_ostream &out, const char *which, df::widg
     }
 }
 
+DFhackCExport command_result plugin_onstatechange(color_ostream &out, state_change_event event) {
+    if (event == SC_WORLD_UNLOADED)
+        clear_sort_key_cache();
+    return CR_OK;
+}
+
 DFhackCExport command_result plugin_shutdown(color_ostream &out) {
+    clear_sort_key_cache();
+
     if (auto unitlist = get_squad_unit_list()) {
         remove_filter_function(out, do_squad_filter, "squad", unitlist);
         remove_sort_function(out, "squad", unitlist);
@@ -249,6 +305,7 @@ static void sort_set_sort_fn(color_ostream &out) {
     if (!unitlist)
         return;
     DEBUG(log).print("adding squad sort function\n");
+    clear_sort_key_cache();
     std::vector<sort_entry> *sorting_by = reinterpret_cast<std::vector<sort_entry> *>(&unitlist->sorting_by);
     sorting_by->clear();
     sorting_by->emplace_back(do_sort);
@@ -23,6 +23,7 @@
 
 #include <bitset>
 #include <functional>
+#include <optional>
 #include <ranges>
 #include <sstream>
 #include <string>
@@ -620,9 +621,77 @@ private:
         return false;
     }
 
+    // Results of the expensive checks, which only look at the tiles within
+    // two tiles of the building. They are kept between refreshes, so after a
+    // job event only the jobs around the changed tiles have to be checked
+    // again.
+    struct JobChecks {
+        bool unsupported = false;
+        bool risk_blocking = false;
+    };
+    std::unordered_map<int,JobChecks> job_checks;
+    bool job_checks_prevent_blocking = true;
+    vector<coord> changed_tiles;
+    // above this many changes, checking everything again is cheaper
+    static constexpr size_t max_changed_tiles = 64;
+
+    // reasons that depend on state no job event reports: water flow,
+    // buildingplan, and item reservations. these are cheap, so they are
+    // checked on every refresh.
+    std::optional<Reason> checkExternal(df::job* job) {
+        if (Maps::getTileDesignation(job->pos)->bits.flow_size > 1)
+            return Reason::UNDER_WATER;
+        else if (isBuildingPlanJob(job))
+            return Reason::BUILDINGPLAN;
+        else if (isOnUnmovableItem(job))
+            return Reason::ITEM_IN_JOB;
+        return std::nullopt;
+    }
+
+    JobChecks runChecks(color_ostream &out, df::job* job) {
+        JobChecks checks;
+        checks.unsupported = constructionIsUnsupported(out, job);
+        if (prevent_blocking)
+            checks.risk_blocking = riskBlocking(out, job);
+        return checks;
+    }
+
+    // the reason to suspend a job without external reasons, given the results
+    // of its expensive checks. designations can change without a job event,
+    // so they are checked every time.
+    std::optional<Reason> getReason(df::job* job, const JobChecks &checks) {
+        if (checks.risk_blocking)
+            return Reason::RISK_BLOCKING;
+
+        // protect (unprocessed) designations
+        if (prevent_blocking) {
+            auto building = Job::getHolder(job);
+            if (building && buildingOnDesignation(building))
+                return Reason::ERASE_DESIGNATION;
+        }
+
+        if (checks.unsupported)
+            return Reason::UNSUPPORTED;
+        return std::nullopt;
+    }
+
+    // whether any changed tile is close enough to the job to affect runChecks
+    bool isNearChange(df::job* job) {
+        int x1 = job->pos.x, x2 = job->pos.x, y1 = job->pos.y, y2 = job->pos.y, z = job->pos.z;
+        if (auto building = Job::getHolder(job)) {
+            x1 = building->x1, x2 = building->x2, y1 = building->y1, y2 = building->y2, z = building->z;
+        }
+        return std::ranges::any_of(changed_tiles, [&](const coord &pos) {
+            return pos.x >= x1 - 2 && pos.x <= x2 + 2 &&
+                   pos.y >= y1 - 2 && pos.y <= y2 + 2 &&
+                   pos.z >= z - 1 && pos.z <= z + 1;
+        });
+    }
+
     std::unordered_map<int,Reason> suspensions;
     std::unordered_set<int> leadsToDeadend;
     size_t num_suspend = 0, num_unsuspend = 0;
+    size_t num_checked = 0, num_constructions = 0;
 
 public:
     bool prevent_blocking = true;
@@ -638,6 +707,7 @@ public:
         std::stringstream res;
         res << "suspended " << num_suspend << " and unsuspended " << num_unsuspend <<  " jobs\n";
         res << "maintaining " << suspensions.size() << " suspension reasons\n";
+        res << "checked " << num_checked << " of " << num_constructions << " construction jobs\n";
         for (auto stat : stats) {
             res << std::setw(5) << stat.second << "x " << reasonToString(stat.first) << std::endl;
         }
@@ -645,12 +715,30 @@ public:
         return res.str();
     }
 
-    void refresh(color_ostream &out)
+    // note a tile whose change may affect the suspension reasons of the jobs around it
+    void markChanged(coord pos) {
+        if (changed_tiles.size() <= max_changed_tiles)
+            changed_tiles.push_back(pos);
+    }
+
+    // if incremental, only the jobs that are new or near a tile passed to
+    // markChanged go through the expensive checks again. the cheap checks and
+    // dead ends, which can span whole corridors, are always done again.
+    void refresh(color_ostream &out, bool incremental = false)
     {
-        DEBUG(cycle,out).print("starting refresh, prevent blocking is {}\n",
+        DEBUG(cycle,out).print("starting {} refresh, prevent blocking is {}\n",
+                               incremental ? "incremental" : "full",
                                prevent_blocking ? "true" : "false");
+        if (!incremental || changed_tiles.size() > max_changed_tiles ||
+                prevent_blocking != job_checks_prevent_blocking) {
+            job_checks.clear();
+            job_checks_prevent_blocking = prevent_blocking;
+        }
         suspensions.clear();
         leadsToDeadend.clear();
+        num_checked = num_constructions = 0;
+
+        std::unordered_map<int,JobChecks> checks;
 
         for (auto job : df::global::world->jobs.list) {
 
@@ -663,45 +751,37 @@ public:
             // may suspend other jobs, must always be called
             if (prevent_blocking) suspendDeadend(out, job);
 
-            if (suspensions.contains(job->id))
-                continue; // we already have a reason to suspend this job
-
-            // external reasons
-            if (Maps::getTileDesignation(job->pos)->bits.flow_size > 1) {
-                suspensions[job->id]=Reason::UNDER_WATER;
-                continue;
-            } else if (isBuildingPlanJob(job)) {
-                suspensions[job->id]=Reason::BUILDINGPLAN;
-                continue;
-            } else if (isOnUnmovableItem(job)) {
-                suspensions[job->id]=Reason::ITEM_IN_JOB;
-                continue;
-            }
-
-            if (constructionIsUnsupported(out, job))
-                suspensions[job->id]=Reason::UNSUPPORTED;
-
-            if (!prevent_blocking) continue;
-
-            if (riskBlocking(out, job)) {
-                suspensions[job->id]=Reason::RISK_BLOCKING;
-                continue;
+            ++num_constructions;
+            std::optional<Reason> reason = checkExternal(job);
+            if (!reason) {
+                auto known = job_checks.find(job->id);
+                if (known != job_checks.end() && !isNearChange(job)) {
+                    reason = getReason(job, checks[job->id] = known->second);
+                } else if (suspensions.contains(job->id)) {
+                    continue; // we already have a reason to suspend this job
+                } else {
+                    reason = getReason(job, checks[job->id] = runChecks(out, job));
+                    ++num_checked;
+                }
             }
 
-            // protect (unprocessed) designations
-            auto building = Job::getHolder(job);
-            if (building && buildingOnDesignation(building))
-                suspensions[job->id]=Reason::ERASE_DESIGNATION;
+            // dead ends found while tracing from other jobs take precedence
+            if (reason && !suspensions.contains(job->id))
+                suspensions[job->id] = *reason;
         }
-        DEBUG(cycle,out).print("finished refresh: found {} reasons for suspension\n",suspensions.size());
+
+        job_checks = std::move(checks);
+        changed_tiles.clear();
+        DEBUG(cycle,out).print("finished refresh: checked {} of {} construction jobs, found {} reasons for suspension\n",
+                               num_checked, num_constructions, suspensions.size());
     }
 
-    void do_cycle (color_ostream &out, bool unsuspend_everything = false)
+    void do_cycle (color_ostream &out, bool unsuspend_everything = false, bool incremental = false)
     {
         if (unsuspend_everything){
             suspensions.clear();
         } else {
-            refresh(out);
+            refresh(out, incremental);
         }
         num_suspend = 0, num_unsuspend = 0;
 
@@ -768,7 +848,7 @@ std::unique_ptr<EventManager::EventHandler> eventhandler_instance;
 
 static command_result do_command(color_ostream &out, vector<string> &parameters);
 static command_result do_unsuspend_command(color_ostream &out, vector<string> &parameters);
-static void do_cycle(color_ostream &out);
+static void do_cycle(color_ostream &out, bool incremental = false);
 static void jobCompletedHandler(color_ostream& out, void* ptr);
 
 DFhackCExport command_result plugin_init(color_ostream &out, std::vector <PluginCommand> &commands) {
@@ -863,8 +943,10 @@ DFhackCExport command_result plugin_onstatechange(color_ostream &out, state_chan
 }
 
 DFhackCExport command_result plugin_onupdate(color_ostream &out) {
-    if (cycle_needed || world->frame_counter - cycle_timestamp >= CYCLE_TICKS)
+    if (world->frame_counter - cycle_timestamp >= CYCLE_TICKS)
         do_cycle(out);
+    else if (cycle_needed)
+        do_cycle(out, true);
     return CR_OK;
 }
 
@@ -924,6 +1006,7 @@ static void jobCompletedHandler(color_ostream& out, void* ptr) {
     df::job* job = static_cast<df::job*>(ptr);
     if (SuspendManager::isConstructionJob(job)) {
         DEBUG(cycle,out).print("construction job initiated/completed (tick: {})\n", world->frame_counter);
+        suspendmanager_instance->markChanged(job->pos);
         cycle_needed = true;
     }
 
@@ -933,14 +1016,16 @@ static void jobCompletedHandler(color_ostream& out, void* ptr) {
 // cycle logic
 //
 
-static void do_cycle(color_ostream &out) {
-    // mark that we have recently run
-    cycle_timestamp = world->frame_counter;
+static void do_cycle(color_ostream &out, bool incremental) {
+    // mark that we have recently run; incremental cycles only catch up on job
+    // events, so they don't postpone the next full cycle
+    if (!incremental)
+        cycle_timestamp = world->frame_counter;
     cycle_needed = false;
 
     DEBUG(cycle,out).print("running {} cycle\n", plugin_name);
 
-    suspendmanager_instance->do_cycle(out);
+    suspendmanager_instance->do_cycle(out, false, incremental);
 }
 
 
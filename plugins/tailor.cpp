@@ -75,6 +75,7 @@ enum Config2Values
 
 static const int32_t CYCLE_TICKS = 1231; // one day
 static int32_t cycle_timestamp = 0;  // world->frame_counter at last cycle
+DFHACK_PLUGIN_UPDATE_CADENCE(cycle_timestamp, CYCLE_TICKS, 10);
 
 // ah, if only STL had a bimap
 static const std::map<df::job_type, df::item_type> jobTypeMap = {
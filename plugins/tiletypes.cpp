@@ -22,9 +22,12 @@
 #include <cstdlib>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <queue>
 #include <set>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 using std::vector;
@@ -791,6 +794,22 @@ bool processTileType(color_ostream & out, TileType &paint, std::vector<std::stri
     return found;
 }
 
+// findTileType() scans the whole tiletype table, which is too slow to do for
+// every tile of a large paint job. the answer only depends on its arguments.
+static df::tiletype findTileTypeCached(df::tiletype_shape shape, df::tiletype_material material,
+        df::tiletype_variant variant, df::tiletype_special special, DFHack::TileDirection direction) {
+    static std::unordered_map<uint64_t, df::tiletype> cache;
+    uint64_t key = (uint64_t(uint8_t(shape + 1)) << 56) | (uint64_t(uint8_t(material + 1)) << 48)
+        | (uint64_t(uint8_t(variant + 1)) << 40) | (uint64_t(uint8_t(special + 1)) << 32)
+        | direction.whole;
+    auto it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+    df::tiletype type = DFHack::findTileType(shape, material, variant, special, direction);
+    cache.emplace(key, type);
+    return type;
+}
+
 static bool paintTileProcessing(MapExtras::Block* block, const df::coord2d& blockPos, const TileType& target) {
     df::tiletype source = block->tiletypeAt(blockPos);
     df::tile_designation des = block->DesignationAt(blockPos);
@@ -840,7 +859,7 @@ static bool paintTileProcessing(MapExtras::Block* block, const df::coord2d& bloc
     if (!(material == tiletype_material::RIVER || shape == tiletype_shape::BROOK_BED || special == tiletype_special::TRACK || (shape == tiletype_shape::WALL && (material == tiletype_material::CONSTRUCTION || special == tiletype_special::SMOOTH))))
         direction.whole = 0;
 
-    df::tiletype type = DFHack::findTileType(shape, material, variant, special, direction);
+    df::tiletype type = findTileTypeCached(shape, material, variant, special, direction);
     // hack for empty space
     if (shape == tiletype_shape::EMPTY && material == tiletype_material::AIR && variant == tiletype_variant::VAR_1 && special == tiletype_special::NORMAL && direction.whole == 0)
         type = tiletype::OpenSpace;
@@ -925,39 +944,64 @@ static bool autocorrectTile(MapExtras::Block* botBlock, MapExtras::Block* topBlo
     topSpecial = topSpecial == tiletype_special::NONE ? botSpecial : topSpecial;
     botSpecial = botSpecial == tiletype_special::NONE ? tiletype_special::NORMAL : botSpecial;
 
-    int topLikeness = 0;
-
-    for (df::tiletype tt = (df::enum_traits<df::tiletype>::first_item); DFHack::is_valid_enum_item(tt); tt = DFHack::next_enum_item(tt, false))
-    {
-        if (newTopShape != tileShape(tt))
-            continue;
-
-        int tempLikeness = 0;
-        tiletype_material::tiletype_material mat = tileMaterial(tt);
-        if (mat == topMat)
-            tempLikeness += 16;
-        else if (mat == botMat)
-            tempLikeness += 8;
-        else continue;
-
-        tiletype_variant::tiletype_variant variant = tileVariant(tt);
-        if (variant == topVariant)
-            tempLikeness += 2;
-        else if (variant == botVariant)
-            tempLikeness += 1;
-
-        tiletype_special::tiletype_special special = tileSpecial(tt);
-        if (special == topSpecial)
-            tempLikeness += 8;
-        else if (special == botSpecial)
-            tempLikeness += 4;
-
-        if (tempLikeness > topLikeness) {
-            topLikeness = tempLikeness;
-            tiletype.material = mat;
-            tiletype.variant = variant;
-            tiletype.special = special;
+    // the best match only depends on the shape and the properties of the two
+    // tiles, so remember it instead of scanning the tiletype table every time
+    struct Likeness {
+        tiletype_material::tiletype_material material = tiletype_material::NONE;
+        tiletype_variant::tiletype_variant variant = tiletype_variant::NONE;
+        tiletype_special::tiletype_special special = tiletype_special::NONE;
+        bool found = false;
+    };
+    static std::unordered_map<uint64_t, Likeness> likeness_cache;
+    uint64_t key = (uint64_t(uint8_t(newTopShape + 1)) << 48)
+        | (uint64_t(uint8_t(topMat + 1)) << 40) | (uint64_t(uint8_t(botMat + 1)) << 32)
+        | (uint64_t(uint8_t(topVariant + 1)) << 24) | (uint64_t(uint8_t(botVariant + 1)) << 16)
+        | (uint64_t(uint8_t(topSpecial + 1)) << 8) | uint64_t(uint8_t(botSpecial + 1));
+
+    auto cached = likeness_cache.find(key);
+    if (cached == likeness_cache.end()) {
+        Likeness best;
+        int topLikeness = 0;
+
+        for (df::tiletype tt = (df::enum_traits<df::tiletype>::first_item); DFHack::is_valid_enum_item(tt); tt = DFHack::next_enum_item(tt, false))
+        {
+            if (newTopShape != tileShape(tt))
+                continue;
+
+            int tempLikeness = 0;
+            tiletype_material::tiletype_material mat = tileMaterial(tt);
+            if (mat == topMat)
+                tempLikeness += 16;
+            else if (mat == botMat)
+                tempLikeness += 8;
+            else continue;
+
+            tiletype_variant::tiletype_variant variant = tileVariant(tt);
+            if (variant == topVariant)
+                tempLikeness += 2;
+            else if (variant == botVariant)
+                tempLikeness += 1;
+
+            tiletype_special::tiletype_special special = tileSpecial(tt);
+            if (special == topSpecial)
+                tempLikeness += 8;
+            else if (special == botSpecial)
+                tempLikeness += 4;
+
+            if (tempLikeness > topLikeness) {
+                topLikeness = tempLikeness;
+                best.material = mat;
+                best.variant = variant;
+                best.special = special;
+                best.found = true;
+            }
         }
+        cached = likeness_cache.emplace(key, best).first;
+    }
+    if (cached->second.found) {
+        tiletype.material = cached->second.material;
+        tiletype.variant = cached->second.variant;
+        tiletype.special = cached->second.special;
     }
     return paintTileProcessing(topBlock, blockPos, tiletype);
 }
@@ -1003,7 +1047,7 @@ static PaintResult paintArea(MapExtras::MapCache& map, const df::coord& pos1, co
 
     int totalAffectedCount = 0;
     int totalFilteredCount = 0;
-    coord_vec skipList = coord_vec();
+    auto skipList = std::make_shared<std::unordered_set<df::coord>>();
 
     // Loop through the affected blocks
     for (int16_t z = minPos.z; z <= maxPos.z; z++) {
@@ -1034,7 +1078,7 @@ static PaintResult paintArea(MapExtras::MapCache& map, const df::coord& pos1, co
 
                         if (!match.matches(source, des, occ, basemat)) {
                             totalFilteredCount++;
-                            skipList.push_back(df::coord(blockX + xOffset, blockY + yOffset, z));
+                            skipList->emplace(blockX + xOffset, blockY + yOffset, z);
                             continue;
                         }
 
@@ -1042,7 +1086,7 @@ static PaintResult paintArea(MapExtras::MapCache& map, const df::coord& pos1, co
                             totalAffectedCount++;
                         }
                         else {
-                            skipList.push_back(df::coord(blockX + xOffset, blockY + yOffset, z));
+                            skipList->emplace(blockX + xOffset, blockY + yOffset, z);
                             continue;
                         }
                     }
@@ -1056,8 +1100,8 @@ static PaintResult paintArea(MapExtras::MapCache& map, const df::coord& pos1, co
         .postWrite = [totalAffectedCount, skipList, target, pos1, pos2](MapExtras::MapCache& map) {
             if (totalAffectedCount > 0) {
                 auto filter = [skipList](df::coord pos, df::map_block* block) -> bool {
-                    // Returns true if 'pos' is in 'skipList'
-                    return skipList.end() == std::find_if(skipList.begin(), skipList.end(), [pos](df::coord p) { return p.x == pos.x && p.y == pos.y && p.z == pos.z; });
+                    // Returns true if 'pos' is not in 'skipList'
+                    return !skipList->contains(pos);
                 };
 
                 if (target.autocorrect > 0 && autocorrectArea(map, pos1, pos2, target))
@@ -1122,6 +1166,65 @@ static PaintResult paintTile(MapExtras::MapCache &map, const df::coord &pos,
     return PaintResult();
 }
 
+// paints scattered tiles (e.g. from a flood brush) a block at a time, and
+// does the follow-up work for all of them in a single pass after the write
+static PaintResult paintTiles(MapExtras::MapCache &map, const coord_vec &tiles,
+                              const TileType &target, const TileType &match = TileType()) {
+    auto painted = std::make_shared<coord_vec>();
+    forEachBrushBlock(map, tiles, [&](MapExtras::Block *block, const std::vector<df::coord2d> &offsets) {
+        df::coord bcoord = block->getCoord();
+        for (auto &offset : offsets) {
+            df::tiletype source = block->tiletypeAt(offset);
+            df::tile_designation des = block->DesignationAt(offset);
+            df::tile_occupancy occ = block->OccupancyAt(offset);
+
+            // Stone painting operates on the base layer
+            if (target.stone_material >= 0)
+                source = block->baseTiletypeAt(offset);
+
+            t_matpair basemat = block->baseMaterialAt(offset);
+
+            if (!match.matches(source, des, occ, basemat))
+                continue;
+
+            if (paintTileProcessing(block, offset, target))
+                painted->emplace_back(bcoord.x * 16 + offset.x, bcoord.y * 16 + offset.y, bcoord.z);
+        }
+    });
+
+    if (painted->empty())
+        return PaintResult();
+
+    return PaintResult{
+        .paintCount = int(painted->size()),
+        .postWrite = [target, painted](MapExtras::MapCache& map) {
+            if (target.autocorrect > 0) {
+                bool updated = false;
+                for (auto &pos : *painted) {
+                    MapExtras::Block* block = map.BlockAtTile(pos);
+                    MapExtras::Block* topBlock = map.BlockAtTile(df::coord(pos.x, pos.y, pos.z + 1));
+                    MapExtras::Block* belowBlock = map.BlockAtTile(df::coord(pos.x, pos.y, pos.z - 1));
+                    updated |= autocorrectTile(block, topBlock, df::coord2d(pos.x & 15, pos.y & 15), target);
+                    updated |= autocorrectTile(belowBlock, block, df::coord2d(pos.x & 15, pos.y & 15), target);
+                    block->enableBlockUpdates(true, true);
+                }
+                if (updated)
+                    map.WriteAll();
+            }
+
+            for (auto &pos : *painted) {
+                if (target.aquifer == 0)
+                    Maps::removeTileAquifer(pos);
+                else if (target.aquifer > 0)
+                    Maps::setTileAquifer(pos, target.aquifer == 2);
+            }
+
+            // force the game to recompute its walkability cache on the next tick
+            world->reindex_pathfinding = true;
+        }
+    };
+}
+
 command_result executePaintJob(color_ostream &out,
                                const tiletypes_options &opts)
 {
@@ -1184,14 +1287,10 @@ command_result executePaintJob(color_ostream &out,
             failures = all_tiles.size() - result.paintCount;
         }
         else {
-            for (coord_vec::iterator iter = all_tiles.begin(); iter != all_tiles.end(); ++iter)
-            {
-                PaintResult result = paintTile(map, *iter, paint, filter);
-                if (result.paintCount == 0)
-                    ++failures;
-                else
-                    paintResults.push_back(result);
-            }
+            PaintResult result = paintTiles(map, all_tiles, paint, filter);
+            failures = all_tiles.size() - result.paintCount;
+            if (result.paintCount > 0)
+                paintResults.push_back(result);
         }
     }
 
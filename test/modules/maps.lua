@@ -0,0 +1,78 @@
+config.target = 'core'
+config.mode = 'fortress'
+
+-- the cached group sets must agree with groups collected by a linear scan
+
+local function get_entrance_groups()
+    local groups = {}
+    local x_count, y_count = dfhack.maps.getTileSize()
+    local edge = df.global.plotinfo.map_edge
+    local num_tiles = math.min(#edge.surface_x, #edge.surface_y, #edge.surface_z)
+    for idx = 0, num_tiles - 1 do
+        local x, y, z = edge.surface_x[idx], edge.surface_y[idx], edge.surface_z[idx]
+        if x == 0 or y == 0 or x == x_count - 1 or y == y_count - 1 then
+            local group = dfhack.maps.getWalkableGroup(xyz2pos(x, y, z))
+            if group ~= 0 then groups[group] = true end
+        end
+    end
+    return groups
+end
+
+local function get_citizen_groups()
+    local groups = {}
+    for _, unit in ipairs(dfhack.units.getCitizens()) do
+        local group = dfhack.maps.getWalkableGroup(dfhack.units.getPosition(unit))
+        if group ~= 0 then groups[group] = true end
+    end
+    return groups
+end
+
+-- edge tiles, citizen positions, and a sparse grid over the whole map
+local function get_sample_positions()
+    local positions = {}
+    local edge = df.global.plotinfo.map_edge
+    for idx = 0, math.min(#edge.surface_x, #edge.surface_y, #edge.surface_z) - 1 do
+        table.insert(positions, xyz2pos(edge.surface_x[idx], edge.surface_y[idx], edge.surface_z[idx]))
+    end
+    for _, unit in ipairs(dfhack.units.getCitizens()) do
+        table.insert(positions, dfhack.units.getPosition(unit))
+    end
+    local x_count, y_count, z_count = dfhack.maps.getTileSize()
+    for z = 0, z_count - 1, 2 do
+        for y = 0, y_count - 1, 11 do
+            for x = 0, x_count - 1, 11 do
+                table.insert(positions, xyz2pos(x, y, z))
+            end
+        end
+    end
+    return positions
+end
+
+local function check_groups(groups, is_reachable)
+    local num_reachable = 0
+    for _, pos in ipairs(get_sample_positions()) do
+        local group = dfhack.maps.getWalkableGroup(pos)
+        local expected = group ~= 0 and groups[group] == true
+        if expected then num_reachable = num_reachable + 1 end
+        expect.eq(expected, is_reachable(pos), ('%d, %d, %d'):format(pos2xyz(pos)))
+    end
+    return num_reachable
+end
+
+function test.isReachableFromEntrance()
+    local num_reachable = check_groups(get_entrance_groups(),
+        dfhack.maps.isReachableFromEntrance)
+    -- CI test saves always have a way onto the map
+    expect.lt(0, num_reachable)
+end
+
+function test.isReachableByCitizens()
+    local num_reachable = check_groups(get_citizen_groups(),
+        dfhack.maps.isReachableByCitizens)
+    expect.lt(0, num_reachable)
+end
+
+function test.isReachable_unwalkable()
+    expect.false_(dfhack.maps.isReachableFromEntrance(xyz2pos(-30000, -30000, -30000)))
+    expect.false_(dfhack.maps.isReachableByCitizens(xyz2pos(-30000, -30000, -30000)))
+end
@@ -0,0 +1,69 @@
+config.target = 'core'
+config.mode = 'fortress'
+
+-- the token indexes must agree with a linear search, which returns the first
+-- of any duplicates
+
+local function first_indexes(vec, field)
+    local indexes = {}
+    for idx, obj in ipairs(vec) do
+        local token = obj[field]
+        if indexes[token] == nil then
+            indexes[token] = idx
+        end
+    end
+    return indexes
+end
+
+local function check_all(find, vec, field)
+    local indexes = first_indexes(vec, field)
+    for _, obj in ipairs(vec) do
+        local token = obj[field]
+        expect.eq(indexes[token], find(token), token)
+    end
+    expect.eq(-1, find('NOT_A_RAW_TOKEN'))
+    expect.eq(-1, find(''))
+end
+
+local raws = df.global.world.raws
+
+function test.findInorganic()
+    check_all(dfhack.raws.findInorganic, raws.inorganics.all, 'id')
+end
+
+function test.findPlant()
+    check_all(dfhack.raws.findPlant, raws.plants.all, 'id')
+end
+
+function test.findCreature()
+    check_all(dfhack.raws.findCreature, raws.creatures.all, 'creature_id')
+end
+
+function test.findCaste()
+    for idx, creature in ipairs(raws.creatures.all) do
+        check_all(function(token) return dfhack.raws.findCaste(idx, token) end,
+            creature.caste, 'caste_id')
+    end
+    expect.eq(-1, dfhack.raws.findCaste(-1, 'FEMALE'))
+    expect.eq(-1, dfhack.raws.findCaste(#raws.creatures.all, 'FEMALE'))
+end
+
+function test.findReaction()
+    check_all(dfhack.raws.findReaction, raws.reactions.reactions, 'code')
+end
+
+function test.findItemSubtype()
+    for item_type = df.item_type._first_item, df.item_type._last_item do
+        local indexes = {}
+        for subtype = 0, dfhack.items.getSubtypeCount(item_type) - 1 do
+            local def = dfhack.items.getSubtypeDef(item_type, subtype)
+            if def and indexes[def.id] == nil then
+                indexes[def.id] = subtype
+            end
+        end
+        for id, subtype in pairs(indexes) do
+            expect.eq(subtype, dfhack.raws.findItemSubtype(item_type, id), id)
+        end
+        expect.eq(-1, dfhack.raws.findItemSubtype(item_type, 'NOT_A_RAW_TOKEN'))
+    end
+end
@@ -0,0 +1,92 @@
+config.target = 'core'
+config.mode = 'fortress'
+
+-- translated names are cached by the content of the name, so any change to a
+-- name must show up in its translation
+
+local function get_named_unit()
+    for _, unit in ipairs(dfhack.units.getCitizens()) do
+        if unit.name.has_name then return unit end
+    end
+end
+
+local function check_translations(name, expected)
+    for _, in_english in ipairs{false, true} do
+        for _, only_last_part in ipairs{false, true} do
+            expect.eq(expected[in_english][only_last_part],
+                dfhack.translation.translateName(name, in_english, only_last_part))
+        end
+    end
+end
+
+local function get_translations(name)
+    local translations = {}
+    for _, in_english in ipairs{false, true} do
+        translations[in_english] = {}
+        for _, only_last_part in ipairs{false, true} do
+            translations[in_english][only_last_part] =
+                dfhack.translation.translateName(name, in_english, only_last_part)
+        end
+    end
+    return translations
+end
+
+function test.translateName_changed_name()
+    local unit = get_named_unit()
+    if not unit then return end
+    dfhack.with_temp_object(df.language_name:new(), function(name)
+        name:assign(unit.name)
+        local orig = get_translations(name)
+        check_translations(name, orig)
+
+        name.first_name = 'Testname'
+        expect.str_find('Testname', dfhack.translation.translateName(name))
+        expect.ne(orig[false][false], dfhack.translation.translateName(name))
+
+        name.first_name = unit.name.first_name
+        check_translations(name, orig)
+
+        name.nickname = 'Testnick'
+        expect.ne(orig[false][false], dfhack.translation.translateName(name))
+        name.nickname = unit.name.nickname
+        check_translations(name, orig)
+
+        name.words[0], name.words[1] = name.words[1], name.words[0]
+        name.parts_of_speech[0], name.parts_of_speech[1] =
+            name.parts_of_speech[1], name.parts_of_speech[0]
+        local swapped = dfhack.translation.translateName(name)
+        name:assign(unit.name)
+        check_translations(name, orig)
+        if unit.name.words[0] ~= unit.name.words[1] then
+            expect.ne(orig[false][false], swapped)
+        end
+    end)
+end
+
+function test.setNickname()
+    local unit = get_named_unit()
+    if not unit then return end
+    local orig_nick = unit.name.nickname
+    local orig = dfhack.translation.translateName(unit.name)
+    dfhack.with_finalize(
+        function() dfhack.units.setNickname(unit, orig_nick) end,
+        function()
+            dfhack.units.setNickname(unit, 'Testnick')
+            expect.str_find('Testnick', dfhack.translation.translateName(unit.name))
+            expect.str_find('Testnick', dfhack.units.getReadableName(unit))
+            dfhack.units.setNickname(unit, orig_nick)
+            expect.eq(orig, dfhack.translation.translateName(unit.name))
+        end)
+end
+
+function test.getReadableNames()
+    local units = dfhack.units.getCitizens()
+    for _, skip_english in ipairs{false, true} do
+        local names = dfhack.units.getReadableNames(units, skip_english)
+        expect.eq(#units, #names)
+        for i, unit in ipairs(units) do
+            expect.eq(dfhack.units.getReadableName(unit, skip_english), names[i])
+        end
+    end
+    expect.table_eq({}, dfhack.units.getReadableNames({}))
+end
@@ -0,0 +1,133 @@
+config.target = 'core'
+
+-- job.items is a vector of job_item_ref pointers, whose item pointer leads
+-- to an item with substructure, bitfield and enum fields. the second ref has
+-- a NULL item.
+local function with_job_items(fn)
+    dfhack.with_temp_object(df.job:new(), function(job)
+        dfhack.with_temp_object(df.item_barst:new(), function(item)
+            item.id = 12
+            item.pos = {x=1, y=2, z=3}
+            item.flags.forbid = true
+            dfhack.with_finalize(
+                function()
+                    for _, ref in ipairs(job.items) do ref:delete() end
+                    job.items:resize(0)
+                end,
+                function()
+                    job.items:insert('#', {new=true, item=item,
+                        role=df.job_role_type.Reagent, job_item_idx=5})
+                    job.items:insert('#', {new=true,
+                        role=df.job_role_type.Hauled, job_item_idx=7})
+                    fn(job, item)
+                end)
+        end)
+    end)
+end
+
+function test.primitive_field()
+    with_job_items(function(job)
+        local values, count = df.collect(job.items, 'job_item_idx')
+        expect.eq(count, 2)
+        expect.table_eq(values, {5, 7})
+    end)
+end
+
+function test.enum_field()
+    with_job_items(function(job)
+        local values, count = df.collect(job.items, 'role')
+        expect.eq(count, 2)
+        expect.table_eq(values, {df.job_role_type.Reagent, df.job_role_type.Hauled})
+    end)
+end
+
+function test.items_without_path()
+    dfhack.with_temp_object(df.unit:new(), function(unit)
+        for i = 0, #unit.relationship_ids - 1 do
+            unit.relationship_ids[i] = i * 10
+        end
+        local values, count = df.collect(unit.relationship_ids)
+        expect.eq(count, #unit.relationship_ids)
+        for i = 0, count - 1 do
+            expect.eq(values[i+1], unit.relationship_ids[i])
+        end
+    end)
+end
+
+function test.empty_container()
+    dfhack.with_temp_object(df.job:new(), function(job)
+        local values, count = df.collect(job.items, 'job_item_idx')
+        expect.eq(count, 0)
+        expect.table_eq(values, {})
+    end)
+end
+
+function test.through_pointer()
+    with_job_items(function(job)
+        local values, count = df.collect(job.items, 'item.id')
+        expect.eq(count, 2)
+        expect.eq(values[1], 12)
+        expect.nil_(values[2], 'NULL pointer should leave a hole')
+    end)
+end
+
+function test.substruct_through_pointer()
+    with_job_items(function(job)
+        local values, count = df.collect(job.items, 'item.pos.y')
+        expect.eq(count, 2)
+        expect.eq(values[1], 2)
+        expect.nil_(values[2])
+    end)
+end
+
+function test.bitfield_member()
+    with_job_items(function(job, item)
+        local values, count = df.collect(job.items, 'item.flags.forbid')
+        expect.eq(count, 2)
+        expect.eq(values[1], true)
+        expect.nil_(values[2])
+
+        item.flags.forbid = false
+        expect.eq(df.collect(job.items, 'item.flags.forbid')[1], false)
+    end)
+end
+
+function test.whole_bitfield()
+    with_job_items(function(job, item)
+        local values = df.collect(job.items, 'item.flags')
+        expect.eq(values[1], item.flags.whole)
+    end)
+end
+
+function test.usage_errors()
+    with_job_items(function(job)
+        expect.error_match('Usage: df%.collect', function() df.collect() end)
+        expect.error_match('Usage: df%.collect',
+            function() df.collect(job.items, 'id', 'extra') end)
+        expect.error_match('Usage: df%.collect', function() df.collect(job.items, {}) end)
+    end)
+end
+
+function test.type_errors()
+    with_job_items(function(job)
+        expect.error_match('Container expected', function() df.collect(job) end)
+        expect.error_match('Container expected',
+            function() df.collect(job.items[0], 'job_item_idx') end)
+        expect.error_match('Unknown field.*nonexistent',
+            function() df.collect(job.items, 'nonexistent') end)
+        expect.error_match('Unknown field.*nonexistent',
+            function() df.collect(job.items, 'item.nonexistent') end)
+        expect.error_match('Unknown bitfield member.*nonexistent',
+            function() df.collect(job.items, 'item.flags.nonexistent') end)
+        expect.error_match('Cannot index bitfield member',
+            function() df.collect(job.items, 'item.flags.forbid.x') end)
+        expect.error_match('Cannot index',
+            function() df.collect(job.items, 'job_item_idx.x') end)
+        expect.error_match('must end in a primitive',
+            function() df.collect(job.items) end)
+        expect.error_match('must end in a primitive',
+            function() df.collect(job.items, 'item') end)
+        expect.error_match('must end in a primitive',
+            function() df.collect(job.items, 'item.pos') end)
+    end)
+end
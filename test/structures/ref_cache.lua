@@ -0,0 +1,144 @@
+config.target = 'core'
+
+local utils = require('utils')
+
+local function with_ref_cache(enable, fn)
+    local prev = df.set_ref_cache(enable)
+    dfhack.with_finalize(function() df.set_ref_cache(prev) end, fn)
+end
+
+-- link.item points to job as a df.job, and link.next points to the same
+-- address as a df.job_list_link
+local function with_link(fn)
+    dfhack.with_temp_object(df.job_list_link:new(), function(link)
+        dfhack.with_temp_object(df.job:new(), function(job)
+            link.item = job
+            link.next = df.reinterpret_cast(df.job_list_link, job)
+            fn(link, job)
+        end)
+    end)
+end
+
+function test.set_ref_cache_returns_previous_state()
+    local prev = df.set_ref_cache(false)
+    dfhack.with_finalize(function() df.set_ref_cache(prev) end, function()
+        expect.false_(df.set_ref_cache(true))
+        expect.true_(df.set_ref_cache(true))
+        expect.true_(df.set_ref_cache(false))
+        expect.false_(df.set_ref_cache(false))
+    end)
+end
+
+function test.disabled_allocates_new_refs()
+    with_ref_cache(false, function()
+        with_link(function(link, job)
+            expect.false_(rawequal(link.item, link.item))
+            expect.eq(link.item, job)
+        end)
+    end)
+end
+
+function test.same_pointer_same_ref()
+    with_ref_cache(true, function()
+        with_link(function(link, job)
+            local ref = link.item
+            expect.true_(rawequal(ref, link.item))
+            expect.eq(ref, job)
+        end)
+    end)
+end
+
+function test.different_types_same_address()
+    with_ref_cache(true, function()
+        with_link(function(link, job)
+            local as_job = link.item
+            local as_link = link.next
+            expect.eq(utils.addressof(as_job), utils.addressof(as_link))
+            expect.false_(rawequal(as_job, as_link))
+            expect.true_(df.job:is_instance(as_job))
+            expect.true_(df.job_list_link:is_instance(as_link))
+
+            -- reading one type must not hand out the other's ref
+            expect.true_(df.job:is_instance(link.item))
+            expect.true_(df.job_list_link:is_instance(link.next))
+            expect.true_(df.job:is_instance(as_job))
+        end)
+    end)
+end
+
+-- a struct with a vector of unions tagged by a sibling vector
+local function find_tagged_union_vector()
+    for _, type in pairs(df) do
+        local ok, fields = pcall(function()
+            return (type._kind == 'struct-type' or type._kind == 'class-type') and type._fields
+        end)
+        if ok and fields then
+            for name, info in pairs(fields) do
+                -- mode 6 is struct_field_info::CONTAINER
+                if info.union_tag_field and info.mode == 6 and fields[info.union_tag_field] then
+                    return type, name, info.union_tag_field
+                end
+            end
+        end
+    end
+end
+
+local function get_active_member(ref)
+    for name in pairs(ref) do return name end
+end
+
+-- two tag values that select different union members
+local function find_two_tags(holder, data_field, tag_field)
+    local candidates = {}
+    if type(holder[tag_field][0]) == 'boolean' then
+        candidates = {false, true}
+    else
+        for value = -1, 255 do table.insert(candidates, value) end
+    end
+
+    local first_tag, first_name
+    for _, tag in ipairs(candidates) do
+        if pcall(function() holder[tag_field][0] = tag end) then
+            local name = get_active_member(holder[data_field][0])
+            if name and not first_name then
+                first_tag, first_name = tag, name
+            elseif name and name ~= first_name then
+                return first_tag, first_name, tag, name
+            end
+        end
+    end
+end
+
+function test.tagged_union_items_stay_distinct()
+    local struct_type, data_field, tag_field = find_tagged_union_vector()
+    expect.true_(struct_type, 'no struct with a tagged union vector found')
+    if not struct_type then return end
+
+    with_ref_cache(true, function()
+        dfhack.with_temp_object(struct_type:new(), function(h1)
+            dfhack.with_temp_object(struct_type:new(), function(h2)
+                for _, h in ipairs{h1, h2} do
+                    h[data_field]:resize(1)
+                    h[tag_field]:resize(1)
+                end
+                local tag1, name1, tag2, name2 = find_two_tags(h1, data_field, tag_field)
+                expect.true_(tag2 ~= nil, 'no two tags select different members')
+                if tag2 == nil then return end
+                h1[tag_field][0] = tag1
+                h2[tag_field][0] = tag2
+
+                local a = h1[data_field][0]
+                expect.eq(get_active_member(a), name1)
+                local b = h2[data_field][0]
+                expect.eq(get_active_member(b), name2)
+                local a2 = h1[data_field][0]
+                expect.false_(rawequal(a, a2))
+
+                -- reading the items again must not retag the refs already held
+                expect.eq(get_active_member(a), name1)
+                expect.eq(get_active_member(b), name2)
+                expect.eq(get_active_member(a2), name1)
+            end)
+        end)
+    end)
+end